@@ -1,42 +1,72 @@
 #include "jagspico/cd74hc595.h"
 
+#include <algorithm>
+
 #include "cd74hc595.pio.h"
 #include "hardware/clocks.h"
+#include "hardware/dma.h"
 #include "hardware/pio.h"
 #include "hardware/pio_instructions.h"
 #include "hardware/structs/clocks.h"
+#include "jagspico/shared_pio_program.h"
+#include "pico/platform.h"
 
 namespace jagspico {
 
+namespace {
+
+SharedPioProgram g_program(&cd74hc595_program);
+
+} // namespace
+
 Cd74Hc595DriverPio::Cd74Hc595DriverPio(Cd74Hc595DriverPio &&o)
     : pio_(o.pio_), state_machine_(o.state_machine_),
-      output_bits_(o.output_bits_) {
+      output_bits_(o.output_bits_), program_(o.program_),
+      dma_(std::move(o.dma_)) {
   o.pio_ = nullptr;
   o.state_machine_ = 5; // Invalid
 }
 Cd74Hc595DriverPio::~Cd74Hc595DriverPio() {
   if (!pio_)
     return;
+  if (dma_) {
+    StopDma();
+    dma_channel_unclaim(dma_->channels.data);
+    dma_channel_unclaim(dma_->channels.control);
+  }
   pio_sm_set_enabled(pio_, state_machine_, false);
   pio_sm_unclaim(pio_, state_machine_);
+  program_->Release(pio_);
 }
 
 std::optional<Cd74Hc595DriverPio>
 Cd74Hc595DriverPio::Create(const Config &config) {
+  return Create(config, g_program, cd74hc595_program_get_default_config);
+}
+
+std::optional<Cd74Hc595DriverPio>
+Cd74Hc595DriverPio::Create(const Config &config, SharedPioProgram &program,
+                           pio_sm_config (*default_config)(uint offset)) {
+  if (config.output_bits < 1)
+    return std::nullopt;
   const PIO pio = config.pio;
-  uint32_t sm = pio_claim_unused_sm(pio, true);
+  const std::optional<uint32_t> offset = program.Acquire(pio);
+  if (!offset)
+    return std::nullopt;
+  const int claimed = pio_claim_unused_sm(pio, false);
+  if (claimed < 0) {
+    program.Release(pio);
+    return std::nullopt;
+  }
+  const uint32_t sm = claimed;
   for (uint32_t pin :
        {config.pin_srclk, config.pin_srclk + 1, config.pin_ser}) {
     pio_gpio_init(pio, pin);
   }
-  if (!pio_can_add_program(pio, &cd74hc595_program)) {
-    panic("can't add cd74hc595 to PIO\n");
-  }
-  uint32_t offset = pio_add_program(pio, &cd74hc595_program);
 
   pio_sm_set_consecutive_pindirs(pio, sm, config.pin_srclk, 2, true);
   pio_sm_set_consecutive_pindirs(pio, sm, config.pin_ser, 1, true);
-  pio_sm_config sm_config = cd74hc595_program_get_default_config(offset);
+  pio_sm_config sm_config = default_config(*offset);
   sm_config_set_clkdiv(&sm_config,
                        static_cast<float>(clock_get_hz(clk_sys) * 1.0 /
                                           config.target_frequency));
@@ -44,12 +74,153 @@ Cd74Hc595DriverPio::Create(const Config &config) {
   sm_config_set_sideset_pins(&sm_config, config.pin_srclk);
 
   // We output the MSB first, so we are shifting left. This means that each
-  // input must be the highest 8 bits of the 32-bit word.
-  sm_config_set_out_shift(&sm_config, false, true, config.output_bits);
-  pio_sm_init(pio, sm, offset, &sm_config);
-  pio_sm_exec(pio, sm, pio_encode_set(pio_y, config.output_bits - 1));
+  // input must be the highest output_bits bits of the 32-bit word, or, for
+  // longer chains, that every word pulls all 32 bits.
+  sm_config_set_out_shift(&sm_config, false, true,
+                          cd74hc595_frame::PullThreshold(config.output_bits));
+  // Nothing is ever read back, so the TX FIFO can have all 8 entries.
+  sm_config_set_fifo_join(&sm_config, PIO_FIFO_JOIN_TX);
+  pio_sm_init(pio, sm, *offset, &sm_config);
+
+  // Y counts the bits of a frame, which may not fit in a SET's immediate, so
+  // load it through the FIFO. OUT empties the OSR, so the first frame's word
+  // is autopulled in its place.
+  pio_sm_put(pio, sm, cd74hc595_frame::ShiftBits(config.output_bits) - 1);
+  pio_sm_exec(pio, sm, pio_encode_pull(false, true));
+  pio_sm_exec(pio, sm, pio_encode_out(pio_y, 32));
   pio_sm_set_enabled(pio, sm, true);
-  return Cd74Hc595DriverPio(config, sm);
+  return Cd74Hc595DriverPio(config, sm, program);
+}
+
+size_t Cd74Hc595DriverPio::SendMany(std::span<const uint32_t> words) {
+  const uint32_t shift = 32 - cd74hc595_frame::PullThreshold(output_bits_);
+  // Checks the level once rather than once per word.
+  const size_t room = std::min<size_t>(
+      words.size(),
+      kTxFifoDepth - pio_sm_get_tx_fifo_level(pio_, state_machine_));
+  for (size_t i = 0; i < room; ++i)
+    pio_->txf[state_machine_] = words[i] << shift;
+  return room;
+}
+
+void Cd74Hc595DriverPio::SendFrames(std::span<const uint32_t> words) {
+  while (!words.empty())
+    words = words.subspan(SendMany(words));
+}
+
+bool Cd74Hc595DriverPio::EnableDma() {
+  if (dma_)
+    return true;
+  const int data = dma_claim_unused_channel(false);
+  if (data < 0)
+    return false;
+  const int control = dma_claim_unused_channel(false);
+  if (control < 0) {
+    dma_channel_unclaim(data);
+    return false;
+  }
+  dma_ = std::make_unique<DmaState>();
+  dma_->channels = {
+      .data = static_cast<uint32_t>(data),
+      .control = static_cast<uint32_t>(control),
+      .dreq = pio_get_dreq(pio_, state_machine_, true),
+  };
+  return true;
+}
+
+bool Cd74Hc595DriverPio::SendDma(
+    std::span<const std::span<const uint32_t>> segments) {
+  if (!dma_ || dma_busy() || segments.size() > kMaxDmaSegments)
+    return false;
+  cd74hc595_dma::Segment planned[kMaxDmaSegments];
+  for (size_t i = 0; i < segments.size(); ++i) {
+    planned[i] = {
+        .read_addr = reinterpret_cast<uintptr_t>(segments[i].data()),
+        .count = static_cast<uint32_t>(segments[i].size()),
+    };
+  }
+  const std::optional<cd74hc595_dma::Plan> plan = cd74hc595_dma::PlanOneShot(
+      std::span(planned, segments.size()), dma_->blocks, dma_->channels);
+  if (!plan)
+    return false;
+  StartDma(*plan);
+  return true;
+}
+
+bool Cd74Hc595DriverPio::StartDmaLoop(std::span<const uint32_t> buffer) {
+  if (!dma_ || dma_busy())
+    return false;
+  const std::optional<cd74hc595_dma::Plan> plan = cd74hc595_dma::PlanLoop(
+      {.read_addr = reinterpret_cast<uintptr_t>(buffer.data()),
+       .count = static_cast<uint32_t>(buffer.size())},
+      dma_->blocks, dma_->channels);
+  if (!plan)
+    return false;
+  StartDma(*plan);
+  return true;
+}
+
+void Cd74Hc595DriverPio::StartDma(const cd74hc595_dma::Plan &plan) {
+  const cd74hc595_dma::Channels &channels = dma_->channels;
+  dma_channel_config data_config = {.ctrl = plan.data_ctrl};
+  dma_channel_configure(channels.data, &data_config, &pio_->txf[state_machine_],
+                        nullptr, plan.data_transfer_count, false);
+
+  dma_channel_config control_config = {.ctrl = plan.control_ctrl};
+  dma_channel_configure(
+      channels.control, &control_config,
+      reinterpret_cast<uint8_t *>(dma_channel_hw_addr(channels.data)) +
+          plan.control_write_offset,
+      reinterpret_cast<const uint8_t *>(dma_->blocks) +
+          plan.control_read_offset,
+      plan.control_transfer_count, true);
+}
+
+bool Cd74Hc595DriverPio::SetDmaLoopBuffer(std::span<const uint32_t> buffer) {
+  if (!dma_ || buffer.size() != dma_->blocks[0].transfer_count)
+    return false;
+  // A single store, which the control channel sees either side of.
+  *const_cast<volatile uint32_t *>(&dma_->blocks[0].read_addr) =
+      reinterpret_cast<uintptr_t>(buffer.data());
+  return true;
+}
+
+bool Cd74Hc595DriverPio::DmaReading(std::span<const uint32_t> buffer) const {
+  if (!dma_busy())
+    return false;
+  const uintptr_t read = dma_channel_hw_addr(dma_->channels.data)->read_addr;
+  const uintptr_t begin = reinterpret_cast<uintptr_t>(buffer.data());
+  return read >= begin && read < begin + buffer.size_bytes();
+}
+
+void Cd74Hc595DriverPio::WaitWhileDmaReading(std::span<const uint32_t> buffer,
+                                             void (*wait)()) const {
+  while (DmaReading(buffer)) {
+    if (wait)
+      wait();
+    else
+      tight_loop_contents();
+  }
+}
+
+void Cd74Hc595DriverPio::StopDma() {
+  if (!dma_)
+    return;
+  const cd74hc595_dma::Channels &channels = dma_->channels;
+  // Aborting the data channel mid-transfer may still chain to the control
+  // channel (RP2040-E13), so first make it chain to itself, which does not
+  // chain at all.
+  dma_channel_hw_t *data = dma_channel_hw_addr(channels.data);
+  data->al1_ctrl = (data->al1_ctrl & ~DMA_CH0_CTRL_TRIG_CHAIN_TO_BITS) |
+                   (channels.data << DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB);
+  dma_channel_abort(channels.control);
+  dma_channel_abort(channels.data);
+  dma_channel_abort(channels.control);
+}
+
+bool Cd74Hc595DriverPio::dma_busy() const {
+  return dma_ && (dma_channel_is_busy(dma_->channels.data) ||
+                  dma_channel_is_busy(dma_->channels.control));
 }
 
 } // namespace jagspico
\ No newline at end of file
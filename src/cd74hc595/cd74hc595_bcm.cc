@@ -0,0 +1,54 @@
+#include "jagspico/cd74hc595_bcm.h"
+
+#include <utility>
+#include <vector>
+
+#include "cd74hc595_bcm.pio.h"
+#include "hardware/pio.h"
+#include "jagspico/shared_pio_program.h"
+
+namespace jagspico {
+
+namespace {
+
+SharedPioProgram g_bcm_program(&cd74hc595_bcm_program);
+
+} // namespace
+
+Cd74Hc595Bcm::Cd74Hc595Bcm(Cd74Hc595DriverPio driver, const Config &config)
+    : loop_(cd74hc595_bcm::BufferWords(config.driver.output_bits,
+                                       config.depth)),
+      driver_(std::move(driver)), output_bits_(config.driver.output_bits),
+      depth_(config.depth), frequency_(config.driver.target_frequency),
+      wait_(config.wait) {}
+
+std::optional<Cd74Hc595Bcm> Cd74Hc595Bcm::Create(const Config &config) {
+  if (config.depth < cd74hc595_bcm::kMinDepth ||
+      config.depth > cd74hc595_bcm::kMaxDepth)
+    return std::nullopt;
+  std::optional<Cd74Hc595DriverPio> driver = Cd74Hc595DriverPio::Create(
+      config.driver, g_bcm_program, cd74hc595_bcm_program_get_default_config);
+  if (!driver || !driver->EnableDma())
+    return std::nullopt;
+
+  Cd74Hc595Bcm bcm(std::move(*driver), config);
+  const std::vector<uint8_t> off(bcm.output_bits_, 0);
+  cd74hc595_bcm::Fill(bcm.output_bits_, bcm.depth_, off, bcm.loop_.front());
+  bcm.driver_.StartDmaLoop(bcm.loop_.front());
+  return bcm;
+}
+
+bool Cd74Hc595Bcm::Set(std::span<const uint8_t> intensities) {
+  if (!cd74hc595_bcm::Fill(output_bits_, depth_, intensities,
+                           loop_.Back(driver_, wait_)))
+    return false;
+  loop_.Swap(driver_);
+  return true;
+}
+
+float Cd74Hc595Bcm::refresh_hz() const {
+  return static_cast<float>(frequency_) /
+         cd74hc595_bcm::RefreshCycles(output_bits_, depth_);
+}
+
+} // namespace jagspico
@@ -0,0 +1,121 @@
+// Runs cd74hc595_bcm.pio on piosim with a buffer from
+// cd74hc595_bcm::Fill, fed over and over as DMA would, and checks that each
+// output of the modelled chain is on for exactly its intensity's share of a
+// refresh. Build with PICO_PLATFORM=host.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "cd74hc595_bcm.pio.h"
+#include "jagspico/cd74hc595_bcm_planes.h"
+#include "jagspico/cd74hc595_frame.h"
+#include "piosim/cd74hc595_chain.h"
+#include "piosim/state_machine.h"
+
+namespace bcm = jagspico::cd74hc595_bcm;
+namespace frame = jagspico::cd74hc595_frame;
+
+namespace {
+
+void Fail(const char* what, int bits, int depth, uint32_t got,
+          uint32_t want) {
+  printf("FAIL: %s (%d bits, depth %d): got %u want %u\n", what, bits, depth,
+         got, want);
+  abort();
+}
+
+constexpr int kPinSrclk = 0;
+constexpr int kPinSer = 2;
+
+// pio_encode_pull(false, true) and pio_encode_out(pio_y, 32).
+constexpr uint16_t kPullBlock = 0x80a0;
+constexpr uint16_t kOutY32 = 0x6040;
+
+uint32_t Random() {
+  static uint32_t state = 54321;
+  state = state * 1664525 + 1013904223;
+  return state >> 8;
+}
+
+void TestIntensities(int output_bits, int depth) {
+  std::vector<uint8_t> intensities(output_bits);
+  for (uint8_t& intensity : intensities) intensity = Random();
+  // Fully off and fully on, whatever the rest are.
+  intensities[0] = 0;
+  intensities[output_bits - 1] = 0xff;
+
+  std::vector<uint32_t> buffer(bcm::BufferWords(output_bits, depth));
+  if (!bcm::Fill(output_bits, depth, intensities, buffer)) {
+    Fail("fill", output_bits, depth, 0, 1);
+  }
+
+  piosim::StateMachine sm({
+      .program = cd74hc595_bcm_program_instructions,
+      .wrap_target = cd74hc595_bcm_wrap_target,
+      .wrap = cd74hc595_bcm_wrap,
+      .sideset_count = 2,
+      .sideset_base = kPinSrclk,
+      .out_base = kPinSer,
+      .out_count = 1,
+      .out_shift_right = false,
+      .autopull = true,
+      .pull_threshold = frame::PullThreshold(output_bits),
+      .join_tx = true,
+  });
+  sm.Put(frame::ShiftBits(output_bits) - 1);
+  sm.Exec(kPullBlock);
+  sm.Exec(kOutY32);
+
+  piosim::Cd74Hc595Chain chain(output_bits, kPinSrclk, kPinSer);
+  size_t next = 0;
+  const uint32_t refresh = bcm::RefreshCycles(output_bits, depth);
+  std::vector<uint32_t> on(output_bits);
+  int latches = 0;
+  // Lets the first refresh settle, then measures the next.
+  for (uint32_t cycle = 0; cycle < 3 * refresh; ++cycle) {
+    while (sm.Put(buffer[next])) next = (next + 1) % buffer.size();
+    sm.Step();
+    if (sm.stalled()) Fail("stalled", output_bits, depth, cycle, 0);
+    chain.Clock(sm.pins());
+    if (cycle < 2 * refresh) {
+      latches = chain.latches;
+      continue;
+    }
+    for (int k = 0; k < output_bits; ++k) on[k] += chain.storage[k];
+  }
+
+  if (chain.latches - latches != depth) {
+    Fail("planes per refresh", output_bits, depth, chain.latches - latches,
+         depth);
+  }
+  const uint32_t max = (1u << depth) - 1;
+  for (int k = 0; k < output_bits; ++k) {
+    const uint32_t want =
+        (intensities[k] & max) * bcm::PlaneCycles(output_bits);
+    if (on[k] != want) Fail("on cycles", output_bits, depth, on[k], want);
+  }
+}
+
+void TestFillRejects() {
+  std::vector<uint8_t> intensities(8);
+  std::vector<uint32_t> buffer(bcm::BufferWords(8, 4));
+  if (bcm::Fill(8, 4, std::span(intensities).first(7), buffer) ||
+      bcm::Fill(8, 5, intensities, buffer)) {
+    Fail("fill rejects", 8, 4, 1, 0);
+  }
+}
+
+}  // namespace
+
+int main() {
+  for (int output_bits : {8, 24, 32, 40, 64, 128}) {
+    for (int depth = bcm::kMinDepth; depth <= bcm::kMaxDepth; ++depth) {
+      TestIntensities(output_bits, depth);
+    }
+  }
+  TestFillRejects();
+  printf("PASS\n");
+  return 0;
+}
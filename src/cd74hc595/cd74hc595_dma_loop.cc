@@ -0,0 +1,20 @@
+#include "jagspico/cd74hc595_dma_loop.h"
+
+namespace jagspico {
+
+Cd74Hc595DmaLoop::Cd74Hc595DmaLoop(size_t words)
+    : buffers_{std::vector<uint32_t>(words), std::vector<uint32_t>(words)} {}
+
+std::span<uint32_t> Cd74Hc595DmaLoop::Back(const Cd74Hc595DriverPio &driver,
+                                           void (*wait)()) {
+  std::span<uint32_t> back = buffers_[1 - front_];
+  driver.WaitWhileDmaReading(back, wait);
+  return back;
+}
+
+void Cd74Hc595DmaLoop::Swap(Cd74Hc595DriverPio &driver) {
+  driver.SetDmaLoopBuffer(buffers_[1 - front_]);
+  front_ = 1 - front_;
+}
+
+} // namespace jagspico
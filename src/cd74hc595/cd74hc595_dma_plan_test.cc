@@ -0,0 +1,216 @@
+// Checks the register values of Cd74Hc595DriverPio's DMA mode by running
+// them through a model of the two channels, which follows the RP2040
+// datasheet closely enough to catch a wrong offset, ring or chain. Build
+// with PICO_PLATFORM=host.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "jagspico/cd74hc595_dma_plan.h"
+
+namespace dma = jagspico::cd74hc595_dma;
+
+namespace {
+
+void Fail(const char* what, uint32_t got, uint32_t want) {
+  printf("FAIL: %s: got %u want %u\n", what, got, want);
+  abort();
+}
+
+void Expect(const char* what, uint32_t got, uint32_t want) {
+  if (got != want) Fail(what, got, want);
+}
+
+constexpr dma::Channels kChannels = {.data = 2, .control = 3, .dreq = 9};
+
+// Addresses in the model's memory, which is words from 0.
+constexpr uint32_t kBlocksAddr = 0x100;
+constexpr uint32_t kDataRegsAddr = 0x200;
+
+uint32_t Field(uint32_t ctrl, int shift, uint32_t mask) {
+  return (ctrl >> shift) & mask;
+}
+
+struct Channel {
+  uint32_t ctrl = 0;
+  uint32_t read = 0;
+  uint32_t write = 0;
+  uint32_t count = 0;
+  uint32_t reload = 0;
+  bool busy = false;
+
+  void Advance() {
+    if (ctrl & dma::ctrl::kIncrRead) read += 4;
+    if (ctrl & dma::ctrl::kIncrWrite) {
+      const uint32_t ring = Field(ctrl, dma::ctrl::kRingSizeShift, 0xf);
+      const uint32_t mask =
+          (ctrl & dma::ctrl::kRingSelWrite) && ring > 0 ? (1u << ring) - 1
+                                                        : ~0u;
+      write = (write & ~mask) | ((write + 4) & mask);
+    }
+  }
+  void Trigger() {
+    count = reload;
+    busy = true;
+  }
+};
+
+// Runs the plan until the data channel stops or max_words have been sent,
+// and returns the words that reached the TX FIFO.
+std::vector<uint32_t> Run(
+    const dma::Plan& plan, std::vector<uint32_t>& memory, size_t max_words) {
+  Channel data{.ctrl = plan.data_ctrl, .reload = plan.data_transfer_count};
+  Channel control{
+      .ctrl = plan.control_ctrl,
+      .read = kBlocksAddr + plan.control_read_offset,
+      .write = kDataRegsAddr + plan.control_write_offset,
+      .reload = plan.control_transfer_count,
+  };
+  control.Trigger();
+
+  std::vector<uint32_t> sent;
+  while (sent.size() < max_words && (control.busy || data.busy)) {
+    if (control.busy) {
+      // The control channel has a permanent TREQ and so runs to completion.
+      Expect("control treq",
+             Field(control.ctrl, dma::ctrl::kTreqSelShift, 0x3f),
+             dma::ctrl::kTreqPermanent);
+      for (; control.count > 0; --control.count) {
+        const uint32_t value = memory[control.read / 4];
+        switch (control.write - kDataRegsAddr) {
+          case dma::kAl3TransCountOffset:
+            data.reload = value;
+            break;
+          case dma::kAl3ReadAddrTrigOffset:
+            data.read = value;
+            // A null trigger: the channel stays idle.
+            if (value != 0) data.Trigger();
+            break;
+          default:
+            Fail("control write offset", control.write - kDataRegsAddr, 0);
+        }
+        control.Advance();
+      }
+      control.busy = false;
+      Expect("control chain",
+             Field(control.ctrl, dma::ctrl::kChainToShift, 0xf),
+             kChannels.control);
+    }
+    if (data.busy) {
+      Expect("data treq", Field(data.ctrl, dma::ctrl::kTreqSelShift, 0x3f),
+             kChannels.dreq);
+      for (; data.count > 0 && sent.size() < max_words; --data.count) {
+        sent.push_back(memory[data.read / 4]);
+        data.Advance();
+      }
+      if (data.count > 0) break;
+      data.busy = false;
+      const uint32_t chain = Field(data.ctrl, dma::ctrl::kChainToShift, 0xf);
+      Expect("data chain", chain, kChannels.control);
+      control.Trigger();
+    }
+  }
+  return sent;
+}
+
+void CopyBlocks(std::span<const dma::Block> blocks,
+                std::vector<uint32_t>& memory) {
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    memory[kBlocksAddr / 4 + 2 * i] = blocks[i].transfer_count;
+    memory[kBlocksAddr / 4 + 2 * i + 1] = blocks[i].read_addr;
+  }
+}
+
+void TestDataCtrl() {
+  const uint32_t ctrl = dma::DataCtrl(kChannels);
+  Expect("data enabled", ctrl & dma::ctrl::kEn, dma::ctrl::kEn);
+  Expect("data size", Field(ctrl, 2, 0x3), 2);
+  Expect("data incr read", ctrl & dma::ctrl::kIncrRead, dma::ctrl::kIncrRead);
+  Expect("data incr write", ctrl & dma::ctrl::kIncrWrite, 0);
+  Expect("data quiet", ctrl & dma::ctrl::kIrqQuiet, dma::ctrl::kIrqQuiet);
+}
+
+void TestOneShot() {
+  std::vector<uint32_t> memory(0x100);
+  // Three segments, out of order in memory.
+  const dma::Segment segments[] = {
+      {.read_addr = 0x40, .count = 3},
+      {.read_addr = 0x10, .count = 1},
+      {.read_addr = 0x80, .count = 2},
+  };
+  const uint32_t want[] = {0xa0, 0xa1, 0xa2, 0xb0, 0xc0, 0xc1};
+  memory[0x40 / 4] = 0xa0;
+  memory[0x44 / 4] = 0xa1;
+  memory[0x48 / 4] = 0xa2;
+  memory[0x10 / 4] = 0xb0;
+  memory[0x80 / 4] = 0xc0;
+  memory[0x84 / 4] = 0xc1;
+
+  dma::Block blocks[4];
+  const std::optional<dma::Plan> plan =
+      dma::PlanOneShot(segments, blocks, kChannels);
+  if (!plan) Fail("one-shot plan", 0, 1);
+  Expect("one-shot blocks", plan->blocks, 4);
+  Expect("null block count", blocks[3].transfer_count, 0);
+  Expect("null block addr", blocks[3].read_addr, 0);
+  CopyBlocks(std::span(blocks, plan->blocks), memory);
+
+  const std::vector<uint32_t> sent = Run(*plan, memory, 100);
+  Expect("one-shot words", sent.size(), std::size(want));
+  for (size_t i = 0; i < sent.size(); ++i) {
+    Expect("one-shot word", sent[i], want[i]);
+  }
+}
+
+void TestOneShotRejects() {
+  dma::Block blocks[2];
+  const dma::Segment one[] = {{.read_addr = 0x10, .count = 1}};
+  const dma::Segment two[] = {
+      {.read_addr = 0x10, .count = 1}, {.read_addr = 0x20, .count = 1}};
+  const dma::Segment empty[] = {{.read_addr = 0x10, .count = 0}};
+  Expect("no segments",
+         dma::PlanOneShot({}, blocks, kChannels).has_value(), false);
+  Expect("empty segment",
+         dma::PlanOneShot(empty, blocks, kChannels).has_value(), false);
+  Expect("no room for null block",
+         dma::PlanOneShot(two, blocks, kChannels).has_value(), false);
+  Expect("fits", dma::PlanOneShot(one, blocks, kChannels).has_value(), true);
+}
+
+void TestLoop() {
+  std::vector<uint32_t> memory(0x100);
+  for (uint32_t i = 0; i < 4; ++i) memory[0x20 / 4 + i] = 0xd0 + i;
+
+  dma::Block blocks[1];
+  const std::optional<dma::Plan> plan =
+      dma::PlanLoop({.read_addr = 0x20, .count = 4}, blocks, kChannels);
+  if (!plan) Fail("loop plan", 0, 1);
+  CopyBlocks(std::span(blocks, plan->blocks), memory);
+
+  // Keeps going, wrapping around the buffer, until the model gives up.
+  const std::vector<uint32_t> sent = Run(*plan, memory, 4 * 5 + 2);
+  Expect("loop words", sent.size(), 4 * 5 + 2);
+  for (size_t i = 0; i < sent.size(); ++i) {
+    Expect("loop word", sent[i], 0xd0 + i % 4);
+  }
+
+  Expect("empty loop",
+         dma::PlanLoop({.read_addr = 0x20, .count = 0}, blocks, kChannels)
+             .has_value(),
+         false);
+}
+
+}  // namespace
+
+int main() {
+  TestDataCtrl();
+  TestOneShot();
+  TestOneShotRejects();
+  TestLoop();
+  printf("PASS\n");
+  return 0;
+}
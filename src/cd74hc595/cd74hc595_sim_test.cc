@@ -0,0 +1,119 @@
+// Runs cd74hc595.pio on piosim, set up the way Cd74Hc595DriverPio sets up
+// the state machine, and clocks its pins into a model of a chain of
+// Cd74Hc595s. Checks that every output of chains of up to 16 chips ends up
+// with the right bit, and that rclk pulses once per frame, however the
+// frame's words trickle in. Build with PICO_PLATFORM=host.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "cd74hc595.pio.h"
+#include "jagspico/cd74hc595_frame.h"
+#include "piosim/cd74hc595_chain.h"
+#include "piosim/state_machine.h"
+
+namespace frame = jagspico::cd74hc595_frame;
+
+namespace {
+
+void Fail(const char* what, int bits, uint32_t got, uint32_t want) {
+  printf("FAIL: %s (%d bits): got %u want %u\n", what, bits, got, want);
+  abort();
+}
+
+constexpr int kPinSrclk = 0;
+constexpr int kPinSer = 2;
+
+// pio_encode_pull(false, true) and pio_encode_out(pio_y, 32), which the
+// host build has no header for.
+constexpr uint16_t kPullBlock = 0x80a0;
+constexpr uint16_t kOutY32 = 0x6040;
+
+uint32_t Random() {
+  static uint32_t state = 12345;
+  state = state * 1664525 + 1013904223;
+  return state;
+}
+
+// Sends frames of random words to a chain of output_bits, waiting gap
+// cycles before each word, and checks each frame as it is latched.
+void TestChain(int output_bits, int gap) {
+  constexpr int kFrames = 5;
+  const int words_per_frame = frame::Words(output_bits);
+  std::vector<uint32_t> words(kFrames * words_per_frame);
+  for (uint32_t& word : words) word = Random();
+
+  piosim::StateMachine sm({
+      .program = cd74hc595_program_instructions,
+      .wrap_target = cd74hc595_wrap_target,
+      .wrap = cd74hc595_wrap,
+      .sideset_count = 2,
+      .sideset_base = kPinSrclk,
+      .out_base = kPinSer,
+      .out_count = 1,
+      .out_shift_right = false,
+      .autopull = true,
+      .pull_threshold = frame::PullThreshold(output_bits),
+      .join_tx = true,
+  });
+  sm.Put(frame::ShiftBits(output_bits) - 1);
+  sm.Exec(kPullBlock);
+  sm.Exec(kOutY32);
+  if (sm.y() != static_cast<uint32_t>(frame::ShiftBits(output_bits) - 1)) {
+    Fail("y", output_bits, sm.y(), frame::ShiftBits(output_bits) - 1);
+  }
+
+  piosim::Cd74Hc595Chain chain(output_bits, kPinSrclk, kPinSer);
+  size_t sent = 0;
+  int wait = gap;
+  // The first latch happens as the program starts, before any frame.
+  for (int cycles = 0; chain.latches <= kFrames; ++cycles) {
+    if (cycles > 1'000'000) {
+      Fail("timeout", output_bits, chain.latches, kFrames);
+    }
+    if (sent < words.size() && --wait <= 0 &&
+        sm.Put(frame::Encode(output_bits, words[sent]))) {
+      ++sent;
+      wait = gap;
+    }
+    const int latches = chain.latches;
+    sm.Step();
+    chain.Clock(sm.pins());
+    if (chain.latches == latches || chain.latches == 1) continue;
+
+    // A frame was latched. Everything shifted since the previous latch
+    // belongs to it, padding included.
+    const int index = chain.latches - 2;
+    if (chain.shifts != (index + 1) * frame::ShiftBits(output_bits)) {
+      Fail("shifts", output_bits, chain.shifts,
+           (index + 1) * frame::ShiftBits(output_bits));
+    }
+    const uint32_t* frame_words = &words[index * words_per_frame];
+    for (int bit = 0; bit < output_bits; ++bit) {
+      const uint32_t word = frame_words[words_per_frame - 1 - bit / 32];
+      const bool want = word >> (bit % 32) & 1;
+      if (chain.storage[bit] != want) {
+        Fail("output", output_bits, bit, want);
+      }
+    }
+  }
+  if (sent != words.size()) Fail("sent", output_bits, sent, words.size());
+}
+
+}  // namespace
+
+int main() {
+  for (int chips : {1, 2, 3, 4, 5, 8, 12, 16}) {
+    TestChain(8 * chips, 0);
+    // A starved FIFO leaves the state machine waiting mid-frame.
+    TestChain(8 * chips, 100);
+  }
+  // Odd lengths, e.g. a chain with a few outputs unused.
+  TestChain(1, 0);
+  TestChain(33, 100);
+  TestChain(100, 0);
+  printf("PASS\n");
+  return 0;
+}
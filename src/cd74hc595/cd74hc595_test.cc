@@ -0,0 +1,90 @@
+#include "jagspico/cd74hc595.h"
+
+#include <iterator>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "FreeRTOS.h"
+#include "hardware/pio.h"
+#include "hardware/pio_instructions.h"
+#include "pico/platform.h"
+#include "pico/printf.h"
+#include "pico/time.h"
+#include "task.h"
+#include "util/expect.h"
+
+using jagspico::Cd74Hc595DriverPio;
+using jagspico::Expect;
+
+namespace {
+
+// Whether a program of n instructions would still fit in pio.
+bool Fits(PIO pio, int n) {
+  static uint16_t nops[32];
+  for (uint16_t &nop : nops)
+    nop = pio_encode_nop();
+  const pio_program_t program = {
+      .instructions = nops, .length = static_cast<uint8_t>(n), .origin = -1};
+  return pio_can_add_program(pio, &program);
+}
+
+Cd74Hc595DriverPio::Config ConfigFor(int pin, uint32_t frequency) {
+  return {
+      .pio = pio1,
+      .pin_srclk = pin,
+      .pin_ser = pin + 2,
+      .target_frequency = frequency,
+  };
+}
+
+void TestSharedProgram() {
+  Expect(Fits(pio1, 32), "pio1 starts empty");
+  {
+    std::vector<Cd74Hc595DriverPio> drivers;
+    for (int i = 0; i < 4; ++i) {
+      std::optional<Cd74Hc595DriverPio> driver =
+          Cd74Hc595DriverPio::Create(ConfigFor(10 + 3 * i, 1'000'000));
+      Expect(driver.has_value(), "driver created");
+      drivers.push_back(std::move(*driver));
+    }
+    // One three-instruction copy for all four.
+    Expect(Fits(pio1, 29), "program loaded once");
+    Expect(!Fits(pio1, 30), "program loaded");
+    Expect(!Cd74Hc595DriverPio::Create(ConfigFor(22, 1'000'000)),
+           "no fifth state machine");
+    Expect(Fits(pio1, 29), "failed create released the program");
+  }
+  Expect(Fits(pio1, 32), "program removed with the last driver");
+}
+
+void TestNonBlocking() {
+  // About 2 kHz, so that each frame takes several milliseconds.
+  std::optional<Cd74Hc595DriverPio> driver =
+      Cd74Hc595DriverPio::Create(ConfigFor(10, 2'000));
+  Expect(driver.has_value(), "driver created");
+
+  uint32_t words[20];
+  for (uint32_t i = 0; i < std::size(words); ++i)
+    words[i] = i;
+  const absolute_time_t start = get_absolute_time();
+  size_t sent = driver->SendMany(words);
+  Expect(sent == Cd74Hc595DriverPio::kTxFifoDepth, "fills the joined FIFO");
+  // The state machine may have pulled one word meanwhile.
+  sent += driver->SendMany(std::span(words).subspan(sent));
+  Expect(sent <= Cd74Hc595DriverPio::kTxFifoDepth + 1, "FIFO full");
+  Expect(absolute_time_diff_us(start, get_absolute_time()) < 1000,
+         "did not block");
+
+  vTaskDelay(pdMS_TO_TICKS(20));
+  Expect(driver->TrySend(0xff), "room again");
+}
+
+} // namespace
+
+extern "C" void main_task(void *) {
+  TestSharedProgram();
+  TestNonBlocking();
+  printf("PASS\n");
+  vTaskDelete(nullptr);
+}
@@ -0,0 +1,215 @@
+// Runs cd74hc595.pio on piosim at the system clock, through the clock
+// divider Cd74Hc595DriverPio sets for its target_frequency, and checks the
+// srclk, rclk and ser waveforms of a Send to the sys clock cycle: ser is
+// shifted out most significant bit first and is stable at every rising
+// edge of srclk, srclk runs at half the target frequency, and rclk rises
+// one state machine cycle after the frame's last bit. Build with
+// PICO_PLATFORM=host. Pass a file name to also write the first waveform as
+// a VCD file.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "cd74hc595.pio.h"
+#include "jagspico/cd74hc595_frame.h"
+#include "piosim/state_machine.h"
+#include "piosim/waveform.h"
+
+namespace frame = jagspico::cd74hc595_frame;
+
+namespace {
+
+void Fail(const char* what, uint32_t target, uint64_t got, uint64_t want) {
+  printf("FAIL: %s (%u Hz): got %llu want %llu\n", what, target,
+         static_cast<unsigned long long>(got),
+         static_cast<unsigned long long>(want));
+  abort();
+}
+
+void Expect(const char* what, uint32_t target, uint64_t got, uint64_t want) {
+  if (got != want) Fail(what, target, got, want);
+}
+
+// The default system clock, which the driver divides down.
+constexpr uint32_t kSysHz = 125'000'000;
+
+constexpr int kPinSrclk = 0;
+constexpr int kPinRclk = kPinSrclk + 1;
+constexpr int kPinSer = 2;
+
+// pio_encode_pull(false, true) and pio_encode_out(pio_y, 32), which the
+// host build has no header for.
+constexpr uint16_t kPullBlock = 0x80a0;
+constexpr uint16_t kOutY32 = 0x6040;
+
+const char* g_vcd_path = nullptr;
+
+// A state machine set up the way Cd74Hc595DriverPio::Create sets one up,
+// recording into waveform from before it starts.
+struct Harness {
+  Harness(int output_bits, uint32_t target_frequency)
+      : waveform((1u << kPinSrclk) | (1u << kPinRclk) | (1u << kPinSer)),
+        sm({
+            .program = cd74hc595_program_instructions,
+            .wrap_target = cd74hc595_wrap_target,
+            .wrap = cd74hc595_wrap,
+            .sideset_count = 2,
+            .sideset_base = kPinSrclk,
+            .out_base = kPinSer,
+            .out_count = 1,
+            .out_shift_right = false,
+            .autopull = true,
+            .pull_threshold = frame::PullThreshold(output_bits),
+            .join_tx = true,
+            // As computed by Create.
+            .clkdiv = static_cast<float>(kSysHz * 1.0 / target_frequency),
+        }) {
+    sm.Record(&waveform);
+    sm.Put(frame::ShiftBits(output_bits) - 1);
+    sm.Exec(kPullBlock);
+    sm.Exec(kOutY32);
+    // Lets the program start and stall for want of a frame.
+    while (sm.cycles() < 4) sm.Tick();
+  }
+
+  void Run(uint64_t sys_cycles) {
+    for (uint64_t i = 0; i < sys_cycles; ++i) sm.Tick();
+  }
+
+  piosim::Waveform waveform;
+  piosim::StateMachine sm;
+};
+
+void WriteVcd(const piosim::Waveform& waveform) {
+  if (g_vcd_path == nullptr) return;
+  FILE* file = fopen(g_vcd_path, "w");
+  if (file == nullptr) {
+    printf("FAIL: could not open %s\n", g_vcd_path);
+    abort();
+  }
+  const piosim::Waveform::Signal signals[] = {
+      {kPinSrclk, "srclk"}, {kPinRclk, "rclk"}, {kPinSer, "ser"}};
+  waveform.WriteVcd(file, signals, 1'000'000'000 / kSysHz);
+  fclose(file);
+  g_vcd_path = nullptr;
+}
+
+// Sends each of frames, as Send would, back to back, and checks the
+// waveform. The divider must be a whole number of sys clocks.
+void TestExact(int output_bits, uint32_t target_frequency,
+               const std::vector<std::vector<uint32_t>>& frames) {
+  const uint64_t period = kSysHz / target_frequency;
+  Expect("whole divider", target_frequency, kSysHz % target_frequency, 0);
+  Harness harness(output_bits, target_frequency);
+  for (const std::vector<uint32_t>& words : frames) {
+    for (uint32_t word : words) {
+      harness.sm.Put(frame::Encode(output_bits, word));
+    }
+  }
+  const int shift_bits = frame::ShiftBits(output_bits);
+  // Two state machine cycles per bit and one to latch, plus some slack.
+  harness.Run((frames.size() * (2 * shift_bits + 1) + 10) * period);
+  WriteVcd(harness.waveform);
+
+  const piosim::Waveform& waveform = harness.waveform;
+  const std::vector<uint64_t> srclk = waveform.Edges(kPinSrclk, true);
+  const std::vector<uint64_t> srclk_falls = waveform.Edges(kPinSrclk, false);
+  const std::vector<uint64_t> rclk = waveform.Edges(kPinRclk, true);
+  const std::vector<uint64_t> rclk_falls = waveform.Edges(kPinRclk, false);
+  // The program latches once as it starts, before any frame.
+  Expect("srclk rises", target_frequency, srclk.size(),
+         frames.size() * shift_bits);
+  Expect("rclk rises", target_frequency, rclk.size(), frames.size() + 1);
+  Expect("rclk falls", target_frequency, rclk_falls.size(), rclk.size());
+
+  for (size_t f = 0; f < frames.size(); ++f) {
+    const std::vector<uint32_t>& words = frames[f];
+    const size_t first = f * shift_bits;
+    for (int bit = 0; bit < shift_bits; ++bit) {
+      const size_t i = first + bit;
+      // srclk runs at half the state machine's frequency, high and low for
+      // a cycle each, without a gap between a frame's bits.
+      if (bit > 0) {
+        Expect("srclk period", target_frequency, srclk[i] - srclk[i - 1],
+               2 * period);
+      }
+      Expect("srclk high", target_frequency, srclk_falls[i] - srclk[i],
+             period);
+
+      // The bits go out of each word from the top, the first word first,
+      // and ser settles a state machine cycle before srclk rises.
+      const int word_bits = frame::PullThreshold(output_bits);
+      const uint32_t word = frame::Encode(output_bits, words[bit / word_bits]);
+      const bool want = word >> (31 - bit % word_bits) & 1;
+      Expect("ser", target_frequency, waveform.Level(kPinSer, srclk[i]),
+             want);
+      Expect("ser setup", target_frequency,
+             waveform.Level(kPinSer, srclk[i] - period), want);
+    }
+
+    // rclk rises as srclk falls after the last bit, and stays high for
+    // one cycle. Frames follow each other without a gap.
+    const uint64_t last = srclk[first + shift_bits - 1];
+    Expect("rclk delay", target_frequency, rclk[f + 1] - last, period);
+    Expect("rclk high", target_frequency, rclk_falls[f + 1] - rclk[f + 1],
+           period);
+    Expect("srclk low at latch", target_frequency,
+           waveform.Level(kPinSrclk, rclk[f + 1]), false);
+    if (f + 1 < frames.size()) {
+      Expect("frame period", target_frequency,
+             srclk[first + shift_bits] - srclk[first],
+             (2 * shift_bits + 1) * period);
+    }
+  }
+}
+
+// At a target frequency that doesn't divide the sys clock, the divider's
+// fraction spreads the remainder over the cycles: each lasts the divider
+// rounded down or up, and they add up to the divider, as truncated to
+// 1/256ths, to within a sys clock.
+void TestFractional(uint32_t target_frequency) {
+  constexpr int kBits = 16;
+  const float clkdiv = static_cast<float>(kSysHz * 1.0 / target_frequency);
+  const double divider = std::floor(clkdiv * 256) / 256;
+  Harness harness(kBits, target_frequency);
+  harness.sm.Put(frame::Encode(kBits, 0xa5c3));
+  harness.Run(static_cast<uint64_t>((2 * kBits + 10) * divider));
+
+  const std::vector<uint64_t> srclk = harness.waveform.Edges(kPinSrclk, true);
+  Expect("srclk rises", target_frequency, srclk.size(), kBits);
+  const uint64_t shortest = static_cast<uint64_t>(std::floor(2 * divider));
+  for (int i = 1; i < kBits; ++i) {
+    const uint64_t interval = srclk[i] - srclk[i - 1];
+    if (interval != shortest && interval != shortest + 1) {
+      Fail("srclk period", target_frequency, interval, shortest);
+    }
+  }
+  const double want = 2 * (kBits - 1) * divider;
+  const double got = srclk[kBits - 1] - srclk[0];
+  if (std::abs(got - want) > 1) {
+    Fail("srclk total", target_frequency, got, want);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc > 1) g_vcd_path = argv[1];
+
+  // One chip at the default 1 MHz.
+  TestExact(8, 1'000'000, {{0xa5}});
+  // Back to back frames, at 5 MHz and at the full 125 MHz.
+  TestExact(8, 5'000'000, {{0xa5}, {0x3c}, {0xff}, {0x00}});
+  TestExact(16, 125'000'000, {{0x8001}, {0x7ffe}});
+  // A 40-bit chain takes two words per frame and shifts 64 bits.
+  TestExact(40, 6'250'000,
+            {{0x000000a5, 0x12345678}, {0x0000005a, 0x87654321}});
+
+  TestFractional(3'000'000);
+  TestFractional(7'000'000);
+  printf("PASS\n");
+  return 0;
+}
@@ -1,10 +1,16 @@
 #ifndef JAGSPICO_CD74HC595_H
 #define JAGSPICO_CD74HC595_H
 
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <optional>
+#include <span>
 
 #include "hardware/pio.h"
+#include "jagspico/cd74hc595_dma_plan.h"
+#include "jagspico/cd74hc595_frame.h"
+#include "jagspico/shared_pio_program.h"
 
 namespace jagspico {
 
@@ -17,12 +23,12 @@ class Cd74Hc595DriverPio {
     uint32_t target_frequency = 1'000'000;
 
     // Number of bits to set before ticking rclk, loading those bits into
-    // the storage register of the Cd74Hc595. Currently this driver supports
-    // at most 32 bits.
+    // the storage register of the Cd74Hc595.
     //
     // This is useful if you have more than one Cd74Hc595 connected in
     // series. The highest bit will be the one first shifted out (i.e. it
-    // will be q7 or qh on the last chip in the chain.).
+    // will be q7 or qh on the last chip in the chain.). Chains longer than
+    // 32 bits take several words per latch; see cd74hc595_frame.h.
     int output_bits = 8;
   };
 
@@ -32,24 +38,124 @@ class Cd74Hc595DriverPio {
 
   ~Cd74Hc595DriverPio();
 
-  // Constructs the driver from the Config.
+  // Constructs the driver from the Config. Drivers on the same PIO block
+  // share one copy of the program. Returns nullopt if the block has no free
+  // state machine, or no room for the program.
   static std::optional<Cd74Hc595DriverPio> Create(const Config &config);
 
+  // Sends one frame of a chain of at most 32 bits.
   inline void Send(uint32_t x) {
-    pio_sm_put_blocking(pio_, state_machine_, x << (32 - output_bits_));
+    pio_sm_put_blocking(pio_, state_machine_, Encode(x));
   }
 
+  // Sends one frame of a chain of at most 32 bits, unless the TX FIFO is
+  // full. Returns whether it did.
+  inline bool TrySend(uint32_t x) {
+    if (pio_sm_is_tx_fifo_full(pio_, state_machine_))
+      return false;
+    pio_sm_put(pio_, state_machine_, Encode(x));
+    return true;
+  }
+
+  // Puts as many of words into the TX FIFO as fit, up to kTxFifoDepth, and
+  // returns how many. Never blocks. words are one or more frames, laid out
+  // as for SendFrames; a frame may be split across calls, in which case the
+  // outputs wait for the rest of it.
+  size_t SendMany(std::span<const uint32_t> words);
+
+  // Sends one or more frames back to back, words_per_frame() words each,
+  // the first word of each frame first. Fills the TX FIFO as fast as it
+  // drains, blocking until the last word is in it.
+  void SendFrames(std::span<const uint32_t> words);
+
+  // The TX FIFO is joined with the RX FIFO, which the driver never uses.
+  static constexpr uint32_t kTxFifoDepth = 8;
+
   uint32_t state_machine() const { return state_machine_; }
+  int words_per_frame() const { return cd74hc595_frame::Words(output_bits_); }
+
+  // Encodes one word of a frame the way Send and SendFrames do.
+  uint32_t Encode(uint32_t x) const {
+    return cd74hc595_frame::Encode(output_bits_, x);
+  }
+
+  // DMA mode streams words into the state machine without the CPU, e.g. to
+  // send a long sequence or to keep refreshing multiplexed outputs. Words
+  // must be encoded with Encode.
+
+  // The most segments SendDma takes at once.
+  static constexpr size_t kMaxDmaSegments = 8;
+
+  // Claims two DMA channels for DMA mode. Returns false if there are not
+  // two free channels. Send must not be called while DMA is busy.
+  bool EnableDma();
+
+  // Sends the words of each segment once, in order, then stops. The words
+  // must stay valid until dma_busy() is false. Returns false if DMA is not
+  // enabled or busy, there are more than kMaxDmaSegments segments, or a
+  // segment is empty.
+  bool SendDma(std::span<const std::span<const uint32_t>> segments);
+  bool SendDma(std::span<const uint32_t> words) {
+    return SendDma(std::span(&words, 1));
+  }
+
+  // Sends buffer over and over until StopDma. The buffer must stay valid
+  // until then, and may be written meanwhile: each word is picked up the
+  // next time it is sent. Returns false if DMA is not enabled or busy, or
+  // buffer is empty.
+  bool StartDmaLoop(std::span<const uint32_t> buffer);
+
+  // Switches a loop to buffer, which must be as long as the one it
+  // started with, once the current pass over the old buffer is done.
+  // Returns false if DMA is not enabled or the length differs.
+  bool SetDmaLoopBuffer(std::span<const uint32_t> buffer);
+
+  // Whether DMA is partway through buffer, which must not be written
+  // meanwhile.
+  bool DmaReading(std::span<const uint32_t> buffer) const;
+
+  // Waits until DmaReading(buffer) is false, calling wait meanwhile, e.g.
+  // to let other tasks run, or spinning if it is null. A pass over a loop
+  // buffer can take as long as a refresh.
+  void WaitWhileDmaReading(std::span<const uint32_t> buffer,
+                           void (*wait)() = nullptr) const;
+
+  // Stops DMA. Words already in the TX FIFO are still sent.
+  void StopDma();
+
+  bool dma_busy() const;
 
  private:
-  Cd74Hc595DriverPio(const Config &config, uint32_t state_machine)
+  friend class Cd74Hc595Bcm;
+  friend class Disp4DigitPio;
+
+  // Like Create, but for another program that is fed the same way.
+  static std::optional<Cd74Hc595DriverPio>
+  Create(const Config &config, SharedPioProgram &program,
+         pio_sm_config (*default_config)(uint offset));
+
+  struct DmaState {
+    cd74hc595_dma::Channels channels;
+    cd74hc595_dma::Block blocks[kMaxDmaSegments + 1];
+  };
+
+  // Starts the data channel through the control channel, as planned.
+  void StartDma(const cd74hc595_dma::Plan &plan);
+
+  Cd74Hc595DriverPio(const Config &config, uint32_t state_machine,
+                     SharedPioProgram &program)
       : pio_{config.pio},
         state_machine_{state_machine},
-        output_bits_(config.output_bits) {}
+        output_bits_(config.output_bits),
+        program_(&program) {}
 
   PIO pio_;
   uint32_t state_machine_;
   int output_bits_;
+  SharedPioProgram *program_;
+  // On the heap, because the control channel reads the blocks, which must
+  // not move with the driver.
+  std::unique_ptr<DmaState> dma_;
 };
 
 }  // namespace jagspico
@@ -0,0 +1,78 @@
+#ifndef JAGSPICO_CD74HC595_BCM_H
+#define JAGSPICO_CD74HC595_BCM_H
+
+#include <cstdint>
+#include <optional>
+#include <span>
+
+#include "jagspico/cd74hc595.h"
+#include "jagspico/cd74hc595_bcm_planes.h"
+#include "jagspico/cd74hc595_dma_loop.h"
+
+namespace jagspico {
+
+// Dims the outputs of a chain of Cd74Hc595s, e.g. LEDs, by binary code
+// modulation: each output has an intensity of depth bits, and the chain
+// shows one bit plane after another, plane p for 2^p time units. A PIO
+// program times the planes and DMA feeds it the same buffer of planes over
+// and over, so refreshing takes no CPU at all; Set only recomputes the
+// planes when the intensities change.
+//
+// The refresh rate is the state machine's clock over RefreshCycles, e.g.
+// with Config::driver.target_frequency at 10 MHz:
+//
+//   outputs  depth 4   depth 6   depth 8
+//         8   35.1 kHz   8.4 kHz   2.1 kHz
+//        16   19.0 kHz   4.5 kHz   1.1 kHz
+//        32    9.9 kHz   2.4 kHz   585 Hz
+//        64    5.1 kHz   1.2 kHz   299 Hz
+//       128    2.6 kHz   613 Hz    151 Hz
+//
+// Refreshing above about 200 Hz avoids visible flicker, and well above that
+// avoids banding on camera.
+class Cd74Hc595Bcm {
+public:
+  struct Config {
+    // target_frequency is the state machine's clock, which shifts a bit
+    // every two cycles.
+    Cd74Hc595DriverPio::Config driver;
+    // Bits of intensity, from cd74hc595_bcm::kMinDepth to kMaxDepth.
+    int depth = 8;
+    // Called over and over while Set waits for DMA, e.g. to let other tasks
+    // run. If null, Set spins.
+    void (*wait)() = nullptr;
+  };
+
+  Cd74Hc595Bcm(const Cd74Hc595Bcm &) = delete;
+  Cd74Hc595Bcm(Cd74Hc595Bcm &&o) = default;
+  Cd74Hc595Bcm &operator=(const Cd74Hc595Bcm &) = delete;
+
+  // Creates the driver and starts refreshing, with every output off.
+  // Returns nullopt if the depth is out of range, or the PIO block or the
+  // DMA has run out of resources.
+  static std::optional<Cd74Hc595Bcm> Create(const Config &config);
+
+  // Sets every output's intensity, from 0 for off to 2^depth - 1 for fully
+  // on; element 0 is qa of the first chip. Takes effect at the start of the
+  // next refresh, and may wait for up to one refresh for DMA to finish with
+  // the buffer it reuses; see Config::wait. Returns false if intensities has
+  // the wrong size.
+  bool Set(std::span<const uint8_t> intensities);
+
+  int depth() const { return depth_; }
+  float refresh_hz() const;
+
+private:
+  Cd74Hc595Bcm(Cd74Hc595DriverPio driver, const Config &config);
+
+  Cd74Hc595DmaLoop loop_;
+  Cd74Hc595DriverPio driver_;
+  int output_bits_;
+  int depth_;
+  uint32_t frequency_;
+  void (*wait_)();
+};
+
+} // namespace jagspico
+
+#endif // JAGSPICO_CD74HC595_BCM_H
@@ -0,0 +1,78 @@
+#ifndef JAGSPICO_CD74HC595_BCM_PLANES_H
+#define JAGSPICO_CD74HC595_BCM_PLANES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "jagspico/cd74hc595_frame.h"
+
+// The buffer that Cd74Hc595Bcm streams to cd74hc595_bcm.pio, and its
+// timing. Hardware-free so that host tests can share it.
+//
+// The buffer holds one plane per bit of intensity, least significant first.
+// A plane is a frame, laid out as in cd74hc595_frame.h, whose outputs are
+// on where that bit of their intensity is set, followed by its hold count.
+// Plane p is on display for 2^p units of PlaneCycles, so an output with
+// intensity v is on for v units out of every 2^depth - 1.
+namespace jagspico::cd74hc595_bcm {
+
+inline constexpr int kMinDepth = 4;
+inline constexpr int kMaxDepth = 8;
+
+// State machine cycles to shift and latch one plane, which is also the
+// shortest a plane can be shown for: one MOV, an OUT and a JMP per bit, the
+// OUT that latches, and one pass through the hold loop.
+constexpr uint32_t PlaneCycles(int output_bits) {
+  return 2 * cd74hc595_frame::ShiftBits(output_bits) + 3;
+}
+
+// State machine cycles per pass over every plane.
+constexpr uint32_t RefreshCycles(int output_bits, int depth) {
+  return ((1u << depth) - 1) * PlaneCycles(output_bits);
+}
+
+// The hold count of plane p, i.e. the X of its hold loop: plane p must be
+// shown for 2^p units, of which shifting takes up one.
+constexpr uint32_t Hold(int output_bits, int plane) {
+  return ((1u << plane) - 1) * PlaneCycles(output_bits);
+}
+
+constexpr size_t BufferWords(int output_bits, int depth) {
+  return static_cast<size_t>(cd74hc595_frame::Words(output_bits) + 1) * depth;
+}
+
+// Fills buffer with the planes for intensities, one per output: element 0
+// is qa of the first chip, as bit 0 of a frame. Bits of an intensity above
+// depth are ignored. Returns false if either span has the wrong size.
+constexpr bool Fill(int output_bits, int depth,
+                    std::span<const uint8_t> intensities,
+                    std::span<uint32_t> buffer) {
+  if (intensities.size() != static_cast<size_t>(output_bits) ||
+      buffer.size() != BufferWords(output_bits, depth)) {
+    return false;
+  }
+  const int words = cd74hc595_frame::Words(output_bits);
+  const int stride = words + 1;
+  for (uint32_t &word : buffer) word = 0;
+  for (int k = 0; k < output_bits; ++k) {
+    const uint32_t bit = 1u << (k % 32);
+    const int word = words - 1 - k / 32;
+    uint32_t v = intensities[k];
+    for (int p = 0; v != 0 && p < depth; v >>= 1, ++p) {
+      if (v & 1) buffer[p * stride + word] |= bit;
+    }
+  }
+  for (int p = 0; p < depth; ++p) {
+    for (int w = 0; w < words; ++w) {
+      uint32_t &word = buffer[p * stride + w];
+      word = cd74hc595_frame::Encode(output_bits, word);
+    }
+    buffer[p * stride + words] = Hold(output_bits, p);
+  }
+  return true;
+}
+
+}  // namespace jagspico::cd74hc595_bcm
+
+#endif  // JAGSPICO_CD74HC595_BCM_PLANES_H
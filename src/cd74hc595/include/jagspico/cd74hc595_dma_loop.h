@@ -0,0 +1,43 @@
+#ifndef JAGSPICO_CD74HC595_DMA_LOOP_H
+#define JAGSPICO_CD74HC595_DMA_LOOP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "jagspico/cd74hc595.h"
+
+namespace jagspico {
+
+// The two buffers of a Cd74Hc595DriverPio DMA loop that is updated while it
+// runs: DMA streams the front one while the back one is filled, then Swap
+// switches the loop over. The old front buffer may still be read until the
+// pass over it ends, so Back waits for that.
+//
+// Declare it before the driver, so that DMA stops before the buffers are
+// freed.
+class Cd74Hc595DmaLoop {
+public:
+  // Both buffers have words words, all 0.
+  explicit Cd74Hc595DmaLoop(size_t words);
+
+  // The buffer to start the loop with.
+  std::span<const uint32_t> front() const { return buffers_[front_]; }
+  std::span<uint32_t> front() { return buffers_[front_]; }
+
+  // Returns the back buffer, once driver's DMA is done with it. wait is as
+  // for WaitWhileDmaReading.
+  std::span<uint32_t> Back(const Cd74Hc595DriverPio &driver, void (*wait)());
+
+  // Switches driver's loop to the back buffer, which becomes the front one.
+  void Swap(Cd74Hc595DriverPio &driver);
+
+private:
+  std::vector<uint32_t> buffers_[2];
+  int front_ = 0;
+};
+
+} // namespace jagspico
+
+#endif // JAGSPICO_CD74HC595_DMA_LOOP_H
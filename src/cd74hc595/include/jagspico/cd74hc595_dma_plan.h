@@ -0,0 +1,148 @@
+#ifndef JAGSPICO_CD74HC595_DMA_PLAN_H
+#define JAGSPICO_CD74HC595_DMA_PLAN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+// How Cd74Hc595DriverPio's DMA mode programs its two DMA channels. This only
+// computes register values, so that it can be tested on the host, and the
+// driver writes them.
+//
+// The data channel copies words into the state machine's TX FIFO, paced by
+// the FIFO's DREQ. Each time it finishes a block of words, it chains to the
+// control channel, which writes the data channel's next block into its alias
+// 3 registers and so starts it again.
+//
+// * One-shot: the control channel walks a list of Blocks, one per segment,
+//   copying each into TRANS_COUNT and READ_ADDR_TRIG. The list ends with a
+//   null block, whose zero read address is a null trigger, which stops the
+//   data channel instead of starting it.
+// * Loop: the control channel copies just the buffer's address into
+//   READ_ADDR_TRIG, from the same place every time. TRANS_COUNT reloads the
+//   buffer's length each time the data channel is triggered, so it sends the
+//   buffer over and over.
+namespace jagspico::cd74hc595_dma {
+
+// Offsets of the data channel's registers that the control channel writes.
+inline constexpr uint32_t kAl3TransCountOffset = 0x38;
+inline constexpr uint32_t kAl3ReadAddrTrigOffset = 0x3c;
+
+// Fields of a channel's CTRL register. See the RP2040 datasheet, 2.5.7.
+namespace ctrl {
+inline constexpr uint32_t kEn = 1u << 0;
+inline constexpr uint32_t kDataSizeWord = 2u << 2;
+inline constexpr uint32_t kIncrRead = 1u << 4;
+inline constexpr uint32_t kIncrWrite = 1u << 5;
+inline constexpr int kRingSizeShift = 6;
+inline constexpr uint32_t kRingSelWrite = 1u << 10;
+inline constexpr int kChainToShift = 11;
+inline constexpr int kTreqSelShift = 15;
+inline constexpr uint32_t kTreqPermanent = 0x3f;
+inline constexpr uint32_t kIrqQuiet = 1u << 21;
+}  // namespace ctrl
+
+struct Channels {
+  uint32_t data;
+  uint32_t control;
+  // The state machine's TX DREQ, i.e. pio_get_dreq(pio, sm, true).
+  uint32_t dreq;
+};
+
+// Words to send, at an address as the DMA sees it.
+struct Segment {
+  uint32_t read_addr;
+  uint32_t count;
+};
+
+// What the control channel copies into the data channel's alias 3
+// TRANS_COUNT and READ_ADDR_TRIG.
+struct Block {
+  uint32_t transfer_count;
+  uint32_t read_addr;
+};
+static_assert(sizeof(Block) == 8);
+
+struct Plan {
+  uint32_t data_ctrl;
+  // Written to the data channel's TRANS_COUNT before starting, which sets
+  // the value it reloads each time it is triggered.
+  uint32_t data_transfer_count;
+
+  uint32_t control_ctrl;
+  uint32_t control_transfer_count;
+  // Where the control channel reads, as an offset from the blocks.
+  uint32_t control_read_offset;
+  // Where the control channel writes, as an offset from the data channel's
+  // registers.
+  uint32_t control_write_offset;
+
+  // The number of blocks filled in.
+  size_t blocks;
+};
+
+// Reads words, writes them to the TX FIFO at its pace, and chains to the
+// control channel when done. IRQ_QUIET keeps it from raising an interrupt
+// after every block; it raises one on the null trigger instead.
+constexpr uint32_t DataCtrl(const Channels& channels) {
+  return ctrl::kEn | ctrl::kDataSizeWord | ctrl::kIncrRead |
+         (channels.control << ctrl::kChainToShift) |
+         (channels.dreq << ctrl::kTreqSelShift) | ctrl::kIrqQuiet;
+}
+
+// Plans sending each segment once, in order, and fills in blocks. Returns
+// nullopt if there are no segments, one is empty, or blocks has no room for
+// one block per segment plus the null block.
+constexpr std::optional<Plan> PlanOneShot(
+    std::span<const Segment> segments, std::span<Block> blocks,
+    const Channels& channels) {
+  if (segments.empty() || blocks.size() < segments.size() + 1) {
+    return std::nullopt;
+  }
+  for (size_t i = 0; i < segments.size(); ++i) {
+    if (segments[i].count == 0) return std::nullopt;
+    blocks[i] = {segments[i].count, segments[i].read_addr};
+  }
+  blocks[segments.size()] = {0, 0};
+  return Plan{
+      .data_ctrl = DataCtrl(channels),
+      .data_transfer_count = 0,
+      // Copies a block's two words, with the write address wrapping around
+      // every 8 bytes, so that each trigger starts at TRANS_COUNT again.
+      // Chaining to itself disables chaining.
+      .control_ctrl = ctrl::kEn | ctrl::kDataSizeWord | ctrl::kIncrRead |
+                      ctrl::kIncrWrite | (3u << ctrl::kRingSizeShift) |
+                      ctrl::kRingSelWrite |
+                      (channels.control << ctrl::kChainToShift) |
+                      (ctrl::kTreqPermanent << ctrl::kTreqSelShift),
+      .control_transfer_count = 2,
+      .control_read_offset = 0,
+      .control_write_offset = kAl3TransCountOffset,
+      .blocks = segments.size() + 1,
+  };
+}
+
+// Plans sending buffer over and over, and fills in blocks[0]. Returns
+// nullopt if buffer is empty or blocks is.
+constexpr std::optional<Plan> PlanLoop(
+    Segment buffer, std::span<Block> blocks, const Channels& channels) {
+  if (buffer.count == 0 || blocks.empty()) return std::nullopt;
+  blocks[0] = {buffer.count, buffer.read_addr};
+  return Plan{
+      .data_ctrl = DataCtrl(channels),
+      .data_transfer_count = buffer.count,
+      // Copies one word, from and to the same place every time.
+      .control_ctrl = ctrl::kEn | ctrl::kDataSizeWord |
+                      (channels.control << ctrl::kChainToShift) |
+                      (ctrl::kTreqPermanent << ctrl::kTreqSelShift),
+      .control_transfer_count = 1,
+      .control_read_offset = offsetof(Block, read_addr),
+      .control_write_offset = kAl3ReadAddrTrigOffset,
+      .blocks = 1,
+  };
+}
+
+}  // namespace jagspico::cd74hc595_dma
+
+#endif  // JAGSPICO_CD74HC595_DMA_PLAN_H
@@ -0,0 +1,43 @@
+#ifndef JAGSPICO_CD74HC595_FRAME_H
+#define JAGSPICO_CD74HC595_FRAME_H
+
+#include <algorithm>
+#include <cstdint>
+
+// How Cd74Hc595DriverPio lays out a frame, i.e. the bits loaded into the
+// chain between two pulses of rclk, in the words it sends the state machine.
+// Hardware-free so that host tests can share it.
+//
+// A chain of up to 32 bits takes one word per frame, with the bits at the
+// top of the word, and the state machine shifts exactly that many. A longer
+// chain takes several words per frame, the first word first, and the state
+// machine shifts all of their bits: the frame is right-aligned in them, and
+// the padding at the top of the first word goes out first, so that it falls
+// off the far end of the chain.
+//
+// Either way, each word is shifted out most significant bit first, so bit
+// 0 of a frame's last word ends up on qa of the first chip.
+namespace jagspico::cd74hc595_frame {
+
+// Words per frame for a chain of output_bits.
+constexpr int Words(int output_bits) { return (output_bits + 31) / 32; }
+
+// Bits the state machine shifts per frame, including padding.
+constexpr int ShiftBits(int output_bits) {
+  return output_bits <= 32 ? output_bits : 32 * Words(output_bits);
+}
+
+// The autopull threshold: one pull per word.
+constexpr int PullThreshold(int output_bits) {
+  return std::min(output_bits, 32);
+}
+
+// Left-shifts a word so that its output bits are at the top, which only
+// moves anything for a single-word frame.
+constexpr uint32_t Encode(int output_bits, uint32_t word) {
+  return word << (32 - PullThreshold(output_bits));
+}
+
+}  // namespace jagspico::cd74hc595_frame
+
+#endif  // JAGSPICO_CD74HC595_FRAME_H
@@ -0,0 +1,54 @@
+#ifndef JAGSPICO_SHARED_PIO_PROGRAM_H
+#define JAGSPICO_SHARED_PIO_PROGRAM_H
+
+#include <cstdint>
+#include <optional>
+
+#include "hardware/pio.h"
+
+namespace jagspico {
+
+// A PIO program loaded at most once per PIO block, however many state
+// machines run it, and removed once none does. Each PIO block has room for
+// only 32 instructions, so drivers that may have several instances share
+// their program through one of these, defined next to the driver:
+//
+//   SharedPioProgram g_program(&my_program);
+//   ...
+//   std::optional<uint32_t> offset = g_program.Acquire(pio);
+//   ...
+//   g_program.Release(pio);
+//
+// Safe to use from either core, but not from an ISR: the bookkeeping is
+// guarded by a mutex.
+class SharedPioProgram {
+public:
+  explicit constexpr SharedPioProgram(const pio_program_t *program)
+      : program_(program) {}
+  SharedPioProgram(const SharedPioProgram &) = delete;
+  SharedPioProgram &operator=(const SharedPioProgram &) = delete;
+
+  // Loads the program into pio unless it is already there, and returns its
+  // offset. Returns nullopt if it does not fit.
+  std::optional<uint32_t> Acquire(PIO pio);
+
+  // Releases one Acquire of pio's instance, removing the program once it
+  // has no users left.
+  void Release(PIO pio);
+
+  // The number of users of pio's instance.
+  uint32_t users(PIO pio) const;
+
+private:
+  struct Instance {
+    uint32_t offset = 0;
+    uint32_t users = 0;
+  };
+
+  const pio_program_t *program_;
+  Instance instances_[NUM_PIOS] = {};
+};
+
+} // namespace jagspico
+
+#endif // JAGSPICO_SHARED_PIO_PROGRAM_H
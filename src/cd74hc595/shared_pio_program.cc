@@ -0,0 +1,44 @@
+#include "jagspico/shared_pio_program.h"
+
+#include "hardware/pio.h"
+#include "pico/mutex.h"
+
+namespace jagspico {
+
+namespace {
+
+// Not the hardware claim lock, which pio_add_program takes itself, and which
+// is not recursive.
+auto_init_mutex(g_lock);
+
+} // namespace
+
+std::optional<uint32_t> SharedPioProgram::Acquire(PIO pio) {
+  Instance &instance = instances_[pio_get_index(pio)];
+  mutex_enter_blocking(&g_lock);
+  std::optional<uint32_t> offset;
+  if (instance.users > 0) {
+    offset = instance.offset;
+  } else if (pio_can_add_program(pio, program_)) {
+    instance.offset = pio_add_program(pio, program_);
+    offset = instance.offset;
+  }
+  if (offset)
+    ++instance.users;
+  mutex_exit(&g_lock);
+  return offset;
+}
+
+void SharedPioProgram::Release(PIO pio) {
+  Instance &instance = instances_[pio_get_index(pio)];
+  mutex_enter_blocking(&g_lock);
+  if (instance.users > 0 && --instance.users == 0)
+    pio_remove_program(pio, program_, instance.offset);
+  mutex_exit(&g_lock);
+}
+
+uint32_t SharedPioProgram::users(PIO pio) const {
+  return instances_[pio_get_index(pio)].users;
+}
+
+} // namespace jagspico
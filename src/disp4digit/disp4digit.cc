@@ -28,7 +28,7 @@ Disp4Digit::DisplayValue Disp4Digit::DisplayValue::FromInt(int i) {
                       .decimal_position = 0};
 }
 
-static uint8_t DigitToMask(uint8_t digit, bool decimal_after) {
+uint8_t Disp4Digit::DigitToMask(uint8_t digit, bool decimal_after) {
   if (digit > 9) {
     panic("DigitToMask: OOB %d\n", digit);
   }
@@ -40,17 +40,17 @@ static uint8_t DigitToMask(uint8_t digit, bool decimal_after) {
   return digits.at(digit) | (decimal_after ? dot_mask : 0U);
 }
 
-static uint32_t DigitToMask4(std::array<uint8_t, 4> values,
-                             int decimal_position) {
-  uint32_t out = 0;
+std::array<uint8_t, 4> Disp4Digit::Segments(const DisplayValue& value) {
+  const std::array<uint8_t, 4> digits = {
+      static_cast<uint8_t>(value.digits / 1000 % 10),
+      static_cast<uint8_t>(value.digits / 100 % 10),
+      static_cast<uint8_t>(value.digits / 10 % 10),
+      static_cast<uint8_t>(value.digits % 10)};
+  std::array<uint8_t, 4> segments;
   for (int i = 0; i < 4; ++i) {
-    const int digit_index = 3 - i;  // Note: LSB first.
-    const int shl = 24 - i * 8;
-    const uint32_t digit_mask =
-        DigitToMask(values[i], decimal_position == (3 - i));
-    out |= (digit_mask << shl);
+    segments[i] = DigitToMask(digits[i], value.decimal_position == 3 - i);
   }
-  return out;
+  return segments;
 }
 
 Disp4Digit::Disp4Digit(Config&& config)
@@ -65,44 +65,34 @@ Disp4Digit::Disp4Digit(Config&& config)
     gpio_put(p, true);
   }
 
-  auto task_ok = xTaskCreate(
-      +[](void* obj) { static_cast<Disp4Digit*>(obj)->DriveTask(); },
-      "disp4digit", 256, this, 1, nullptr);
-  assert(task_ok == pdPASS);
+  drive_task_.emplace(
+      freertosxx::Task::Options{.name = "disp4digit", .cores = config.cores},
+      [this] { DriveTask(); });
+  stop_.Bind(drive_task_->handle());
 }
 
-constexpr EventBits_t kStartShutdown = 0b1;
-constexpr EventBits_t kShutdownFinished = 0b10;
-
 Disp4Digit::~Disp4Digit() {
-  xEventGroupSetBits(shutdown_event_, kStartShutdown);
-  xEventGroupWaitBits(shutdown_event_, kShutdownFinished, pdTRUE, pdTRUE,
-                      portMAX_DELAY);
-  vEventGroupDelete(shutdown_event_);
+  stop_.Give();
+  drive_task_->Join();
 }
 
 void Disp4Digit::DriveTask() {
   uint32_t prev_pin = pin_select_;
   while (true) {
-    if (xEventGroupGetBits(shutdown_event_) == kStartShutdown) {
-      xEventGroupSetBits(shutdown_event_, kShutdownFinished);
-    }
-
     const DisplayValue value = callback_();
-    const std::array<uint8_t, 4> digits = {
-        static_cast<uint8_t>(value.digits / 1000 % 10),
-        static_cast<uint8_t>(value.digits / 100 % 10),
-        static_cast<uint8_t>(value.digits / 10 % 10),
-        static_cast<uint8_t>(value.digits % 10)};
-    const uint32_t digits_mask_ = DigitToMask4(digits, value.decimal_position);
+    const std::array<uint8_t, 4> segments = Segments(value);
     for (int i = 0; i < 4; ++i) {
       gpio_put(prev_pin, true);  // Unselect the previous selection pin.
       const uint32_t pin = pin_select_ + i;
       // If !off, drive the pin low to allow current to flow.
       gpio_put(pin, !value.off);
       prev_pin = pin;
-      digit_driver_.Send(digits_mask_ >> ((3 - i) * 8) & 0xff);
-      vTaskDelay(pdMS_TO_TICKS(1));
+      digit_driver_.Send(segments[i]);
+      // Holds the digit for a tick, or ends the task early on shutdown.
+      if (stop_.Wait({.timeout = pdMS_TO_TICKS(1)})) {
+        gpio_put(prev_pin, true);
+        return;
+      }
     }
   }
 }
@@ -0,0 +1,101 @@
+#include "disp4digit_pio.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <utility>
+
+#include "FreeRTOS.h"
+#include "disp4digit.pio.h"
+#include "hardware/pio.h"
+#include "jagspico/disp4digit_frame.h"
+#include "jagspico/shared_pio_program.h"
+#include "pico/platform.h"
+#include "task.h"
+
+namespace jagspico {
+
+namespace {
+
+SharedPioProgram g_program(&disp4digit_program);
+
+constexpr uint32_t kAllOff = 0xf;
+
+// A pass over the frame buffer takes a whole refresh, too long to keep other
+// tasks off the core for.
+void WaitForDma() {
+  if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING) {
+    vTaskDelay(1);
+  } else {
+    tight_loop_contents();
+  }
+}
+
+}  // namespace
+
+Disp4DigitPio::Disp4DigitPio(Cd74Hc595DriverPio driver, const Config& config)
+    : loop_(disp4digit_frame::kDigits),
+      driver_(std::move(driver)),
+      pio_(config.pio) {}
+
+Disp4DigitPio::Disp4DigitPio(Disp4DigitPio&& o)
+    : loop_(std::move(o.loop_)),
+      driver_(std::move(o.driver_)),
+      pio_(o.pio_) {
+  o.pio_ = nullptr;
+}
+
+Disp4DigitPio::~Disp4DigitPio() {
+  if (!pio_) return;
+  // Stops the program wherever it is and drives every select line high,
+  // preventing current from flowing, before the driver lets go of them.
+  driver_.StopDma();
+  const uint32_t sm = driver_.state_machine();
+  pio_sm_set_enabled(pio_, sm, false);
+  pio_sm_exec(pio_, sm, disp4digit_frame::SelectInstruction(kAllOff));
+}
+
+std::optional<Disp4DigitPio> Disp4DigitPio::Create(const Config& config) {
+  const PIO pio = config.pio;
+  std::optional<Cd74Hc595DriverPio> driver = Cd74Hc595DriverPio::Create(
+      {
+          .pio = pio,
+          .pin_srclk = config.pin_srclk,
+          .pin_ser = config.pin_ser,
+          .target_frequency = disp4digit_frame::Frequency(config.refresh_hz),
+          .output_bits = disp4digit_frame::kPullThreshold,
+      },
+      g_program, disp4digit_program_get_default_config);
+  if (!driver || !driver->EnableDma()) return std::nullopt;
+
+  // The driver knows nothing of the select lines, which the program SETs.
+  // Nothing has been sent yet, so the program is waiting for its first word.
+  const uint32_t sm = driver->state_machine();
+  const uint32_t select_mask = kAllOff << config.pin_select;
+  pio_sm_set_enabled(pio, sm, false);
+  for (int i = 0; i < disp4digit_frame::kDigits; ++i) {
+    pio_gpio_init(pio, config.pin_select + i);
+  }
+  // Drive the GPIOs to VCC, preventing current from flowing.
+  pio_sm_set_pins_with_mask(pio, sm, select_mask, select_mask);
+  pio_sm_set_pindirs_with_mask(pio, sm, select_mask, select_mask);
+  pio_sm_set_set_pins(pio, sm, config.pin_select, disp4digit_frame::kDigits);
+  pio_sm_set_enabled(pio, sm, true);
+
+  Disp4DigitPio display(std::move(*driver), config);
+  std::ranges::copy(disp4digit_frame::Frame({}, /*off=*/true),
+                    display.loop_.front().begin());
+  display.driver_.StartDmaLoop(display.loop_.front());
+  return display;
+}
+
+void Disp4DigitPio::Set(const Disp4Digit::DisplayValue& value) {
+  const std::array<uint32_t, disp4digit_frame::kDigits> frame =
+      disp4digit_frame::Frame(Disp4Digit::Segments(value), value.off);
+  if (std::ranges::equal(frame, loop_.front())) return;
+
+  std::ranges::copy(frame, loop_.Back(driver_, WaitForDma).begin());
+  loop_.Swap(driver_);
+}
+
+}  // namespace jagspico
@@ -0,0 +1,213 @@
+// Runs disp4digit.pio on piosim, set up the way Disp4DigitPio sets up the
+// state machine and fed the way its DMA loop feeds it, with a model of the
+// Cd74Hc595 on the segment lines. Checks that at most one digit is ever
+// selected, that it shows its own segments, that nothing is lit while the
+// segments change, that every digit is lit for the same share of each
+// refresh, and that a new frame buffer takes over cleanly. Build with
+// PICO_PLATFORM=host.
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "disp4digit.pio.h"
+#include "jagspico/disp4digit_frame.h"
+#include "piosim/cd74hc595_chain.h"
+#include "piosim/state_machine.h"
+
+namespace frame = jagspico::disp4digit_frame;
+
+namespace {
+
+void Fail(const char* what, uint64_t cycle, uint32_t got, uint32_t want) {
+  printf("FAIL: %s at cycle %llu: got %u want %u\n", what,
+         static_cast<unsigned long long>(cycle), got, want);
+  abort();
+}
+
+void Expect(const char* what, uint64_t cycle, uint32_t got, uint32_t want) {
+  if (got != want) Fail(what, cycle, got, want);
+}
+
+constexpr int kPinSrclk = 0;
+constexpr int kPinSer = 2;
+constexpr int kPinSelect = 3;
+
+// pio_encode_pull(false, true) and pio_encode_out(pio_y, 32), which the
+// host build has no header for.
+constexpr uint16_t kPullBlock = 0x80a0;
+constexpr uint16_t kOutY32 = 0x6040;
+
+constexpr int kRefreshCycles = frame::kDigits * frame::kCyclesPerDigit;
+
+using Frame = std::array<uint32_t, frame::kDigits>;
+
+// The state machine, the Cd74Hc595 and a DMA loop over a frame buffer.
+struct Display {
+  Display()
+      : sm({
+            .program = disp4digit_program_instructions,
+            .wrap_target = disp4digit_wrap_target,
+            .wrap = disp4digit_wrap,
+            .sideset_count = 2,
+            .sideset_base = kPinSrclk,
+            .out_base = kPinSer,
+            .out_count = 1,
+            .set_base = kPinSelect,
+            .set_count = frame::kDigits,
+            .out_shift_right = false,
+            .autopull = true,
+            .pull_threshold = frame::kPullThreshold,
+            .join_tx = true,
+        }),
+        chain(8, kPinSrclk, kPinSer) {
+    // As Cd74Hc595DriverPio::Create and then Disp4DigitPio::Create leave it.
+    sm.Put(frame::kPullThreshold - 1);
+    sm.Exec(kPullBlock);
+    sm.Exec(kOutY32);
+    for (int i = 0; i < frame::kDigits; ++i) sm.SetInput(kPinSelect + i, true);
+  }
+
+  // Runs a cycle, keeping the TX FIFO topped up from the buffer, and
+  // switching to next at the end of a pass as SetDmaLoopBuffer does.
+  void Step() {
+    while (sm.tx_level() < 8) {
+      if (index == 0 && next != nullptr) {
+        buffer = next;
+        next = nullptr;
+      }
+      sm.Put((*buffer)[index]);
+      index = (index + 1) % frame::kDigits;
+    }
+    const int latches = chain.latches;
+    sm.Step();
+    chain.Clock(sm.pins());
+    latched = chain.latches != latches;
+  }
+
+  // The selected digits, one bit each.
+  uint32_t selected() const {
+    return ~sm.pins() >> kPinSelect & ((1u << frame::kDigits) - 1);
+  }
+
+  // What the Cd74Hc595 drives onto the segments.
+  uint8_t segments() const {
+    uint8_t segments = 0;
+    for (int i = 0; i < 8; ++i) segments |= chain.storage[i] << i;
+    return segments;
+  }
+
+  piosim::StateMachine sm;
+  piosim::Cd74Hc595Chain chain;
+  const Frame* buffer = nullptr;
+  const Frame* next = nullptr;
+  int index = 0;
+  bool latched = false;
+};
+
+// The segments of each digit of a frame, which must differ so that a digit
+// showing another's segments is caught.
+constexpr std::array<uint8_t, frame::kDigits> kFirst = {0x3f, 0x06, 0x5b,
+                                                        0xcf};
+constexpr std::array<uint8_t, frame::kDigits> kSecond = {0x66, 0xed, 0x7d,
+                                                         0x07};
+
+// Checks the invariants of one cycle: at most one digit is selected, none
+// while the segments change, and the one that is shows segments, which
+// are kFirst or kSecond; returns which.
+const std::array<uint8_t, frame::kDigits>* CheckCycle(const Display& display,
+                                                      uint64_t cycle) {
+  const uint32_t selected = display.selected();
+  if (std::popcount(selected) > 1) Fail("selected", cycle, selected, 1);
+  if (display.latched) Expect("selected at latch", cycle, selected, 0);
+  if (selected == 0) return nullptr;
+  const int digit = std::countr_zero(selected);
+  if (display.segments() == kFirst[digit]) return &kFirst;
+  if (display.segments() == kSecond[digit]) return &kSecond;
+  Fail("segments", cycle, display.segments(), kFirst[digit]);
+  return nullptr;
+}
+
+void TestRefresh() {
+  const Frame first = frame::Frame(kFirst, /*off=*/false);
+  const Frame second = frame::Frame(kSecond, /*off=*/false);
+  Display display;
+  display.buffer = &first;
+
+  // Runs until digit 0 lights, and then for whole refreshes from there.
+  uint64_t cycle = 0;
+  for (; display.selected() != 1; ++cycle) {
+    if (cycle > 1000) Fail("first digit", cycle, display.selected(), 1);
+    display.Step();
+    CheckCycle(display, cycle);
+  }
+  constexpr int kRefreshes = 10;
+  std::array<int, frame::kDigits> lit = {};
+  uint32_t previous = display.selected();
+  uint64_t lit_at = display.sm.cycles();
+  for (int i = 1; i < kRefreshes * kRefreshCycles; ++i, ++cycle) {
+    // The cycle that lit digit 0 counts; the one that would again doesn't.
+    if (display.selected() != 0) ++lit[std::countr_zero(display.selected())];
+    display.Step();
+    if (CheckCycle(display, cycle) != &kFirst) {
+      if (display.selected() != 0) Fail("first frame", cycle, 0, 1);
+    }
+    // Each digit lights kCyclesPerDigit after the previous one.
+    if (display.selected() != previous && display.selected() != 0) {
+      Expect("digit period", cycle, display.sm.cycles() - lit_at,
+             frame::kCyclesPerDigit);
+      lit_at = display.sm.cycles();
+    }
+    previous = display.selected();
+  }
+  if (display.selected() != 0) ++lit[std::countr_zero(display.selected())];
+  for (int digit = 0; digit < frame::kDigits; ++digit) {
+    Expect("lit cycles", digit, lit[digit], kRefreshes * frame::kLitCycles);
+  }
+
+  // Mid-refresh, switches to the second frame, which each digit must show
+  // once the loop has finished its pass and the TX FIFO has drained the two
+  // refreshes it holds, never going back to the first.
+  display.next = &second;
+  std::array<bool, frame::kDigits> switched = {};
+  for (int i = 0; i < 4 * kRefreshCycles; ++i, ++cycle) {
+    display.Step();
+    const auto* showing = CheckCycle(display, cycle);
+    if (showing == nullptr) continue;
+    const int digit = std::countr_zero(display.selected());
+    if (showing == &kSecond) {
+      switched[digit] = true;
+    } else if (switched[digit]) {
+      Fail("switched back", cycle, digit, 0);
+    }
+  }
+  for (int digit = 0; digit < frame::kDigits; ++digit) {
+    Expect("switched", digit, switched[digit], true);
+  }
+}
+
+// A frame of DisplayValue::off selects nothing, ever, but keeps latching.
+void TestOff() {
+  const Frame off = frame::Frame(kFirst, /*off=*/true);
+  Display display;
+  display.buffer = &off;
+  for (uint64_t cycle = 0; cycle < 5 * kRefreshCycles; ++cycle) {
+    display.Step();
+    Expect("off", cycle, display.selected(), 0);
+  }
+  if (display.chain.latches < 5 * frame::kDigits) {
+    Fail("off latches", 0, display.chain.latches, 5 * frame::kDigits);
+  }
+}
+
+}  // namespace
+
+int main() {
+  static_assert(frame::Frequency(500) == 500 * kRefreshCycles);
+  TestRefresh();
+  TestOff();
+  printf("PASS\n");
+  return 0;
+}
@@ -4,10 +4,12 @@
 #include <array>
 #include <cstdint>
 #include <functional>
+#include <optional>
 #include <utility>
 
 #include "FreeRTOS.h"
-#include "event_groups.h"
+#include "freertosxx/notify.h"
+#include "freertosxx/tasks.h"
 #include "jagspico/cd74hc595.h"
 #include "queue.h"
 #include "task.h"
@@ -38,6 +40,10 @@ class Disp4Digit {
     // Called each time the display refreshes. Avoid blocking
     // in this function to keep the display responsive.
     std::move_only_function<DisplayValue()> get_content_callback;
+
+    // The cores the refresh task may run on. Keep it off the tcpip thread's
+    // core so that network traffic does not make the display flicker.
+    UBaseType_t cores = freertosxx::kCore1;
   };
 
   Disp4Digit(Config&& config);
@@ -45,6 +51,10 @@ class Disp4Digit {
   Disp4Digit(const Disp4Digit&) = delete;
   Disp4Digit& operator=(const Disp4Digit&) = delete;
 
+  // The segments to light on each digit for value, most significant digit
+  // first, with bit 0 for segment a and bit 7 for the decimal point.
+  static std::array<uint8_t, 4> Segments(const DisplayValue& value);
+
  private:
   // Converts a digit to a mask for display on the 4-digit display.
   static uint8_t DigitToMask(uint8_t digit, bool decimal_after);
@@ -56,7 +66,9 @@ class Disp4Digit {
   const uint32_t pin_select_;
   std::move_only_function<DisplayValue()> callback_;
 
-  EventGroupHandle_t shutdown_event_ = xEventGroupCreate();
+  // Bound to the drive task once it is created.
+  freertosxx::BinarySignal stop_{nullptr};
+  std::optional<freertosxx::StaticTask<256>> drive_task_;
 };
 
 }  // namespace jagspico
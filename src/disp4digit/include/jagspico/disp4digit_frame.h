@@ -0,0 +1,58 @@
+#ifndef JAGSPICO_DISP4DIGIT_DISP4DIGIT_FRAME_H
+#define JAGSPICO_DISP4DIGIT_DISP4DIGIT_FRAME_H
+
+#include <array>
+#include <cstdint>
+
+// The frame buffer that Disp4DigitPio loops over with DMA, and the timing of
+// disp4digit.pio. Hardware-free so that host tests can share it.
+namespace jagspico::disp4digit_frame {
+
+inline constexpr int kDigits = 4;
+
+// Bits the state machine takes from each word: the segments, then the
+// instruction that selects the digit.
+inline constexpr int kPullThreshold = 24;
+
+// Extra cycles the select instruction holds its digit for; the most that
+// fits next to two side-set bits.
+inline constexpr int kHoldDelay = 7;
+
+// State machine cycles per digit: set x, two per segment bit, blank, latch,
+// and the select instruction with its delay.
+inline constexpr int kCyclesPerDigit = 1 + 2 * 8 + 1 + 1 + 1 + kHoldDelay;
+// Of which the digit is lit for all but the blank and the latch.
+inline constexpr int kLitCycles = kCyclesPerDigit - 2;
+
+// The clock the state machine needs to show every digit refresh_hz times a
+// second.
+constexpr uint32_t Frequency(uint32_t refresh_hz) {
+  return refresh_hz * kDigits * kCyclesPerDigit;
+}
+
+// SET PINS, select with side-set 0 and the hold delay, which pioasm would
+// encode as "set pins, select side 0 [7]". select has a bit per digit, the
+// most significant digit first, and is active low.
+constexpr uint16_t SelectInstruction(uint32_t select) {
+  return 0xe000 | kHoldDelay << 8 | (select & 0xf);
+}
+
+// The word that shows segments on digit, 0 being the most significant, or
+// on none if off. Shifted to the top, as Cd74Hc595DriverPio::Encode would
+// for 24 output bits.
+constexpr uint32_t Word(uint8_t segments, int digit, bool off) {
+  const uint32_t select = off ? 0xf : 0xf & ~(1u << digit);
+  return (uint32_t{segments} << 16 | SelectInstruction(select)) << 8;
+}
+
+// A whole frame buffer, segments being the most significant digit first.
+constexpr std::array<uint32_t, kDigits> Frame(
+    const std::array<uint8_t, kDigits>& segments, bool off) {
+  std::array<uint32_t, kDigits> words;
+  for (int i = 0; i < kDigits; ++i) words[i] = Word(segments[i], i, off);
+  return words;
+}
+
+}  // namespace jagspico::disp4digit_frame
+
+#endif  // JAGSPICO_DISP4DIGIT_DISP4DIGIT_FRAME_H
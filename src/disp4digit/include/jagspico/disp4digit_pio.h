@@ -0,0 +1,66 @@
+#ifndef JAGSPICO_DISP4DIGIT_DISP4DIGIT_PIO_H
+#define JAGSPICO_DISP4DIGIT_DISP4DIGIT_PIO_H
+
+#include <cstdint>
+#include <optional>
+
+#include "hardware/pio.h"
+#include "jagspico/cd74hc595.h"
+#include "jagspico/cd74hc595_dma_loop.h"
+#include "jagspico/disp4digit.h"
+
+namespace jagspico {
+
+// Drives the same display as Disp4Digit, but refreshes it with no CPU at
+// all: a PIO program shifts each digit's segments into the Cd74Hc595 and
+// drives the select lines, and DMA loops over a frame buffer of one word
+// per digit. The CPU only touches the display when Set changes the value,
+// so the refresh rate does not depend on the scheduler.
+//
+// Takes a state machine and two DMA channels, and 5 instructions of the
+// PIO block's memory.
+class Disp4DigitPio {
+ public:
+  struct Config {
+    PIO pio;
+    // The Cd74Hc595's pins, as for Cd74Hc595DriverPio: pin_rclk must be
+    // pin_srclk + 1.
+    int pin_srclk = -1;
+    int pin_ser = -1;
+
+    // The select pin for the most significant digit.
+    // The less significant digits will be the 3 following pins.
+    uint32_t pin_select = 12;
+
+    // How many times a second each digit is shown, from 18 Hz up.
+    uint32_t refresh_hz = 500;
+  };
+
+  Disp4DigitPio(Disp4DigitPio&& o);
+  Disp4DigitPio(const Disp4DigitPio&) = delete;
+  Disp4DigitPio& operator=(const Disp4DigitPio&) = delete;
+
+  // Turns every digit off.
+  ~Disp4DigitPio();
+
+  // Claims the resources and starts refreshing, with every digit off.
+  // Returns nullopt if the PIO block or the DMA has run out of them.
+  static std::optional<Disp4DigitPio> Create(const Config& config);
+
+  // Shows value within three refreshes: DMA picks it up at the end of the
+  // current one, and the TX FIFO holds two more of the old value. May wait
+  // for up to one refresh for DMA to finish with the buffer it reuses, which
+  // other tasks can run during, unless value is already showing.
+  void Set(const Disp4Digit::DisplayValue& value);
+
+ private:
+  Disp4DigitPio(Cd74Hc595DriverPio driver, const Config& config);
+
+  Cd74Hc595DmaLoop loop_;
+  Cd74Hc595DriverPio driver_;
+  PIO pio_;
+};
+
+}  // namespace jagspico
+
+#endif  // JAGSPICO_DISP4DIGIT_DISP4DIGIT_PIO_H
@@ -0,0 +1,203 @@
+#include "freertosxx/executor.h"
+
+#include <algorithm>
+
+#include "FreeRTOS.h"
+#include "freertosxx/critical_section.h"
+#include "semphr.h"
+#include "task.h"
+
+namespace freertosxx {
+
+namespace {
+
+constexpr const char* kWorkerNames[] = {"executor0", "executor1"};
+static_assert(std::size(kWorkerNames) >= Executor::kWorkers);
+
+}  // namespace
+
+Executor::Executor(Options options) {
+  for (JobNode& job : jobs_) {
+    job.next = free_;
+    free_ = &job;
+  }
+  for (int i = 0; i < kWorkers; ++i) {
+    Worker& worker = workers_[i];
+    worker.task.emplace(
+        Task::Options{
+            .name = kWorkerNames[i],
+            .priority = options.priority,
+            .cores = kWorkers > 1 ? UBaseType_t{1} << i : kAnyCore,
+        },
+        options.stack_words,
+        [this, &worker] { Work(worker); });
+  }
+}
+
+Executor::~Executor() {
+  stopping_ = true;
+  for (Worker& worker : workers_) {
+    worker.waiter.Notify();
+    worker.task->Join();
+  }
+}
+
+bool Executor::Submit(Job fn) {
+  JobNode* job = AllocateJob();
+  if (job == nullptr) return false;
+  job->fn = std::move(fn);
+  Worker* self = CurrentWorker();
+  // The deque holds every job, so it is never full.
+  if (self != nullptr && self->deque.Push(job)) {
+    WakeWorkers(self);
+    return true;
+  }
+  {
+    CriticalSection critical_section;
+    job->next = nullptr;
+    (shared_tail_ != nullptr ? shared_tail_->next : shared_head_) = job;
+    shared_tail_ = job;
+  }
+  WakeWorkers(nullptr);
+  return true;
+}
+
+Executor::Stats Executor::stats() const {
+  CriticalSection critical_section;
+  return Stats{
+      .submitted = submitted_,
+      .stolen = stolen_.load(std::memory_order_relaxed),
+      .failures = failures_,
+      .in_use = in_use_,
+      .high_water = high_water_,
+  };
+}
+
+void Executor::ParallelFor(
+    size_t count, size_t grain, void (*body)(void*, size_t, size_t),
+    void* fn) {
+  struct Loop {
+    size_t count;
+    size_t grain;
+    void (*body)(void*, size_t, size_t);
+    void* fn;
+    std::atomic<size_t> next = 0;
+    // Given by each helper when it is done with the loop.
+    StaticSemaphore_t done_storage;
+    SemaphoreHandle_t done;
+
+    void Run() {
+      for (size_t begin = next.fetch_add(grain); begin < count;
+           begin = next.fetch_add(grain)) {
+        body(fn, begin, std::min(begin + grain, count));
+      }
+    }
+  };
+  Loop loop{.count = count, .grain = grain, .body = body, .fn = fn};
+  loop.done = xSemaphoreCreateCountingStatic(kWorkers, 0, &loop.done_storage);
+
+  // One helper per other runner, unless there are too few ranges to share.
+  Worker* self = CurrentWorker();
+  const size_t ranges = (count + grain - 1) / grain;
+  const int helpers = std::min<size_t>(
+      kWorkers - (self != nullptr ? 1 : 0), ranges > 0 ? ranges - 1 : 0);
+  int pending = 0;
+  for (int i = 0; i < helpers; ++i) {
+    if (Submit([&loop] {
+          loop.Run();
+          xSemaphoreGive(loop.done);
+        })) {
+      ++pending;
+    }
+  }
+
+  loop.Run();
+  while (pending > 0) {
+    // A worker runs other jobs meanwhile, in case its helper is among them.
+    const bool helped = self != nullptr && RunOne(self);
+    const TickType_t timeout = self == nullptr ? portMAX_DELAY : helped ? 0 : 1;
+    if (xSemaphoreTake(loop.done, timeout) == pdTRUE) --pending;
+  }
+  vSemaphoreDelete(loop.done);
+}
+
+void Executor::Work(Worker& self) {
+  self.waiter.Attach();
+  while (!stopping_) {
+    if (RunOne(&self)) continue;
+    self.waiter.Wait([&] { return stopping_ || HasWork(); });
+  }
+  // Runs the jobs that are still queued rather than dropping them, since
+  // whoever submitted them may be waiting, like ParallelFor for its helpers.
+  while (RunOne(nullptr)) {
+  }
+}
+
+bool Executor::RunOne(Worker* self) {
+  JobNode* job = nullptr;
+  if (self != nullptr) job = self->deque.Pop().value_or(nullptr);
+  if (job == nullptr) {
+    CriticalSection critical_section;
+    job = shared_head_;
+    if (job != nullptr) {
+      shared_head_ = job->next;
+      if (shared_head_ == nullptr) shared_tail_ = nullptr;
+    }
+  }
+  for (Worker& other : workers_) {
+    if (job != nullptr) break;
+    if (&other == self) continue;
+    job = other.deque.Steal().value_or(nullptr);
+    if (job != nullptr) stolen_.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (job == nullptr) return false;
+  job->fn();
+  FreeJob(job);
+  return true;
+}
+
+bool Executor::HasWork() const {
+  {
+    CriticalSection critical_section;
+    if (shared_head_ != nullptr) return true;
+  }
+  return std::ranges::any_of(
+      workers_, [](const Worker& worker) { return !worker.deque.empty(); });
+}
+
+Executor::Worker* Executor::CurrentWorker() {
+  const TaskHandle_t current = xTaskGetCurrentTaskHandle();
+  for (Worker& worker : workers_) {
+    if (worker.task && worker.task->handle() == current) return &worker;
+  }
+  return nullptr;
+}
+
+void Executor::WakeWorkers(const Worker* except) {
+  for (Worker& worker : workers_) {
+    if (&worker != except) worker.waiter.Notify();
+  }
+}
+
+Executor::JobNode* Executor::AllocateJob() {
+  CriticalSection critical_section;
+  JobNode* job = free_;
+  if (job == nullptr) {
+    ++failures_;
+    return nullptr;
+  }
+  free_ = job->next;
+  ++submitted_;
+  high_water_ = std::max(high_water_, ++in_use_);
+  return job;
+}
+
+void Executor::FreeJob(JobNode* job) {
+  job->fn = nullptr;
+  CriticalSection critical_section;
+  job->next = free_;
+  free_ = job;
+  --in_use_;
+}
+
+}  // namespace freertosxx
@@ -0,0 +1,167 @@
+#include "freertosxx/executor.h"
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+
+#include "FreeRTOS.h"
+#include "freertosxx/notify.h"
+#include "freertosxx/tasks.h"
+#include "pico/platform.h"
+#include "pico/printf.h"
+#include "task.h"
+#include "util/expect.h"
+
+using freertosxx::CountingSignal;
+using freertosxx::Executor;
+using freertosxx::Task;
+using jagspico::Expect;
+
+namespace {
+
+void TestSubmit(Executor& executor) {
+  constexpr int kJobs = 20;
+  CountingSignal done;
+  std::atomic<int> sum = 0;
+  for (int i = 0; i < kJobs; ++i) {
+    Expect(executor.Submit([&, i] {
+      sum += i;
+      done.Give();
+    }),
+           "submitted");
+  }
+  for (int i = 0; i < kJobs; ++i) {
+    Expect(done.Wait({.timeout = pdMS_TO_TICKS(1000)}) == 1, "job ran");
+  }
+  Expect(sum == kJobs * (kJobs - 1) / 2, "every job ran once");
+}
+
+void TestParallelFor(Executor& executor) {
+  constexpr size_t kCount = 10'000;
+  static std::atomic<uint8_t> visits[kCount];
+  for (auto& v : visits) v = 0;
+  executor.ParallelFor(kCount, 64, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) ++visits[i];
+  });
+  for (const auto& v : visits) Expect(v == 1, "every index visited once");
+
+  bool ran = false;
+  executor.ParallelFor(0, 1, [&](size_t, size_t) { ran = true; });
+  Expect(!ran, "empty range");
+}
+
+void TestNested(Executor& executor) {
+  // A worker waiting in ParallelFor must keep running jobs, or the two
+  // workers could end up waiting on each other.
+  CountingSignal done;
+  std::atomic<int> total = 0;
+  for (int job = 0; job < Executor::kWorkers * 2; ++job) {
+    Expect(executor.Submit([&] {
+      executor.ParallelFor(100, 1, [&](size_t begin, size_t end) {
+        total += end - begin;
+      });
+      done.Give();
+    }),
+           "submitted");
+  }
+  for (int job = 0; job < Executor::kWorkers * 2; ++job) {
+    Expect(done.Wait({.timeout = pdMS_TO_TICKS(5000)}) == 1, "nested done");
+  }
+  Expect(total == Executor::kWorkers * 2 * 100, "nested total");
+}
+
+void TestStealing(Executor& executor) {
+  if (Executor::kWorkers < 2) return;
+  // The spawning job keeps its worker busy, so only the other worker can
+  // run the jobs it pushed onto its own deque.
+  constexpr int kChildren = 8;
+  CountingSignal done;
+  std::atomic<int> ran = 0;
+  const uint32_t stolen_before = executor.stats().stolen;
+  Expect(executor.Submit([&] {
+    for (int i = 0; i < kChildren; ++i) {
+      executor.Submit([&] { ++ran; });
+    }
+    while (ran < kChildren) vTaskDelay(1);
+    done.Give();
+  }),
+         "submitted");
+  Expect(done.Wait({.timeout = pdMS_TO_TICKS(1000)}) == 1, "children ran");
+  Expect(executor.stats().stolen - stolen_before >= kChildren, "stolen");
+}
+
+void TestExhaustion(Executor& executor) {
+  // Jobs free their node just after they signal that they are done.
+  while (executor.stats().in_use != 0) vTaskDelay(1);
+  std::atomic<bool> open = false;
+  CountingSignal done;
+  int submitted = 0;
+  while (executor.Submit([&] {
+    while (!open) vTaskDelay(1);
+    done.Give();
+  })) {
+    ++submitted;
+  }
+  Expect(submitted == Executor::kMaxJobs, "pool exhausted");
+  Expect(executor.stats().failures == 1, "failure counted");
+  open = true;
+  for (int i = 0; i < submitted; ++i) {
+    Expect(done.Wait({.timeout = pdMS_TO_TICKS(1000)}) == 1, "gated job");
+  }
+}
+
+void TestStop() {
+  // Both workers are held up while another task's ParallelFor submits its
+  // helpers, and the executor is destroyed before they run. The helpers must
+  // still run, or ParallelFor never returns.
+  std::optional<Executor> executor(std::in_place);
+  std::atomic<bool> open = false;
+  for (int i = 0; i < Executor::kWorkers; ++i) {
+    Expect(executor->Submit([&] {
+      while (!open) vTaskDelay(1);
+    }),
+           "submitted");
+  }
+  constexpr size_t kCount = 100;
+  std::atomic<size_t> visited = 0;
+  CountingSignal done;
+  Task caller({.name = "caller"}, 512, [&] {
+    executor->ParallelFor(kCount, 1, [&](size_t begin, size_t end) {
+      visited += end - begin;
+    });
+    done.Give();
+  });
+  while (executor->stats().in_use < 2 * Executor::kWorkers) vTaskDelay(1);
+  // Lets the workers go once the destructor has told them to stop.
+  Task opener({.name = "opener"}, 256, [&] {
+    vTaskDelay(pdMS_TO_TICKS(50));
+    open = true;
+  });
+  executor.reset();
+  Expect(done.Wait({.timeout = pdMS_TO_TICKS(1000)}) == 1, "stopped loop");
+  Expect(visited == kCount, "stopped loop visited every index");
+  caller.Join();
+  opener.Join();
+}
+
+}  // namespace
+
+extern "C" void main_task(void*) {
+  {
+    Executor executor;
+    TestSubmit(executor);
+    TestParallelFor(executor);
+    TestNested(executor);
+    TestStealing(executor);
+    TestExhaustion(executor);
+    const Executor::Stats stats = executor.stats();
+    printf(
+        "%lu submitted, %lu stolen, %u max in use\n",
+        stats.submitted,
+        stats.stolen,
+        stats.high_water);
+  }
+  TestStop();
+  printf("PASS\n");
+  vTaskDelete(nullptr);
+}
@@ -0,0 +1,72 @@
+#include "freertosxx/future.h"
+
+#include <cstdint>
+#include <utility>
+
+#include "FreeRTOS.h"
+#include "freertosxx/critical_section.h"
+#include "task.h"
+
+namespace freertosxx {
+namespace internal {
+
+FuturePools g_future_pools("futures");
+
+FutureStateBase::Status FutureStateBase::status() const {
+  CriticalSection critical_section;
+  return status_;
+}
+
+FutureStateBase::Status FutureStateBase::Wait(TickType_t timeout) {
+  TimeOut_t timeout_state;
+  vTaskSetTimeOutState(&timeout_state);
+  Status status;
+  while (true) {
+    {
+      CriticalSection critical_section;
+      status = status_;
+      if (status != Status::kPending ||
+          xTaskCheckForTimeOut(&timeout_state, &timeout) == pdTRUE) {
+        waiter_ = nullptr;
+        break;
+      }
+      waiter_ = xTaskGetCurrentTaskHandle();
+    }
+    ulTaskNotifyTakeIndexed(kFutureNotifyIndex, pdTRUE, timeout);
+  }
+  // Complete only gives while waiter_ is set, so nothing can arrive now.
+  // Drops a give that came after the last take, so that it doesn't cut the
+  // next wait short.
+  ulTaskNotifyValueClearIndexed(nullptr, kFutureNotifyIndex, UINT32_MAX);
+  return status;
+}
+
+void FutureStateBase::OnComplete(std::move_only_function<void()> fn) {
+  {
+    CriticalSection critical_section;
+    if (status_ == Status::kPending) {
+      continuation_ = std::move(fn);
+      return;
+    }
+  }
+  fn();
+}
+
+void FutureStateBase::Complete(Status status) {
+  std::move_only_function<void()> continuation;
+  {
+    CriticalSection critical_section;
+    status_ = status;
+    continuation = std::move(continuation_);
+    // Gives inside the critical section, so that a waiter that has timed
+    // out and cleared waiter_ is never given to.
+    if (waiter_ != nullptr) {
+      xTaskNotifyGiveIndexed(
+          std::exchange(waiter_, nullptr), kFutureNotifyIndex);
+    }
+  }
+  if (continuation) continuation();
+}
+
+}  // namespace internal
+}  // namespace freertosxx
@@ -0,0 +1,159 @@
+#include "freertosxx/future.h"
+
+#include <atomic>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <variant>
+
+#include "FreeRTOS.h"
+#include "freertosxx/executor.h"
+#include "freertosxx/notify.h"
+#include "freertosxx/tasks.h"
+#include "pico/platform.h"
+#include "pico/printf.h"
+#include "task.h"
+#include "util/expect.h"
+
+using freertosxx::Executor;
+using freertosxx::Future;
+using freertosxx::Promise;
+using jagspico::Expect;
+
+namespace {
+
+void TestGet() {
+  Promise<int> promise;
+  Future<int> future = promise.GetFuture();
+  Expect(!future.ready(), "not ready");
+  Expect(!future.Get({.timeout = pdMS_TO_TICKS(10)}), "timeout");
+  Expect(future.valid(), "valid after timeout");
+
+  freertosxx::Task setter({.name = "setter"}, 256, [&] {
+    vTaskDelay(pdMS_TO_TICKS(10));
+    promise.Set(42);
+  });
+  Expect(future.Get({.timeout = pdMS_TO_TICKS(1000)}) == 42, "value");
+  Expect(!future.valid(), "consumed");
+  setter.Join();
+
+  Expect(
+      freertosxx::MakeReadyFuture(std::string("ready")).Get() == "ready",
+      "ready future");
+}
+
+void TestAlongsideSignal() {
+  // A signal at the default index and a future wait on the same task don't
+  // take each other's notifications.
+  freertosxx::BinarySignal signal;
+  Promise<int> promise;
+  Future<int> future = promise.GetFuture();
+  freertosxx::Task setter({.name = "setter"}, 256, [&] {
+    signal.Give();
+    vTaskDelay(pdMS_TO_TICKS(10));
+    promise.Set(1);
+  });
+  Expect(future.Get({.timeout = pdMS_TO_TICKS(1000)}) == 1, "future value");
+  Expect(signal.Wait({.timeout = 0}), "signal kept its give");
+  setter.Join();
+
+}
+
+void TestBroken() {
+  Future<int> future;
+  {
+    Promise<int> promise;
+    future = promise.GetFuture();
+  }
+  Expect(future.ready(), "broken is ready");
+  Expect(!future.Get(), "broken has no value");
+  Expect(!future.valid(), "broken is invalid");
+}
+
+void TestThen(Executor& executor) {
+  Promise<int> promise;
+  Future<std::string> future =
+      promise.GetFuture()
+          .Then(executor, [](int x) { return x * 2; })
+          .Then(executor, [](int x) { return std::to_string(x); });
+  promise.Set(21);
+  Expect(future.Get({.timeout = pdMS_TO_TICKS(1000)}) == "42", "chained");
+
+  std::atomic<bool> ran = false;
+  Future<std::monostate> done =
+      freertosxx::MakeReadyFuture(1).Then(executor, [&](int) { ran = true; });
+  Expect(done.Get({.timeout = pdMS_TO_TICKS(1000)}).has_value(), "void then");
+  Expect(ran, "void then ran");
+
+  Future<int> broken = Promise<int>().GetFuture().Then(executor, [](int x) {
+    return x;
+  });
+  Expect(!broken.Get({.timeout = pdMS_TO_TICKS(1000)}), "broken then");
+}
+
+void TestWhenAll() {
+  Promise<int> a;
+  Promise<std::string> b;
+  Future<std::tuple<int, std::string>> all =
+      freertosxx::WhenAll(a.GetFuture(), b.GetFuture());
+  b.Set("b");
+  Expect(!all.ready(), "waits for every future");
+  a.Set(1);
+  std::optional<std::tuple<int, std::string>> values = all.Get();
+  Expect(values && std::get<0>(*values) == 1, "first value");
+  Expect(values && std::get<1>(*values) == "b", "second value");
+
+  Promise<int> c;
+  Future<std::tuple<int, int>> broken = freertosxx::WhenAll(
+      c.GetFuture(), Promise<int>().GetFuture());
+  c.Set(1);
+  Expect(!broken.Get(), "all broken");
+}
+
+void TestWhenAny() {
+  Promise<int> a;
+  Promise<int> b;
+  Future<std::variant<int, int>> any =
+      freertosxx::WhenAny(a.GetFuture(), b.GetFuture());
+  b.Set(2);
+  a.Set(1);
+  std::optional<std::variant<int, int>> first = any.Get();
+  Expect(first && first->index() == 1, "second won");
+  Expect(first && std::get<1>(*first) == 2, "second value");
+
+  Promise<int> c;
+  Future<std::variant<int, int>> one_broken =
+      freertosxx::WhenAny(Promise<int>().GetFuture(), c.GetFuture());
+  Expect(!one_broken.ready(), "one broken is not enough");
+  c.Set(3);
+  Expect(one_broken.Get().has_value(), "other value");
+
+  Future<std::variant<int>> broken =
+      freertosxx::WhenAny(Promise<int>().GetFuture());
+  Expect(!broken.Get(), "any broken");
+}
+
+}  // namespace
+
+extern "C" void main_task(void*) {
+  {
+    Executor executor;
+    TestGet();
+    TestAlongsideSignal();
+    TestBroken();
+    TestThen(executor);
+    TestWhenAll();
+    TestWhenAny();
+  }
+  size_t in_use = 0;
+  freertosxx::UntypedBlockPool::VisitStats(
+      [&](const freertosxx::PoolStats& stats) {
+        if (std::string_view(stats.name).starts_with("futures/")) {
+          in_use += stats.in_use;
+        }
+      });
+  Expect(in_use == 0, "every state freed");
+  printf("PASS\n");
+  vTaskDelete(nullptr);
+}
@@ -0,0 +1,116 @@
+#ifndef FREERTOSXX_ARENA_H
+#define FREERTOSXX_ARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "pico/platform.h"
+
+namespace freertosxx {
+
+// A bump allocator over a fixed buffer, for scratch memory that is all freed
+// at once, e.g. while building and sending a message. Allocation is a few
+// instructions and freeing an individual allocation does nothing; an
+// ArenaScope frees everything allocated during its lifetime.
+//
+// An arena belongs to one task at a time.
+class Arena {
+ public:
+  Arena(std::byte* storage, size_t size) : storage_(storage), size_(size) {}
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  // Returns nullptr if the arena has no room.
+  void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+    const uintptr_t base = reinterpret_cast<uintptr_t>(storage_);
+    const size_t start = (base + used_ + alignment - 1) / alignment *
+                             alignment -
+                         base;
+    if (start + size > size_) {
+      ++failures_;
+      return nullptr;
+    }
+    used_ = start + size;
+    high_water_ = std::max(high_water_, used_);
+    return storage_ + start;
+  }
+
+  // Frees everything. Prefer an ArenaScope.
+  void Reset() { used_ = 0; }
+
+  size_t used() const { return used_; }
+  size_t capacity() const { return size_; }
+  // The most bytes ever in use at once.
+  size_t high_water() const { return high_water_; }
+  // Allocations that found the arena full.
+  uint32_t failures() const { return failures_; }
+
+ private:
+  friend class ArenaScope;
+
+  std::byte* const storage_;
+  const size_t size_;
+  size_t used_ = 0;
+  size_t high_water_ = 0;
+  uint32_t failures_ = 0;
+};
+
+template <size_t Size>
+class StaticArena : public Arena {
+ public:
+  StaticArena() : Arena(storage_, Size) {}
+
+ private:
+  alignas(std::max_align_t) std::byte storage_[Size];
+};
+
+// Frees everything allocated from arena during its lifetime when it is
+// destroyed. Scopes nest. Objects in the arena are not destroyed, so destroy
+// any that need it before the scope ends.
+class ArenaScope {
+ public:
+  explicit ArenaScope(Arena& arena) : arena_(arena), mark_(arena.used_) {}
+  ~ArenaScope() { arena_.used_ = mark_; }
+  ArenaScope(const ArenaScope&) = delete;
+  ArenaScope& operator=(const ArenaScope&) = delete;
+
+ private:
+  Arena& arena_;
+  const size_t mark_;
+};
+
+// A std allocator that allocates from an Arena. Running out of room is
+// fatal, since a std allocator cannot fail without exceptions; size the
+// arena with its high_water.
+template <typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+
+  explicit ArenaAllocator(Arena& arena) : arena_(&arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& o) : arena_(o.arena_) {}
+
+  T* allocate(size_t n) {
+    void* p = arena_->Allocate(n * sizeof(T), alignof(T));
+    if (p == nullptr) panic("arena full: %u bytes", n * sizeof(T));
+    return static_cast<T*>(p);
+  }
+  void deallocate(T*, size_t) {}
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U>& o) const {
+    return arena_ == o.arena_;
+  }
+
+ private:
+  template <typename U>
+  friend class ArenaAllocator;
+
+  Arena* arena_;
+};
+
+}  // namespace freertosxx
+
+#endif  // FREERTOSXX_ARENA_H
@@ -0,0 +1,34 @@
+#ifndef FREERTOSXX_CRITICAL_SECTION_H
+#define FREERTOSXX_CRITICAL_SECTION_H
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+namespace freertosxx {
+
+// Holds a FreeRTOS critical section, which excludes tasks and ISRs on both
+// cores, for its lifetime. Tasks only.
+//
+// Before the scheduler starts there is only one thread of execution, and a
+// critical section entered then would leave interrupts masked until it
+// starts, so this does nothing then. That makes it safe in the constructors
+// of globals.
+class CriticalSection {
+ public:
+  CriticalSection()
+      : active_(xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED) {
+    if (active_) taskENTER_CRITICAL();
+  }
+  ~CriticalSection() {
+    if (active_) taskEXIT_CRITICAL();
+  }
+  CriticalSection(const CriticalSection&) = delete;
+  CriticalSection& operator=(const CriticalSection&) = delete;
+
+ private:
+  const bool active_;
+};
+
+}  // namespace freertosxx
+
+#endif  // FREERTOSXX_CRITICAL_SECTION_H
@@ -0,0 +1,129 @@
+#ifndef FREERTOSXX_EXECUTOR_H
+#define FREERTOSXX_EXECUTOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <utility>
+
+#include "FreeRTOS.h"
+#include "freertosxx/ring_wait.h"
+#include "freertosxx/tasks.h"
+#include "freertosxx/work_deque.h"
+
+namespace freertosxx {
+
+// Runs short, CPU-bound jobs on one worker task per core, for work that can
+// be split up, like filtering a batch of samples or formatting payloads.
+//
+// Each worker has a work-stealing deque. Jobs that a worker submits go on
+// its own deque, where it runs them newest first; an idle worker steals the
+// oldest jobs from the other's. Jobs submitted by other tasks go on a shared
+// queue that every worker takes from. Jobs come from a fixed pool of
+// kMaxJobs, so submitting allocates nothing, as long as the job's captures
+// fit in std::move_only_function's small buffer.
+//
+// Jobs must not block for long: a blocked job holds up its worker.
+class Executor {
+ public:
+  static constexpr int kMaxJobs = 32;
+  static constexpr int kWorkers = configNUMBER_OF_CORES;
+
+  using Job = std::move_only_function<void()>;
+
+  struct Options {
+    Priority priority = Priority::kNormal;
+    size_t stack_words = 512;
+  };
+
+  explicit Executor(Options options);
+  Executor() : Executor(Options{}) {}
+  // Runs the jobs that are still queued, then stops the workers.
+  ~Executor();
+  Executor(const Executor&) = delete;
+  Executor& operator=(const Executor&) = delete;
+
+  // Runs fn on a worker. Returns false without running it if every job is
+  // in use.
+  bool Submit(Job fn);
+
+  // Calls fn(begin, end) for consecutive ranges of at most grain indices
+  // that cover [0, count), on every worker and the calling task at once, and
+  // returns once every call has returned. Ranges are handed out as each
+  // runner finishes its last, so uneven ranges balance out.
+  //
+  // May be called from a job: the worker runs other jobs while it waits.
+  template <typename Fn>
+  void ParallelFor(size_t count, size_t grain, Fn&& fn) {
+    ParallelFor(
+        count,
+        std::max<size_t>(grain, 1),
+        +[](void* fn, size_t begin, size_t end) {
+          (*static_cast<std::remove_reference_t<Fn>*>(fn))(begin, end);
+        },
+        &fn);
+  }
+
+  struct Stats {
+    uint32_t submitted;
+    // Jobs a worker took from the other worker's deque.
+    uint32_t stolen;
+    // Submits that found every job in use.
+    uint32_t failures;
+    // Jobs submitted and not yet finished.
+    size_t in_use;
+    // The most jobs ever in use at once.
+    size_t high_water;
+  };
+  Stats stats() const;
+
+ private:
+  struct JobNode {
+    JobNode* next = nullptr;
+    Job fn;
+  };
+
+  struct Worker {
+    WorkDeque<JobNode*, kMaxJobs> deque;
+    TaskNotifyWaiter waiter;
+    std::optional<Task> task;
+  };
+
+  void ParallelFor(
+      size_t count, size_t grain, void (*body)(void*, size_t, size_t),
+      void* fn);
+
+  void Work(Worker& self);
+  // Finds a job and runs it. self is the calling worker, if it is one.
+  // Returns false if there was nothing to run.
+  bool RunOne(Worker* self);
+  // Whether there may be a job for a worker to run.
+  bool HasWork() const;
+  Worker* CurrentWorker();
+  void WakeWorkers(const Worker* except);
+
+  JobNode* AllocateJob();
+  void FreeJob(JobNode* job);
+
+  JobNode jobs_[kMaxJobs];
+  Worker workers_[kWorkers];
+  std::atomic<bool> stopping_ = false;
+
+  // The following are guarded by a critical section.
+  JobNode* free_ = nullptr;
+  // Jobs from tasks other than the workers, oldest first.
+  JobNode* shared_head_ = nullptr;
+  JobNode* shared_tail_ = nullptr;
+  size_t in_use_ = 0;
+  size_t high_water_ = 0;
+  uint32_t submitted_ = 0;
+  uint32_t failures_ = 0;
+  std::atomic<uint32_t> stolen_ = 0;
+};
+
+}  // namespace freertosxx
+
+#endif  // FREERTOSXX_EXECUTOR_H
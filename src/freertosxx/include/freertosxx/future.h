@@ -0,0 +1,340 @@
+#ifndef FREERTOSXX_FUTURE_H
+#define FREERTOSXX_FUTURE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "FreeRTOS.h"
+#include "freertosxx/executor.h"
+#include "freertosxx/notify.h"
+#include "freertosxx/pool.h"
+#include "task.h"
+
+namespace freertosxx {
+
+// One-shot results handed from one task to another, e.g. the outcome of a
+// request that completes on the tcpip thread. A Promise<T> is the writing
+// end, and a Future<T> the reading end, of a shared state that holds a T.
+//
+//   Promise<err_t> promise;
+//   Future<err_t> future = promise.GetFuture();
+//   ... some other task calls promise.Set(ERR_OK) ...
+//   std::optional<err_t> err = future.Get({.timeout = pdMS_TO_TICKS(100)});
+//
+// Shared states come from the "futures" block pools, or the heap if those
+// are exhausted or the state is too large for them; see PrintMemoryStats.
+// A promise destroyed without a value breaks its future, which then never
+// yields one.
+//
+// Promises are set from tasks, not ISRs. OnReady callbacks, and so WhenAll
+// and WhenAny, run on the task that sets the promise; Then's continuations
+// run on an Executor.
+//
+// Get blocks on the calling task's notification at kFutureNotifyIndex, which
+// no signal may use. See notify.h.
+
+template <typename T>
+class Promise;
+template <typename T>
+class Future;
+
+// Selects the overload of an asynchronous call that returns a Future, e.g.
+// MqttClient::Publish(..., use_future).
+struct UseFuture {};
+inline constexpr UseFuture use_future;
+
+namespace internal {
+
+// Index 0 belongs to stream buffers and the last index to signals.
+static_assert(
+    configTASK_NOTIFICATION_ARRAY_ENTRIES >= 3,
+    "futures need a notification index of their own");
+
+using FuturePools = PoolSet<BlockPool<48, 16>, BlockPool<96, 8>>;
+extern FuturePools g_future_pools;
+
+class FutureStateBase {
+ public:
+  enum class Status : uint8_t { kPending, kReady, kBroken };
+
+  FutureStateBase() = default;
+  FutureStateBase(const FutureStateBase&) = delete;
+  FutureStateBase& operator=(const FutureStateBase&) = delete;
+
+  Status status() const;
+
+  // Blocks until the state is not pending or the timeout expires, on the
+  // calling task's notification at kFutureNotifyIndex. Returns the final
+  // status.
+  Status Wait(TickType_t timeout);
+
+  // Calls fn once the state is not pending: right away if it already isn't,
+  // otherwise on the task that completes it.
+  void OnComplete(std::move_only_function<void()> fn);
+
+  // Wakes the waiter, if any, then runs the continuation, if any.
+  void Complete(Status status);
+
+  void Ref() { refs_.fetch_add(1, std::memory_order_relaxed); }
+  // Returns whether this dropped the last reference.
+  bool Unref() { return refs_.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+
+ private:
+  std::atomic<uint8_t> refs_ = 1;
+
+  // The following are guarded by a critical section.
+  Status status_ = Status::kPending;
+  TaskHandle_t waiter_ = nullptr;
+  std::move_only_function<void()> continuation_;
+};
+
+template <typename T>
+class FutureState : public FutureStateBase,
+                    public PoolAllocated<g_future_pools> {
+ public:
+  // Written once, by the promise, before it completes the state.
+  std::optional<T> value;
+};
+
+}  // namespace internal
+
+template <typename T>
+class [[nodiscard]] Future {
+ public:
+  static_assert(!std::is_void_v<T>, "use std::monostate for no value");
+  using value_type = T;
+
+  // An invalid future.
+  Future() = default;
+  Future(Future&& o) : state_(std::exchange(o.state_, nullptr)) {}
+  Future& operator=(Future&& o) {
+    Reset();
+    state_ = std::exchange(o.state_, nullptr);
+    return *this;
+  }
+  ~Future() { Reset(); }
+
+  // Whether this future still refers to a shared state: it has not been
+  // moved from, consumed, or found broken.
+  bool valid() const { return state_ != nullptr; }
+
+  // Whether Get would return without blocking.
+  bool ready() const {
+    return state_ != nullptr &&
+           state_->status() != internal::FutureStateBase::Status::kPending;
+  }
+
+  struct WaitOptions {
+    std::optional<TickType_t> timeout = std::nullopt;
+  };
+  // Waits for the value and takes it. Returns nullopt on timeout, after
+  // which the future is still valid, or if the promise was broken, after
+  // which it is not.
+  std::optional<T> Get(WaitOptions opts) {
+    configASSERT(state_ != nullptr);
+    const auto status = state_->Wait(opts.timeout.value_or(portMAX_DELAY));
+    if (status == internal::FutureStateBase::Status::kPending) {
+      return std::nullopt;
+    }
+    return Take();
+  }
+  std::optional<T> Get() { return Get({}); }
+
+  // Consumes the future and calls fn(std::optional<T>) with its value, or
+  // nullopt if the promise is broken. fn runs on the task that sets the
+  // promise, or right away if it is already set, so it must be short.
+  template <typename Fn>
+  void OnReady(Fn fn) && {
+    configASSERT(state_ != nullptr);
+    internal::FutureState<T>* state = state_;
+    state->OnComplete([self = std::move(*this), fn = std::move(fn)] mutable {
+      fn(self.Take());
+    });
+  }
+
+  // Consumes the future and returns a future of fn(value), which runs as a
+  // job on executor once the value is set. A void fn gives a
+  // Future<std::monostate>. The returned future is broken if this one is,
+  // or if the executor has no free job.
+  template <typename Fn>
+  auto Then(Executor& executor, Fn fn) && {
+    using R = std::invoke_result_t<Fn&, T>;
+    using U = std::conditional_t<std::is_void_v<R>, std::monostate, R>;
+    Promise<U> promise;
+    Future<U> future = promise.GetFuture();
+    std::move(*this).OnReady(
+        [&executor, fn = std::move(fn), promise = std::move(promise)](
+            std::optional<T> value) mutable {
+          if (!value) return;
+          executor.Submit([fn = std::move(fn),
+                           promise = std::move(promise),
+                           value = std::move(*value)] mutable {
+            if constexpr (std::is_void_v<R>) {
+              fn(std::move(value));
+              promise.Set({});
+            } else {
+              promise.Set(fn(std::move(value)));
+            }
+          });
+        });
+    return future;
+  }
+
+ private:
+  friend class Promise<T>;
+
+  explicit Future(internal::FutureState<T>* state) : state_(state) {}
+
+  // Takes the value of a complete state, and drops the state.
+  std::optional<T> Take() {
+    std::optional<T> value = std::move(state_->value);
+    Reset();
+    return value;
+  }
+
+  void Reset() {
+    if (state_ != nullptr && state_->Unref()) delete state_;
+    state_ = nullptr;
+  }
+
+  internal::FutureState<T>* state_ = nullptr;
+};
+
+template <typename T>
+class Promise {
+ public:
+  Promise() : state_(new internal::FutureState<T>) {
+    configASSERT(state_ != nullptr);
+  }
+  Promise(Promise&& o)
+      : state_(std::exchange(o.state_, nullptr)), retrieved_(o.retrieved_) {}
+  Promise& operator=(Promise&& o) {
+    Break();
+    state_ = std::exchange(o.state_, nullptr);
+    retrieved_ = o.retrieved_;
+    return *this;
+  }
+  ~Promise() { Break(); }
+
+  // Returns the future for this promise. May be called once.
+  Future<T> GetFuture() {
+    configASSERT(state_ != nullptr && !retrieved_);
+    retrieved_ = true;
+    state_->Ref();
+    return Future<T>(state_);
+  }
+
+  // Stores the value and wakes the future. May be called once.
+  void Set(T value) {
+    configASSERT(state_ != nullptr);
+    state_->value.emplace(std::move(value));
+    state_->Complete(internal::FutureStateBase::Status::kReady);
+    Release();
+  }
+
+ private:
+  void Break() {
+    if (state_ == nullptr) return;
+    state_->Complete(internal::FutureStateBase::Status::kBroken);
+    Release();
+  }
+
+  void Release() {
+    if (state_->Unref()) delete state_;
+    state_ = nullptr;
+  }
+
+  internal::FutureState<T>* state_;
+  bool retrieved_ = false;
+};
+
+// Returns a future that already holds value.
+template <typename T>
+Future<T> MakeReadyFuture(T value) {
+  Promise<T> promise;
+  Future<T> future = promise.GetFuture();
+  promise.Set(std::move(value));
+  return future;
+}
+
+// Returns a future of every future's value, set once they all are. It is
+// broken if any of them is.
+template <typename... Ts>
+Future<std::tuple<Ts...>> WhenAll(Future<Ts>... futures) {
+  static_assert(sizeof...(Ts) > 0);
+  struct All : PoolAllocated<internal::g_future_pools> {
+    std::tuple<std::optional<Ts>...> values;
+    Promise<std::tuple<Ts...>> promise;
+    std::atomic<size_t> remaining = sizeof...(Ts);
+    std::atomic<bool> broken = false;
+
+    void Done() {
+      if (remaining.fetch_sub(1) != 1) return;
+      if (!broken) {
+        promise.Set(std::apply(
+            [](std::optional<Ts>&... values) {
+              return std::tuple<Ts...>(std::move(*values)...);
+            },
+            values));
+      }
+      delete this;
+    }
+  };
+  All* all = new All;
+  configASSERT(all != nullptr);
+  Future<std::tuple<Ts...>> result = all->promise.GetFuture();
+  [&]<size_t... I>(std::index_sequence<I...>) {
+    (std::move(futures).OnReady([all](std::optional<Ts> value) {
+      if (value) {
+        std::get<I>(all->values) = std::move(value);
+      } else {
+        all->broken = true;
+      }
+      all->Done();
+    }),
+     ...);
+  }(std::index_sequence_for<Ts...>{});
+  return result;
+}
+
+// Returns a future of the first of the futures to be set, as a variant
+// whose index is that future's position. It is broken only if every one of
+// them is.
+template <typename... Ts>
+Future<std::variant<Ts...>> WhenAny(Future<Ts>... futures) {
+  static_assert(sizeof...(Ts) > 0);
+  struct Any : PoolAllocated<internal::g_future_pools> {
+    Promise<std::variant<Ts...>> promise;
+    std::atomic<size_t> remaining = sizeof...(Ts);
+    std::atomic<bool> set = false;
+
+    void Done() {
+      if (remaining.fetch_sub(1) == 1) delete this;
+    }
+  };
+  Any* any = new Any;
+  configASSERT(any != nullptr);
+  Future<std::variant<Ts...>> result = any->promise.GetFuture();
+  [&]<size_t... I>(std::index_sequence<I...>) {
+    (std::move(futures).OnReady([any](std::optional<Ts> value) {
+      if (value && !any->set.exchange(true)) {
+        any->promise.Set(
+            std::variant<Ts...>(std::in_place_index<I>, std::move(*value)));
+      }
+      any->Done();
+    }),
+     ...);
+  }(std::index_sequence_for<Ts...>{});
+  return result;
+}
+
+}  // namespace freertosxx
+
+#endif  // FREERTOSXX_FUTURE_H
@@ -0,0 +1,169 @@
+#ifndef FREERTOSXX_MOVE_QUEUE_H
+#define FREERTOSXX_MOVE_QUEUE_H
+
+#include <cstdint>
+#include <new>
+#include <optional>
+#include <utility>
+
+#include "FreeRTOS.h"
+#include "portmacro.h"
+#include "projdefs.h"
+// FreeRTOS's queue.h. A quoted include would find freertosxx/queue.h, next
+// to this file, first.
+#include <queue.h>
+
+namespace freertosxx {
+
+// A queue that transfers ownership of objects that are not trivially
+// copyable, e.g. std::string or std::unique_ptr.
+//
+// Items live in a pool of Size slots inside the queue. Sending moves (or
+// constructs) the item into a free slot and passes only the slot's index
+// through a FreeRTOS queue; receiving hands back an Item that refers to the
+// slot in place. The slot returns to the pool when the Item is destroyed, so
+// a received Item counts against the queue's capacity until then. Nothing is
+// allocated after construction and payloads are never copied.
+//
+// Senders block while every slot is in use, either queued or held by a
+// receiver. Item handles must not outlive the queue.
+template <typename T, int Size>
+class MoveQueue {
+ public:
+  static_assert(Size > 0 && Size <= UINT8_MAX);
+
+  // A received item. Move-only. Destroys the item and frees its slot on
+  // destruction.
+  class Item {
+   public:
+    Item(Item&& o)
+        : queue_(std::exchange(o.queue_, nullptr)), index_(o.index_) {}
+    Item& operator=(Item&& o) {
+      if (this != &o) {
+        Reset();
+        queue_ = std::exchange(o.queue_, nullptr);
+        index_ = o.index_;
+      }
+      return *this;
+    }
+    Item(const Item&) = delete;
+    Item& operator=(const Item&) = delete;
+    ~Item() { Reset(); }
+
+    T& operator*() const {
+      configASSERT(queue_ != nullptr);
+      return queue_->slots_[index_].value;
+    }
+    T* operator->() const { return &**this; }
+
+    // Destroys the item and returns its slot to the pool early.
+    void Reset() {
+      if (queue_ != nullptr) std::exchange(queue_, nullptr)->Free(index_);
+    }
+
+   private:
+    friend class MoveQueue;
+    Item(MoveQueue* queue, uint8_t index) : queue_(queue), index_(index) {}
+
+    MoveQueue* queue_;
+    uint8_t index_;
+  };
+
+  MoveQueue()
+      : free_(xQueueCreateStatic(
+            Size, sizeof(uint8_t), free_buf_, &free_storage_)),
+        ready_(xQueueCreateStatic(
+            Size, sizeof(uint8_t), ready_buf_, &ready_storage_)) {
+    for (int i = 0; i < Size; ++i) {
+      const uint8_t index = i;
+      xQueueSend(free_, &index, 0);
+    }
+  }
+
+  // Destroys any items that are still queued. All Items must have been
+  // destroyed already.
+  ~MoveQueue() {
+    while (std::optional<Item> item = ReceiveWithTimeout(0)) {
+    }
+    configASSERT(uxQueueMessagesWaiting(free_) == Size);
+    vQueueDelete(ready_);
+    vQueueDelete(free_);
+  }
+
+  MoveQueue(const MoveQueue&) = delete;
+  MoveQueue(MoveQueue&&) = delete;
+  MoveQueue& operator=(const MoveQueue&) = delete;
+  MoveQueue& operator=(MoveQueue&&) = delete;
+
+  void Send(T&& item) { Emplace(std::move(item)); }
+
+  // On timeout, returns false and leaves item untouched.
+  bool SendWithTimeout(int ms, T&& item) {
+    return EmplaceWithTimeout(ms, std::move(item));
+  }
+
+  // Constructs the item directly in its slot.
+  template <typename... Args>
+  void Emplace(Args&&... args) {
+    const bool sent =
+        EmplaceWithTicks(portMAX_DELAY, std::forward<Args>(args)...);
+    configASSERT(sent);
+  }
+
+  template <typename... Args>
+  bool EmplaceWithTimeout(int ms, Args&&... args) {
+    return EmplaceWithTicks(pdMS_TO_TICKS(ms), std::forward<Args>(args)...);
+  }
+
+  Item Receive() {
+    uint8_t index;
+    auto result = xQueueReceive(ready_, &index, portMAX_DELAY);
+    configASSERT(result == pdTRUE);
+    return Item(this, index);
+  }
+
+  std::optional<Item> ReceiveWithTimeout(int ms) {
+    uint8_t index;
+    if (pdTRUE != xQueueReceive(ready_, &index, pdMS_TO_TICKS(ms))) {
+      return std::nullopt;
+    }
+    return Item(this, index);
+  }
+
+  // The number of items waiting to be received.
+  int size() const { return uxQueueMessagesWaiting(ready_); }
+
+ private:
+  union Slot {
+    Slot() {}
+    ~Slot() {}
+    T value;
+  };
+
+  template <typename... Args>
+  bool EmplaceWithTicks(TickType_t ticks, Args&&... args) {
+    uint8_t index;
+    if (pdTRUE != xQueueReceive(free_, &index, ticks)) return false;
+    new (&slots_[index].value) T(std::forward<Args>(args)...);
+    // Cannot block: there are only Size indices in circulation.
+    xQueueSend(ready_, &index, 0);
+    return true;
+  }
+
+  void Free(uint8_t index) {
+    slots_[index].value.~T();
+    xQueueSend(free_, &index, 0);
+  }
+
+  Slot slots_[Size];
+  StaticQueue_t free_storage_;
+  StaticQueue_t ready_storage_;
+  uint8_t free_buf_[Size];
+  uint8_t ready_buf_[Size];
+  QueueHandle_t free_;
+  QueueHandle_t ready_;
+};
+
+}  // namespace freertosxx
+
+#endif  // FREERTOSXX_MOVE_QUEUE_H
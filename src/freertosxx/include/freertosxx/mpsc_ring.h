@@ -0,0 +1,107 @@
+#ifndef FREERTOSXX_MPSC_RING_H
+#define FREERTOSXX_MPSC_RING_H
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+
+#include "freertosxx/spsc_ring.h"
+
+namespace freertosxx {
+
+// A ring for any number of producers and one consumer of trivially copyable
+// items. Producers may be tasks on either core or ISRs; none of the methods
+// block or make kernel calls.
+//
+// Producers claim a slot by advancing the tail with a compare-and-swap, then
+// publish it through the slot's sequence number, so a producer that is
+// interrupted between the two delays only the consumer, never the other
+// producers. This is lock-free on hosts. The Cortex-M0+ has no atomic
+// read-modify-write instructions, so on the RP2040 the compiler's atomic
+// helpers guard the compare-and-swap with a hardware spinlock and interrupts
+// masked for a few cycles.
+template <typename T, int Size>
+class MpscRing {
+ public:
+  static_assert(std::is_trivially_copyable_v<T>);
+  static_assert(Size > 0 && std::has_single_bit(static_cast<unsigned>(Size)));
+
+  MpscRing() {
+    for (uint32_t i = 0; i < Size; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  static constexpr int capacity() { return Size; }
+
+  // Producer side. Returns false if the ring is full.
+  bool TryPush(const T& item) {
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+      cell = &cells_[tail & kMask];
+      const uint32_t sequence = cell->sequence.load(std::memory_order_acquire);
+      const int32_t diff = static_cast<int32_t>(sequence - tail);
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(
+                tail, tail + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        tail = tail_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->item = item;
+    cell->sequence.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Returns false if the ring is empty, or the next item's
+  // producer has claimed its slot but not finished writing it.
+  bool TryPop(T& item) {
+    Cell& cell = cells_[head_ & kMask];
+    if (cell.sequence.load(std::memory_order_acquire) != head_ + 1) {
+      return false;
+    }
+    item = cell.item;
+    cell.sequence.store(head_ + Size, std::memory_order_release);
+    ++head_;
+    return true;
+  }
+
+  size_t TryPopMany(std::span<T> out) {
+    size_t n = 0;
+    while (n < out.size() && TryPop(out[n])) ++n;
+    return n;
+  }
+
+  // Consumer side.
+  bool empty() const {
+    return cells_[head_ & kMask].sequence.load(std::memory_order_acquire) !=
+           head_ + 1;
+  }
+
+ private:
+  static constexpr uint32_t kMask = Size - 1;
+
+  struct Cell {
+    // tail when the slot is free for the producer claiming tail, tail + 1
+    // once that producer has written it, and tail + Size once consumed.
+    std::atomic<uint32_t> sequence;
+    T item;
+  };
+
+  alignas(kCacheLineSize) std::atomic<uint32_t> tail_ = 0;
+  // Only touched by the consumer.
+  alignas(kCacheLineSize) uint32_t head_ = 0;
+  alignas(kCacheLineSize) Cell cells_[Size];
+};
+
+}  // namespace freertosxx
+
+#endif  // FREERTOSXX_MPSC_RING_H
@@ -9,15 +9,26 @@
 #include <utility>
 
 #include "FreeRTOS.h"
+#include "freertosxx/mutex_profile.h"
 #include "projdefs.h"
 #include "semphr.h"
 
+#if FREERTOSXX_MUTEX_PROFILING
+#include "pico/time.h"
+#endif
+
 namespace freertosxx {
 
 // Wraps a FreeRTOS mutex in an ABSL-like interface.
+//
+// With FREERTOSXX_MUTEX_PROFILING, each Mutex records how often it was
+// contended, how long tasks waited for it and how long they held it. See
+// mutex_profile.h.
 class Mutex {
  public:
-  Mutex();
+  Mutex() : Mutex(nullptr) {}
+  // name identifies the mutex in contention profiles.
+  explicit Mutex(const char* name);
   ~Mutex();
   Mutex(const Mutex&) = delete;
   Mutex& operator=(const Mutex&) = delete;
@@ -27,19 +38,20 @@ class Mutex {
   Mutex& operator=(Mutex&& o);
 
   void Lock() {
-    auto result = xSemaphoreTake(mutex_, portMAX_DELAY);
-    configASSERT(result == pdTRUE);
+    auto result = Take(portMAX_DELAY);
+    configASSERT(result);
   }
 
-  bool TryLock() { return pdTRUE == xSemaphoreTake(mutex_, 0); }
+  bool TryLock() { return Take(0); }
 
-  bool LockWithTimeout(int ms) {
-    return pdTRUE == xSemaphoreTake(mutex_, pdMS_TO_TICKS(ms));
-  }
+  bool LockWithTimeout(int ms) { return Take(pdMS_TO_TICKS(ms)); }
 
   void Unlock() {
     configASSERT(xSemaphoreGetMutexHolder(mutex_) ==
                  xTaskGetCurrentTaskHandle());
+#if FREERTOSXX_MUTEX_PROFILING
+    profile_->Releasing();
+#endif
     xSemaphoreGive(mutex_);
   }
 
@@ -64,7 +76,30 @@ class Mutex {
   }
 
  private:
+  bool Take(TickType_t timeout) {
+#if FREERTOSXX_MUTEX_PROFILING
+    // Tries first without blocking, to tell contended acquisitions apart.
+    const uint32_t start_us = time_us_32();
+    if (pdTRUE == xSemaphoreTake(mutex_, 0)) {
+      profile_->Acquired(start_us, false);
+      return true;
+    }
+    if (timeout != 0 && pdTRUE == xSemaphoreTake(mutex_, timeout)) {
+      profile_->Acquired(start_us, true);
+      return true;
+    }
+    profile_->Failed();
+    return false;
+#else
+    return pdTRUE == xSemaphoreTake(mutex_, timeout);
+#endif
+  }
+
   SemaphoreHandle_t mutex_;
+#if FREERTOSXX_MUTEX_PROFILING
+  // On the heap so that it stays registered when the Mutex moves.
+  internal::MutexProfile* profile_ = nullptr;
+#endif
 };
 
 class MutexLock {
@@ -0,0 +1,75 @@
+#ifndef FREERTOSXX_MUTEX_PROFILE_H
+#define FREERTOSXX_MUTEX_PROFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+
+// Mutex contention profiling, enabled at compile time with the
+// FREERTOSXX_MUTEX_PROFILING CMake option. When it is off, Mutex carries no
+// profile and none of its methods do any extra work.
+#ifndef FREERTOSXX_MUTEX_PROFILING
+#define FREERTOSXX_MUTEX_PROFILING 0
+#endif
+
+namespace freertosxx {
+
+struct MutexStats {
+  // The name the Mutex was constructed with, or null.
+  const char* name;
+  const void* mutex;
+  uint32_t acquisitions;
+  // Acquisitions that had to wait, plus failed attempts.
+  uint32_t contended;
+  // Attempts that timed out or found the mutex held.
+  uint32_t failures;
+  uint64_t total_wait_us;
+  uint32_t max_wait_us;
+  uint32_t max_hold_us;
+};
+
+// Calls fn with the stats of every Mutex in existence. Calls nothing when
+// profiling is disabled.
+void VisitMutexStats(const std::function<void(const MutexStats&)>& fn);
+
+// Formats stats as one line of text, e.g. for an MQTT payload. Returns the
+// length of the line, truncated to fit out.
+size_t FormatMutexStats(const MutexStats& stats, std::span<char> out);
+
+// Prints every Mutex's stats, e.g. over the UART.
+void PrintMutexStats();
+
+namespace internal {
+
+#if FREERTOSXX_MUTEX_PROFILING
+// The stats of one Mutex, which records into it while it is held, except
+// for failures. Registered for VisitMutexStats for as long as it exists.
+class MutexProfile {
+ public:
+  explicit MutexProfile(const char* name, const void* mutex);
+  ~MutexProfile();
+  MutexProfile(const MutexProfile&) = delete;
+  MutexProfile& operator=(const MutexProfile&) = delete;
+
+  void set_mutex(const void* mutex) { stats_.mutex = mutex; }
+
+  void Acquired(uint32_t wait_start_us, bool waited);
+  void Failed();
+  void Releasing();
+
+  MutexStats stats() const;
+  MutexProfile* next() const { return next_; }
+
+ private:
+  MutexStats stats_;
+  uint32_t acquired_us_ = 0;
+  MutexProfile* next_ = nullptr;
+};
+#endif
+
+}  // namespace internal
+
+}  // namespace freertosxx
+
+#endif  // FREERTOSXX_MUTEX_PROFILE_H
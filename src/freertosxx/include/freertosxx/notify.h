@@ -0,0 +1,155 @@
+#ifndef FREERTOSXX_NOTIFY_H
+#define FREERTOSXX_NOTIFY_H
+
+#include <cstdint>
+#include <optional>
+
+#include "FreeRTOS.h"
+#include "portmacro.h"
+#include "projdefs.h"
+#include "task.h"
+
+namespace freertosxx {
+
+// Signals built on direct-to-task notifications. They need no kernel object
+// and are cheaper to signal than an EventGroup or a semaphore, but each
+// signal has exactly one waiter: the task it is bound to. Any task or ISR may
+// signal it.
+//
+// Each signal uses one entry of its task's notification array. Stream and
+// message buffers use index 0, so by default the signals use the last entry,
+// and Future::Get the one before it. shared_init's FreeRTOSConfig.h gives
+// each task four entries (configTASK_NOTIFICATION_ARRAY_ENTRIES), which keeps
+// them apart and leaves one spare. Two signals bound to the same task need
+// different indices.
+inline constexpr UBaseType_t kDefaultNotifyIndex =
+    configTASK_NOTIFICATION_ARRAY_ENTRIES - 1;
+// Reserved for Future::Get.
+inline constexpr UBaseType_t kFutureNotifyIndex =
+    configTASK_NOTIFICATION_ARRAY_ENTRIES - 2;
+
+class TaskNotification {
+ public:
+  // Binds to task, by default the calling task.
+  explicit TaskNotification(
+      TaskHandle_t task = xTaskGetCurrentTaskHandle(),
+      UBaseType_t index = kDefaultNotifyIndex)
+      : task_(task), index_(index) {}
+
+  // Rebinds to another task, e.g. one created after this signal. Only the
+  // bound task may wait, but it may wait before it is bound.
+  void Bind(TaskHandle_t task) { task_ = task; }
+  TaskHandle_t task() const { return task_; }
+
+ protected:
+  TaskHandle_t task_;
+  const UBaseType_t index_;
+};
+
+// 32 event bits for one waiting task, with the interface of EventGroup.
+class Notifier : public TaskNotification {
+ public:
+  using TaskNotification::TaskNotification;
+
+  struct WaitOptions {
+    bool clear = false;
+    bool all = false;
+    std::optional<TickType_t> timeout = std::nullopt;
+  };
+  // Waits until any (or all) of bits are set. Returns the bits set when the
+  // wait ended, before any clearing; on timeout, they do not satisfy the
+  // wait.
+  uint32_t Wait(uint32_t bits, WaitOptions opts) {
+    TickType_t timeout = opts.timeout.value_or(portMAX_DELAY);
+    TimeOut_t timeout_state;
+    vTaskSetTimeOutState(&timeout_state);
+    // Waiting acts on the calling task, which may not be bound yet.
+    uint32_t value = ulTaskNotifyValueClearIndexed(nullptr, index_, 0);
+    while (!Satisfied(value, bits, opts.all)) {
+      if (xTaskCheckForTimeOut(&timeout_state, &timeout) == pdTRUE) {
+        return value;
+      }
+      xTaskNotifyWaitIndexed(index_, 0, 0, &value, timeout);
+    }
+    if (opts.clear) ulTaskNotifyValueClearIndexed(nullptr, index_, bits);
+    return value;
+  }
+  uint32_t Wait(uint32_t bits) { return Wait(bits, {}); }
+
+  void Set(uint32_t bits) {
+    xTaskNotifyIndexed(task_, index_, bits, eSetBits);
+  }
+
+  void SetFromISR(uint32_t bits, BaseType_t& higher_priority_task_woken) {
+    xTaskNotifyIndexedFromISR(
+        task_, index_, bits, eSetBits, &higher_priority_task_woken);
+  }
+
+  // Returns the bits before clearing.
+  uint32_t Clear(uint32_t bits) {
+    return ulTaskNotifyValueClearIndexed(task_, index_, bits);
+  }
+
+  uint32_t Get() const {
+    return ulTaskNotifyValueClearIndexed(task_, index_, 0);
+  }
+
+ private:
+  static bool Satisfied(uint32_t value, uint32_t bits, bool all) {
+    return all ? (value & bits) == bits : (value & bits) != 0;
+  }
+};
+
+// A binary semaphore for one waiting task. Gives while the signal is already
+// given are absorbed.
+class BinarySignal : public TaskNotification {
+ public:
+  using TaskNotification::TaskNotification;
+
+  struct WaitOptions {
+    std::optional<TickType_t> timeout = std::nullopt;
+  };
+  // Returns false on timeout.
+  bool Wait(WaitOptions opts) {
+    return ulTaskNotifyTakeIndexed(
+               index_, pdTRUE, opts.timeout.value_or(portMAX_DELAY)) != 0;
+  }
+  bool Wait() { return Wait({}); }
+
+  void Give() { xTaskNotifyGiveIndexed(task_, index_); }
+
+  void GiveFromISR(BaseType_t& higher_priority_task_woken) {
+    vTaskNotifyGiveIndexedFromISR(task_, index_, &higher_priority_task_woken);
+  }
+};
+
+// A counting semaphore for one waiting task.
+class CountingSignal : public TaskNotification {
+ public:
+  using TaskNotification::TaskNotification;
+
+  struct WaitOptions {
+    // Take every pending count at once rather than one.
+    bool all = false;
+    std::optional<TickType_t> timeout = std::nullopt;
+  };
+  // Returns the number of counts taken, zero on timeout.
+  uint32_t Wait(WaitOptions opts) {
+    const uint32_t count = ulTaskNotifyTakeIndexed(
+        index_,
+        opts.all ? pdTRUE : pdFALSE,
+        opts.timeout.value_or(portMAX_DELAY));
+    return opts.all || count == 0 ? count : 1;
+  }
+  uint32_t Wait() { return Wait({}); }
+
+  void Give() { xTaskNotifyGiveIndexed(task_, index_); }
+
+  void GiveFromISR(BaseType_t& higher_priority_task_woken) {
+    vTaskNotifyGiveIndexedFromISR(task_, index_, &higher_priority_task_woken);
+  }
+};
+
+}  // namespace freertosxx
+
+#endif  // FREERTOSXX_NOTIFY_H
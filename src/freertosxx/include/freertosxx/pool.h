@@ -0,0 +1,237 @@
+#ifndef FREERTOSXX_POOL_H
+#define FREERTOSXX_POOL_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <new>
+#include <span>
+#include <tuple>
+#include <utility>
+
+#include "FreeRTOS.h"
+
+namespace freertosxx {
+
+// Fixed-size block pools, for the small objects that a long-running device
+// allocates and frees over and over, e.g. callback arguments. Serving them
+// from their own blocks keeps them from fragmenting the FreeRTOS heap.
+
+// Blocks are aligned, and sized in multiples of, this.
+inline constexpr size_t kPoolAlignment = alignof(std::max_align_t);
+
+struct PoolStats {
+  const char* name;
+  size_t block_size;
+  size_t capacity;
+  size_t in_use;
+  // The most blocks ever in use at once.
+  size_t high_water;
+  uint32_t allocations;
+  // Allocations that found the pool exhausted.
+  uint32_t failures;
+};
+
+// A pool of count blocks of block_size bytes in storage that the pool does
+// not own. Use BlockPool, which provides the storage.
+//
+// Allocation and freeing take a critical section for a few instructions, so
+// any task may use a pool. ISRs may not.
+class UntypedBlockPool {
+ public:
+  UntypedBlockPool(
+      const char* name, std::byte* storage, size_t block_size, size_t count);
+  ~UntypedBlockPool();
+  UntypedBlockPool(const UntypedBlockPool&) = delete;
+  UntypedBlockPool(UntypedBlockPool&&) = delete;
+  UntypedBlockPool& operator=(const UntypedBlockPool&) = delete;
+  UntypedBlockPool& operator=(UntypedBlockPool&&) = delete;
+
+  // Returns nullptr if every block is in use.
+  void* Allocate();
+  // block must have come from this pool.
+  void Free(void* block);
+
+  bool Owns(const void* p) const {
+    return p >= storage_ && p < storage_ + block_size_ * capacity_;
+  }
+
+  size_t block_size() const { return block_size_; }
+  PoolStats stats() const;
+
+  // Calls fn with the stats of every pool in existence. Pools are usually
+  // globals; do not create or destroy one from fn.
+  static void VisitStats(const std::function<void(const PoolStats&)>& fn);
+
+ private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  const char* const name_;
+  std::byte* const storage_;
+  const size_t block_size_;
+  const size_t capacity_;
+
+  // Freed blocks. Blocks past untouched_ have never been allocated and are
+  // not on the list, so constructing a pool does not touch its storage.
+  FreeBlock* free_ = nullptr;
+  size_t untouched_ = 0;
+  size_t in_use_ = 0;
+  size_t high_water_ = 0;
+  uint32_t allocations_ = 0;
+  uint32_t failures_ = 0;
+
+  // Every pool, for VisitStats.
+  UntypedBlockPool* next_pool_ = nullptr;
+};
+
+template <size_t BlockSize, size_t Count>
+class BlockPool : public UntypedBlockPool {
+ public:
+  static constexpr size_t kBlockSize =
+      (std::max(BlockSize, sizeof(void*)) + kPoolAlignment - 1) /
+      kPoolAlignment * kPoolAlignment;
+  static constexpr size_t kCount = Count;
+
+  explicit BlockPool(const char* name)
+      : UntypedBlockPool(name, storage_, kBlockSize, Count) {}
+
+ private:
+  alignas(kPoolAlignment) std::byte storage_[kBlockSize * Count];
+};
+
+// A set of BlockPools of different sizes, in ascending order of block size,
+// that serves each allocation from the smallest pool that fits it and has a
+// free block. Allocations that no pool can serve fall back to the FreeRTOS
+// heap, so the pools need only be sized for the usual load; a pool's
+// failures and the set's heap_fallbacks show when they are too small.
+//
+//   PoolSet<BlockPool<16, 8>, BlockPool<64, 4>> g_pools("callbacks");
+//
+// Each pool is named after the set and its block size, e.g. "callbacks/16".
+template <typename... Pools>
+class PoolSet {
+ public:
+  static_assert(sizeof...(Pools) > 0);
+  static_assert(std::ranges::is_sorted(
+      std::array<size_t, sizeof...(Pools)>{Pools::kBlockSize...}));
+
+  explicit PoolSet(const char* name)
+      : PoolSet(name, std::index_sequence_for<Pools...>()) {}
+
+  // Returns nullptr if no pool has a free block that fits size.
+  void* Allocate(size_t size) {
+    return std::apply(
+        [&](Pools&... pools) {
+          void* p = nullptr;
+          ((p = pools.block_size() >= size ? pools.Allocate() : nullptr) ||
+           ...);
+          return p;
+        },
+        pools_);
+  }
+
+  // Allocates from the pools, or failing that, the heap.
+  void* New(size_t size) {
+    if (void* p = Allocate(size)) return p;
+    ++heap_fallbacks_;
+    return pvPortMalloc(size);
+  }
+
+  // Frees memory from New.
+  void Delete(void* p) {
+    if (p == nullptr) return;
+    const bool freed = std::apply(
+        [&](Pools&... pools) {
+          return ((pools.Owns(p) && (pools.Free(p), true)) || ...);
+        },
+        pools_);
+    if (!freed) vPortFree(p);
+  }
+
+  bool Owns(const void* p) const {
+    return std::apply(
+        [&](const Pools&... pools) { return (pools.Owns(p) || ...); },
+        pools_);
+  }
+
+  static constexpr size_t max_block_size() {
+    return std::max({Pools::kBlockSize...});
+  }
+
+  // Allocations that New served from the heap.
+  uint32_t heap_fallbacks() const { return heap_fallbacks_; }
+
+ private:
+  template <size_t... I>
+  PoolSet(const char* name, std::index_sequence<I...>)
+      : pools_(NameOf<I>(name)...) {}
+
+  template <size_t I>
+  const char* NameOf(const char* name) {
+    snprintf(
+        names_[I],
+        sizeof(names_[I]),
+        "%s/%u",
+        name,
+        static_cast<unsigned>(
+            std::tuple_element_t<I, std::tuple<Pools...>>::kBlockSize));
+    return names_[I];
+  }
+
+  // Declared before pools_, which keep pointers into it.
+  char names_[sizeof...(Pools)][24];
+  std::tuple<Pools...> pools_;
+  uint32_t heap_fallbacks_ = 0;
+};
+
+// Gives a class a member operator new and delete that allocate from pools,
+// a PoolSet with static storage duration.
+//
+//   struct Arg : PoolAllocated<g_pools> { ... };
+template <auto& pools>
+class PoolAllocated {
+ public:
+  static void* operator new(size_t size) { return pools.New(size); }
+  static void operator delete(void* p) { pools.Delete(p); }
+};
+
+// A std allocator that allocates from a PoolSet, e.g. for the nodes of a
+// std::list or std::map. Allocations too large for the pools, like a
+// growing vector's, come from the heap.
+template <typename T, typename Pools>
+class PoolAllocator {
+ public:
+  static_assert(alignof(T) <= kPoolAlignment);
+  using value_type = T;
+
+  explicit PoolAllocator(Pools& pools) : pools_(&pools) {}
+  template <typename U>
+  PoolAllocator(const PoolAllocator<U, Pools>& o) : pools_(o.pools_) {}
+
+  T* allocate(size_t n) { return static_cast<T*>(pools_->New(n * sizeof(T))); }
+  void deallocate(T* p, size_t) { pools_->Delete(p); }
+
+  template <typename U>
+  bool operator==(const PoolAllocator<U, Pools>& o) const {
+    return pools_ == o.pools_;
+  }
+
+ private:
+  template <typename U, typename P>
+  friend class PoolAllocator;
+
+  Pools* pools_;
+};
+
+// Prints the FreeRTOS heap's stats and every pool's, e.g. to find pools
+// that are too small or too large.
+void PrintMemoryStats();
+
+}  // namespace freertosxx
+
+#endif  // FREERTOSXX_POOL_H
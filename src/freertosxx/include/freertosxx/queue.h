@@ -17,12 +17,11 @@ class UntypedQueue {
   UntypedQueue& operator=(const UntypedQueue&) = delete;
   UntypedQueue& operator=(UntypedQueue&&) = delete;
 
-  void Drain() {
-    while (uxQueueMessagesWaiting(queue_) > 0) {
-      void* item;
-      Receive(&item);
-    }
-  }
+  // Discards every queued item.
+  void Drain() { xQueueReset(queue_); }
+
+  // The underlying queue, e.g. to add it to a Selector.
+  QueueHandle_t handle() const { return queue_; }
 
  protected:
   void Send(const void* item) {
@@ -0,0 +1,186 @@
+#ifndef FREERTOSXX_RING_QUEUE_H
+#define FREERTOSXX_RING_QUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+
+#include "FreeRTOS.h"
+#include "freertosxx/spsc_ring.h"
+#include "portmacro.h"
+#include "projdefs.h"
+#include "semphr.h"
+#include "task.h"
+
+namespace freertosxx {
+
+// A queue of trivially copyable items for moving data in bursts.
+//
+// Items are copied in and out of a ring owned by the queue in batches:
+// SendMany and ReceiveMany move as many items as they can per call, and a
+// blocked reader or writer is woken at most once per batch rather than once
+// per item. Peek and Consume let the reader work on items where they sit in
+// the ring, without copying them out.
+//
+// The ring is an SpscRing, so like a FreeRTOS stream buffer, a RingQueue has
+// one writer and one reader at a time. Either may be an ISR, through the
+// FromISR methods. Guard a side with a Mutex if several tasks share it.
+template <typename T, int Size>
+class RingQueue {
+ public:
+  RingQueue()
+      : readable_(xSemaphoreCreateBinaryStatic(&readable_storage_)),
+        writable_(xSemaphoreCreateBinaryStatic(&writable_storage_)) {}
+  ~RingQueue() {
+    vSemaphoreDelete(writable_);
+    vSemaphoreDelete(readable_);
+  }
+  RingQueue(const RingQueue&) = delete;
+  RingQueue(RingQueue&&) = delete;
+  RingQueue& operator=(const RingQueue&) = delete;
+  RingQueue& operator=(RingQueue&&) = delete;
+
+  // Copies items into the queue, waiting up to timeout for space. Returns the
+  // number of items sent, which is less than items.size() only on timeout.
+  size_t SendMany(
+      std::span<const T> items, TickType_t timeout = portMAX_DELAY) {
+    TimeOut_t timeout_state;
+    vTaskSetTimeOutState(&timeout_state);
+    size_t sent = 0;
+    while (true) {
+      sent += Write(items.subspan(sent), nullptr);
+      if (sent == items.size()) return sent;
+      if (!Wait(writer_waiting_, writable_, timeout_state, timeout, [&] {
+            return free() > 0;
+          })) {
+        return sent;
+      }
+    }
+  }
+
+  bool Send(const T& item, TickType_t timeout = portMAX_DELAY) {
+    return SendMany(std::span(&item, 1), timeout) == 1;
+  }
+
+  // Copies as many items as fit, without blocking.
+  size_t SendManyFromISR(
+      std::span<const T> items, bool& higher_priority_task_woken) {
+    BaseType_t woken = pdFALSE;
+    const size_t sent = Write(items, &woken);
+    higher_priority_task_woken = woken == pdTRUE;
+    return sent;
+  }
+
+  // Waits up to timeout for at least one item, then copies out as many items
+  // as are queued, up to out.size(). Returns the number of items received.
+  size_t ReceiveMany(std::span<T> out, TickType_t timeout = portMAX_DELAY) {
+    if (out.empty()) return 0;
+    size_t received = 0;
+    for (std::span<const T> run = Peek(timeout);
+         !run.empty() && received < out.size();
+         run = Peek(0)) {
+      const size_t n = std::min(run.size(), out.size() - received);
+      std::memcpy(&out[received], run.data(), n * sizeof(T));
+      Consume(n);
+      received += n;
+    }
+    return received;
+  }
+
+  // Copies out as many items as are queued, up to out.size(), without
+  // blocking.
+  size_t ReceiveManyFromISR(
+      std::span<T> out, bool& higher_priority_task_woken) {
+    const size_t received = ring_.TryPopMany(out);
+    BaseType_t woken = pdFALSE;
+    if (received > 0) Wake(writer_waiting_, writable_, &woken);
+    higher_priority_task_woken = woken == pdTRUE;
+    return received;
+  }
+
+  // Waits up to timeout for at least one item and returns the items at the
+  // front of the queue, in place. They stay queued, and the view stays valid,
+  // until they are consumed. When the queued items wrap around the end of the
+  // ring, only the run up to the end is returned; consume it and peek again
+  // for the rest. Returns an empty span on timeout.
+  std::span<const T> Peek(TickType_t timeout = portMAX_DELAY) {
+    TimeOut_t timeout_state;
+    vTaskSetTimeOutState(&timeout_state);
+    while (true) {
+      std::span<const T> run = ring_.Peek();
+      if (!run.empty()) return run;
+      if (!Wait(reader_waiting_, readable_, timeout_state, timeout, [&] {
+            return size() > 0;
+          })) {
+        return {};
+      }
+    }
+  }
+
+  // Removes the first n peeked items from the queue.
+  void Consume(size_t n) { Release(n, nullptr); }
+
+  size_t size() const { return ring_.size(); }
+  size_t free() const { return Size - size(); }
+
+ private:
+  // Copies as many items as fit into the ring and wakes the reader if it is
+  // waiting. woken is non-null in an ISR.
+  size_t Write(std::span<const T> items, BaseType_t* woken) {
+    const size_t n = ring_.TryPushMany(items);
+    if (n > 0) Wake(reader_waiting_, readable_, woken);
+    return n;
+  }
+
+  void Release(size_t n, BaseType_t* woken) {
+    ring_.Consume(n);
+    Wake(writer_waiting_, writable_, woken);
+  }
+
+  static void Wake(
+      std::atomic<bool>& waiting, SemaphoreHandle_t semaphore,
+      BaseType_t* woken) {
+    // Orders the ring update before the load of waiting; pairs with the fence
+    // in Wait.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!waiting.load(std::memory_order_relaxed)) return;
+    if (woken != nullptr) {
+      xSemaphoreGiveFromISR(semaphore, woken);
+    } else {
+      xSemaphoreGive(semaphore);
+    }
+  }
+
+  // Blocks until ready() or the timeout expires. Returns false on timeout.
+  template <typename Ready>
+  static bool Wait(
+      std::atomic<bool>& waiting, SemaphoreHandle_t semaphore,
+      TimeOut_t& timeout_state, TickType_t& timeout, Ready ready) {
+    waiting.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    // A give from before the flag was set is stale, but harmless: we would
+    // just loop once more. Check again now that the other side will wake us.
+    bool result = true;
+    if (!ready()) {
+      result = xTaskCheckForTimeOut(&timeout_state, &timeout) == pdFALSE &&
+               xSemaphoreTake(semaphore, timeout) == pdTRUE;
+    }
+    waiting.store(false, std::memory_order_relaxed);
+    return result;
+  }
+
+  SpscRing<T, Size> ring_;
+  std::atomic<bool> reader_waiting_ = false;
+  std::atomic<bool> writer_waiting_ = false;
+  StaticSemaphore_t readable_storage_;
+  StaticSemaphore_t writable_storage_;
+  SemaphoreHandle_t readable_;
+  SemaphoreHandle_t writable_;
+};
+
+}  // namespace freertosxx
+
+#endif  // FREERTOSXX_RING_QUEUE_H
@@ -0,0 +1,133 @@
+#ifndef FREERTOSXX_RING_WAIT_H
+#define FREERTOSXX_RING_WAIT_H
+
+#include <atomic>
+#include <cstdint>
+#include <span>
+
+#include "FreeRTOS.h"
+#include "freertosxx/notify.h"
+#include "hardware/sync.h"
+#include "pico/time.h"
+#include "portmacro.h"
+#include "projdefs.h"
+#include "task.h"
+
+namespace freertosxx {
+
+// Ways for the consumer of an SpscRing or MpscRing to sleep until a producer
+// has pushed. Producers push, then call Notify, or NotifyFromISR in an ISR.
+// The consumer calls Wait, or WaitPopMany below.
+//
+// Both waiters only do work in Notify while the consumer is actually waiting,
+// so a producer that outpaces its consumer pays for a fence and a load per
+// notification.
+
+// Blocks the consumer task on a direct-to-task notification. The consumer
+// must call Attach before the first Wait.
+class TaskNotifyWaiter {
+ public:
+  // The notification at index is reserved for this waiter on the consumer
+  // task. See notify.h.
+  explicit TaskNotifyWaiter(UBaseType_t index = kDefaultNotifyIndex)
+      : index_(index) {}
+
+  // Makes the calling task the consumer.
+  void Attach() { task_ = xTaskGetCurrentTaskHandle(); }
+
+  void Notify() {
+    if (ConsumeWaiting()) xTaskNotifyGiveIndexed(task_, index_);
+  }
+
+  void NotifyFromISR(bool& higher_priority_task_woken) {
+    BaseType_t woken = pdFALSE;
+    if (ConsumeWaiting()) vTaskNotifyGiveIndexedFromISR(task_, index_, &woken);
+    higher_priority_task_woken = woken == pdTRUE;
+  }
+
+  // Blocks until ready() returns true or the timeout expires. Returns the
+  // final value of ready().
+  template <typename Ready>
+  bool Wait(Ready ready, TickType_t timeout = portMAX_DELAY) {
+    configASSERT(task_ == xTaskGetCurrentTaskHandle());
+    TimeOut_t timeout_state;
+    vTaskSetTimeOutState(&timeout_state);
+    while (true) {
+      waiting_.store(true, std::memory_order_relaxed);
+      // Pairs with the fence in ConsumeWaiting: either the producer sees
+      // waiting_, or we see its push.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (ready()) break;
+      if (xTaskCheckForTimeOut(&timeout_state, &timeout) == pdTRUE) break;
+      ulTaskNotifyTakeIndexed(index_, pdTRUE, timeout);
+    }
+    waiting_.store(false, std::memory_order_relaxed);
+    return ready();
+  }
+
+ private:
+  bool ConsumeWaiting() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!waiting_.load(std::memory_order_relaxed)) return false;
+    // Several producers may race to clear this. The worst case is an extra
+    // notification, which Wait tolerates.
+    waiting_.store(false, std::memory_order_relaxed);
+    return true;
+  }
+
+  TaskHandle_t task_ = nullptr;
+  const UBaseType_t index_;
+  std::atomic<bool> waiting_ = false;
+};
+
+// Sleeps the consumer's core with WFE until the producer's SEV, or any
+// interrupt, wakes it.
+//
+// This is for consumers that would otherwise spin: a high-priority task
+// pinned to a core, or code on a core that the scheduler does not run. The
+// core does not block in the kernel, so nothing else runs on it while the
+// consumer waits. Interrupts, including the tick, also end a WFE, so the
+// timeout is checked at least once per tick.
+//
+// The SIO FIFO would be the natural cross-core doorbell, but the FreeRTOS SMP
+// port uses it to make the other core yield. The event register is free.
+class EventWaiter {
+ public:
+  void Notify() {
+    // Makes the push visible before the other core wakes.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    __sev();
+  }
+
+  void NotifyFromISR(bool& higher_priority_task_woken) {
+    Notify();
+    higher_priority_task_woken = false;
+  }
+
+  template <typename Ready>
+  bool Wait(Ready ready, TickType_t timeout = portMAX_DELAY) {
+    const uint64_t deadline_us =
+        timeout == portMAX_DELAY
+            ? UINT64_MAX
+            : time_us_64() + uint64_t{pdTICKS_TO_MS(timeout)} * 1000;
+    while (!ready()) {
+      if (time_us_64() >= deadline_us) return false;
+      __wfe();
+    }
+    return true;
+  }
+};
+
+// Waits for the ring to be non-empty, then pops up to out.size() items.
+// Returns the number popped, zero on timeout.
+template <typename Ring, typename Waiter, typename T, size_t Extent>
+size_t WaitPopMany(
+    Ring& ring, Waiter& waiter, std::span<T, Extent> out,
+    TickType_t timeout = portMAX_DELAY) {
+  if (!waiter.Wait([&] { return !ring.empty(); }, timeout)) return 0;
+  return ring.TryPopMany(out);
+}
+
+}  // namespace freertosxx
+
+#endif  // FREERTOSXX_RING_WAIT_H
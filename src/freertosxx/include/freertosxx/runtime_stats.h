@@ -0,0 +1,153 @@
+#ifndef FREERTOSXX_RUNTIME_STATS_H
+#define FREERTOSXX_RUNTIME_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+#include "FreeRTOS.h"
+#include "hardware/uart.h"
+#include "task.h"
+
+// Per-task CPU use and context switch rates, and an optional trace of every
+// context switch.
+//
+// The kernel does the accounting, so it needs the following in the FreeRTOS
+// config, which shared_init's FreeRTOSConfig.h adds to picobase's. The run
+// time counter is the RP2040's 64-bit microsecond timer, so it never wraps.
+//
+//   #define configUSE_TRACE_FACILITY 1
+//   #define configGENERATE_RUN_TIME_STATS 1
+//   #define configRUN_TIME_COUNTER_TYPE uint64_t
+//   #define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+//   #define portGET_RUN_TIME_COUNTER_VALUE() FreertosxxRunTimeCounter()
+//
+// Counting context switches, and the trace, need the switch hook too:
+//
+//   #define traceTASK_SWITCHED_IN() FreertosxxTaskSwitchedIn()
+//
+// Both functions are defined by freertosxx, and are declared in the config
+// where the assembler cannot see them:
+//
+//   #ifndef __ASSEMBLER__
+//   #include <stdint.h>
+//   uint64_t FreertosxxRunTimeCounter(void);
+//   void FreertosxxTaskSwitchedIn(void);
+//   #endif
+//
+// A build with another config and without these settings still links, but
+// CpuMonitor::Sample returns false; without the hook, every switch rate is
+// zero.
+
+#ifndef FREERTOSXX_TRACE_RECORDS
+#define FREERTOSXX_TRACE_RECORDS 0
+#endif
+
+extern "C" {
+uint64_t FreertosxxRunTimeCounter(void);
+void FreertosxxTaskSwitchedIn(void);
+}
+
+namespace freertosxx {
+
+// Samples every task's run time and context switches, and works out how
+// much of the CPU each used since the previous sample. Call Sample
+// periodically, e.g. every few seconds, from one task.
+//
+// Switches are counted per task number (vTaskSetTaskNumber), which Sample
+// assigns. Only one CpuMonitor may exist, and nothing else may set task
+// numbers.
+class CpuMonitor {
+ public:
+  static constexpr size_t kMaxTasks = 32;
+
+  struct TaskLoad {
+    char name[configMAX_TASK_NAME_LEN];
+    // The task's number, which identifies it in the trace.
+    UBaseType_t id;
+    // Share of the time of all cores, so the loads add up to 100.
+    float cpu_percent;
+    float switches_per_second;
+    // The fewest words of stack the task has ever had left.
+    configSTACK_DEPTH_TYPE stack_high_water;
+    bool idle;
+  };
+
+  CpuMonitor() = default;
+  CpuMonitor(const CpuMonitor&) = delete;
+  CpuMonitor& operator=(const CpuMonitor&) = delete;
+
+  // Samples every task. Returns false without sampling if the kernel keeps
+  // no run time stats, or there are more than kMaxTasks tasks. The first
+  // sample covers the time since boot.
+  bool Sample();
+
+  // The loads of the latest sample.
+  std::span<const TaskLoad> tasks() const { return {loads_, count_}; }
+  const TaskLoad* Find(std::string_view name) const;
+
+  // Share of the time of all cores spent outside the idle tasks.
+  float cpu_percent() const { return cpu_percent_; }
+  float switches_per_second() const { return switches_per_second_; }
+
+  // Prints the latest sample as a table.
+  void Print() const;
+
+ private:
+  // The task with number i + 1.
+  struct Slot {
+    // The task's xTaskNumber, which unlike its handle is never reused, or 0
+    // if the slot is free.
+    UBaseType_t task = 0;
+    uint64_t run_time = 0;
+    uint32_t switches = 0;
+  };
+
+  Slot slots_[kMaxTasks];
+  uint64_t previous_time_ = 0;
+
+  TaskLoad loads_[kMaxTasks];
+  size_t count_ = 0;
+  float cpu_percent_ = 0;
+  float switches_per_second_ = 0;
+};
+
+// The trace is a ring of the last FREERTOSXX_TRACE_RECORDS context
+// switches, recorded by the switch hook while tracing is on. Set the
+// FREERTOSXX_TRACE_RECORDS CMake option to enable it; each record takes 8
+// bytes of RAM.
+struct TraceRecord {
+  // The low 32 bits of the microsecond timer.
+  uint32_t time_us;
+  // The TaskLoad::id of the task switched in, or 0 if it has none yet.
+  uint16_t task;
+  uint8_t core;
+  uint8_t reserved;
+};
+static_assert(sizeof(TraceRecord) == 8);
+
+// Starts recording context switches, overwriting the oldest records once
+// the ring is full.
+void StartTrace();
+void StopTrace();
+
+// Stops the trace and writes it to uart as binary, for offline analysis.
+// The names of the tasks come from monitor's latest sample. Returns false
+// if the trace is not enabled. Everything is little-endian:
+//
+//   char magic[4] = "FTRC";
+//   uint16_t version = 1;
+//   uint16_t task_count;
+//   uint32_t record_count;
+//   // Records that were overwritten before the dump.
+//   uint32_t dropped;
+//   struct { uint16_t id; char name[14]; } tasks[task_count];
+//   TraceRecord records[record_count];  // Oldest first.
+//
+// Nothing else should write to uart meanwhile, e.g. stdio.
+bool DumpTrace(uart_inst_t* uart, const CpuMonitor& monitor);
+
+}  // namespace freertosxx
+
+#endif  // FREERTOSXX_RUNTIME_STATS_H
@@ -0,0 +1,135 @@
+#ifndef FREERTOSXX_SELECTOR_H
+#define FREERTOSXX_SELECTOR_H
+
+#include <optional>
+
+#include "FreeRTOS.h"
+#include "freertosxx/queue.h"
+// FreeRTOS's queue.h, for queue sets. A quoted include would find
+// freertosxx/queue.h again.
+#include <queue.h>
+#include "semphr.h"
+
+namespace freertosxx {
+
+// A binary semaphore for a Selector to wait on, for events that carry no
+// data, e.g. a button press or a timer tick. Task notifications cannot be
+// members of a queue set, so this takes the place of a BinarySignal for a
+// task that selects. Gives while the signal is already given are absorbed.
+class SelectorSignal {
+ public:
+  SelectorSignal() : semaphore_(xSemaphoreCreateBinaryStatic(&storage_)) {}
+  ~SelectorSignal() { vSemaphoreDelete(semaphore_); }
+  SelectorSignal(const SelectorSignal&) = delete;
+  SelectorSignal& operator=(const SelectorSignal&) = delete;
+
+  void Give() { xSemaphoreGive(semaphore_); }
+
+  void GiveFromISR(bool& higher_priority_task_woken) {
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(semaphore_, &woken);
+    higher_priority_task_woken = woken == pdTRUE;
+  }
+
+  SemaphoreHandle_t handle() const { return semaphore_; }
+
+ private:
+  StaticSemaphore_t storage_;
+  SemaphoreHandle_t semaphore_;
+};
+
+// Lets one task wait on several queues and semaphores at once, so that it
+// can serve many sources without a task, and a stack, for each. Built on a
+// FreeRTOS queue set, so it needs configUSE_QUEUE_SETS.
+//
+//   Selector selector(kMessagesLength + kButtonsLength + 1);
+//   selector.Add(messages);
+//   selector.Add(buttons);
+//   selector.Add(tick);
+//   while (true) {
+//     Selector::Ready ready = selector.Select();
+//     if (std::optional<Message> m = ready.Receive(messages)) {
+//       ...
+//     } else if (std::optional<Button> b = ready.Receive(buttons)) {
+//       ...
+//     } else if (ready.Take(tick)) {
+//       ...
+//     }
+//   }
+//
+// The queue set's rules apply: a source must be empty when it is added, and
+// a selecting task must only receive from a source after Select has returned
+// it, exactly once per Select. Other tasks must not receive from the sources
+// at all.
+class Selector {
+ public:
+  // capacity is the total length of every source that will be added, where
+  // a binary semaphore or SelectorSignal has length 1.
+  explicit Selector(int capacity);
+  ~Selector();
+  Selector(const Selector&) = delete;
+  Selector& operator=(const Selector&) = delete;
+
+  void Add(const UntypedQueue& queue) { Add(queue.handle()); }
+  void Add(const SelectorSignal& signal) { Add(signal.handle()); }
+  // Adds any queue or semaphore, except a mutex.
+  void Add(QueueSetMemberHandle_t member);
+
+  // A source may only be removed while it is empty.
+  void Remove(const UntypedQueue& queue) { Remove(queue.handle()); }
+  void Remove(const SelectorSignal& signal) { Remove(signal.handle()); }
+  void Remove(QueueSetMemberHandle_t member);
+
+  // The source that Select found ready, or none on timeout.
+  class Ready {
+   public:
+    explicit operator bool() const { return member_ != nullptr; }
+    QueueSetMemberHandle_t member() const { return member_; }
+
+    bool Is(const UntypedQueue& queue) const {
+      return member_ != nullptr && member_ == queue.handle();
+    }
+    bool Is(const SelectorSignal& signal) const {
+      return member_ != nullptr && member_ == signal.handle();
+    }
+
+    // Returns the next item from queue if queue is the ready source.
+    template <typename T>
+    std::optional<T> Receive(Queue<T>& queue) const {
+      if (!Is(queue)) return std::nullopt;
+      T item;
+      if (xQueueReceive(queue.handle(), &item, 0) != pdTRUE) {
+        return std::nullopt;
+      }
+      return item;
+    }
+
+    // Takes signal if it is the ready source.
+    bool Take(SelectorSignal& signal) const {
+      return Is(signal) && xSemaphoreTake(signal.handle(), 0) == pdTRUE;
+    }
+
+   private:
+    friend class Selector;
+    explicit Ready(QueueSetMemberHandle_t member) : member_(member) {}
+
+    QueueSetMemberHandle_t member_;
+  };
+
+  struct WaitOptions {
+    std::optional<TickType_t> timeout = std::nullopt;
+  };
+  // Waits until a source is ready.
+  Ready Select(WaitOptions opts) {
+    return Ready(
+        xQueueSelectFromSet(set_, opts.timeout.value_or(portMAX_DELAY)));
+  }
+  Ready Select() { return Select({}); }
+
+ private:
+  QueueSetHandle_t set_;
+};
+
+}  // namespace freertosxx
+
+#endif  // FREERTOSXX_SELECTOR_H
@@ -0,0 +1,211 @@
+#ifndef FREERTOSXX_SHARED_MUTEX_H
+#define FREERTOSXX_SHARED_MUTEX_H
+
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+
+namespace freertosxx {
+
+// A reader/writer lock: any number of tasks may hold it shared, or one task
+// exclusively. Neither is recursive.
+//
+// Writers are preferred: once a writer is waiting, new readers wait behind
+// it, so a steady stream of readers cannot starve it.
+//
+// FreeRTOS's priority inheritance only covers a mutex's single holder, so
+// the lock extends it by hand. Readers waiting behind a writer wait on a
+// FreeRTOS mutex that the writer holds, and so lend it their priority. A
+// writer waiting for readers to finish raises every lower-priority reader to
+// its own priority until that reader unlocks. Up to kMaxReaders tasks may
+// hold the lock shared at once.
+//
+// Needs INCLUDE_uxTaskPriorityGet and INCLUDE_vTaskPrioritySet.
+class SharedMutex {
+ public:
+  static constexpr int kMaxReaders = 8;
+
+  SharedMutex();
+  ~SharedMutex();
+  SharedMutex(const SharedMutex&) = delete;
+  SharedMutex& operator=(const SharedMutex&) = delete;
+
+  void Lock() {
+    const bool locked = TryLock(portMAX_DELAY);
+    configASSERT(locked);
+  }
+  bool LockWithTimeout(int ms) { return TryLock(pdMS_TO_TICKS(ms)); }
+  void Unlock() {
+    configASSERT(
+        xSemaphoreGetMutexHolder(writer_) == xTaskGetCurrentTaskHandle());
+    xSemaphoreGive(writer_);
+  }
+
+  void LockShared() {
+    const bool locked = TryLockShared(portMAX_DELAY);
+    configASSERT(locked);
+  }
+  bool LockSharedWithTimeout(int ms) {
+    return TryLockShared(pdMS_TO_TICKS(ms));
+  }
+  void UnlockShared();
+
+ private:
+  struct Reader {
+    TaskHandle_t task = nullptr;
+    // The priority to restore if a writer raised the reader's priority.
+    std::optional<UBaseType_t> base_priority;
+  };
+
+  // Return false on timeout.
+  bool TryLock(TickType_t timeout);
+  bool TryLockShared(TickType_t timeout);
+
+  int readers() const;
+
+  // Held by a writer from before it waits for readers until it unlocks. New
+  // readers take it briefly on their way in.
+  StaticSemaphore_t writer_storage_;
+  SemaphoreHandle_t writer_;
+  // Guards the fields below. Only held briefly.
+  StaticSemaphore_t state_storage_;
+  SemaphoreHandle_t state_;
+  Reader readers_[kMaxReaders];
+  bool writer_waiting_ = false;
+  // Given when the last reader leaves while a writer waits.
+  StaticSemaphore_t drained_storage_;
+  SemaphoreHandle_t drained_;
+};
+
+class WriterMutexLock {
+ public:
+  explicit WriterMutexLock(SharedMutex& mutex) : mutex_(mutex) {
+    mutex_.Lock();
+  }
+  ~WriterMutexLock() { mutex_.Unlock(); }
+  WriterMutexLock(const WriterMutexLock&) = delete;
+  WriterMutexLock& operator=(const WriterMutexLock&) = delete;
+
+ private:
+  SharedMutex& mutex_;
+};
+
+class ReaderMutexLock {
+ public:
+  explicit ReaderMutexLock(SharedMutex& mutex) : mutex_(mutex) {
+    mutex_.LockShared();
+  }
+  ~ReaderMutexLock() { mutex_.UnlockShared(); }
+  ReaderMutexLock(const ReaderMutexLock&) = delete;
+  ReaderMutexLock& operator=(const ReaderMutexLock&) = delete;
+
+ private:
+  SharedMutex& mutex_;
+};
+
+// A borrowed resource guarded by a SharedMutex that this pointer has locked,
+// shared if T is const and exclusively otherwise. Destroying it unlocks the
+// mutex.
+template <typename T>
+class SharedBorrowedPointer {
+ public:
+  SharedBorrowedPointer(T* value, SharedMutex* mutex)
+      : value_(value), mutex_(mutex) {}
+  SharedBorrowedPointer(SharedBorrowedPointer&& o)
+      : value_(std::exchange(o.value_, nullptr)),
+        mutex_(std::exchange(o.mutex_, nullptr)) {}
+  SharedBorrowedPointer& operator=(SharedBorrowedPointer&& o) {
+    Release();
+    value_ = std::exchange(o.value_, nullptr);
+    mutex_ = std::exchange(o.mutex_, nullptr);
+    return *this;
+  }
+  ~SharedBorrowedPointer() { Release(); }
+
+  T* operator->() const {
+    configASSERT(mutex_ != nullptr);
+    return value_;
+  }
+  T& operator*() const {
+    configASSERT(mutex_ != nullptr);
+    return *value_;
+  }
+
+  operator bool() const { return mutex_ != nullptr; }
+
+  void Release() {
+    if (mutex_ == nullptr) return;
+    if constexpr (std::is_const_v<T>) {
+      mutex_->UnlockShared();
+    } else {
+      mutex_->Unlock();
+    }
+    value_ = nullptr;
+    mutex_ = nullptr;
+  }
+
+ private:
+  T* value_;
+  SharedMutex* mutex_;
+};
+
+// Like Borrowable, for read-mostly resources: any number of tasks may hold a
+// ReadBorrow, which only allows const access, or one task a Borrow. This is
+// a pointer-like type and should be passed by value. The underlying object
+// and mutex must outlive it.
+template <typename T>
+class SharedBorrowable {
+ public:
+  SharedBorrowable(T* value, SharedMutex* mutex)
+      : value_(value), mutex_(mutex) {}
+
+  // Borrows the resource exclusively. Waits until the resource is available.
+  SharedBorrowedPointer<T> Borrow() {
+    mutex_->Lock();
+    return SharedBorrowedPointer<T>(value_, mutex_);
+  }
+
+  // Tries to borrow the resource exclusively. If it can't be borrowed by the
+  // time ms passes, returns nullopt.
+  std::optional<SharedBorrowedPointer<T>> TryBorrow(int ms) {
+    if (!mutex_->LockWithTimeout(ms)) return std::nullopt;
+    return SharedBorrowedPointer<T>(value_, mutex_);
+  }
+
+  // Borrows the resource for reading, alongside other readers.
+  SharedBorrowedPointer<const T> ReadBorrow() {
+    mutex_->LockShared();
+    return SharedBorrowedPointer<const T>(value_, mutex_);
+  }
+
+  std::optional<SharedBorrowedPointer<const T>> TryReadBorrow(int ms) {
+    if (!mutex_->LockSharedWithTimeout(ms)) return std::nullopt;
+    return SharedBorrowedPointer<const T>(value_, mutex_);
+  }
+
+ private:
+  T* value_;
+  SharedMutex* mutex_;
+};
+
+// A SharedBorrowable that owns the resource and its mutex.
+template <typename T>
+class OwnerSharedBorrowable : public SharedBorrowable<T> {
+ public:
+  template <typename... Args>
+  explicit OwnerSharedBorrowable(std::in_place_t, Args&&... args)
+      : SharedBorrowable<T>(&value_, &mutex_),
+        value_(std::forward<Args>(args)...) {}
+
+ private:
+  T value_;
+  SharedMutex mutex_;
+};
+
+}  // namespace freertosxx
+
+#endif  // FREERTOSXX_SHARED_MUTEX_H
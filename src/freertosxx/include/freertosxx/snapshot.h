@@ -0,0 +1,92 @@
+#ifndef FREERTOSXX_SNAPSHOT_H
+#define FREERTOSXX_SNAPSHOT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+namespace freertosxx {
+
+// The latest value of a small, trivially copyable T, e.g. a sensor reading,
+// that readers copy without taking any lock: a seqlock.
+//
+// Store bumps a sequence number to odd, writes the value, and bumps it back
+// to even. Load copies the value and retries if the sequence number was odd
+// or changed meanwhile. Stores run in a critical section, so a reader never
+// waits on a writer that was preempted mid-store; a reader on the other core
+// retries for at most the few cycles a store takes. Keep T small: a store
+// masks interrupts for as long as it takes to copy it.
+//
+// Load may be called from any task or ISR, Store from any task, and
+// StoreFromISR from an ISR.
+template <typename T>
+class Snapshot {
+ public:
+  static_assert(std::is_trivially_copyable_v<T>);
+
+  explicit Snapshot(const T& value = T{}) { Write(value); }
+
+  T Load() const {
+    Words words;
+    while (true) {
+      const uint32_t sequence = sequence_.load(std::memory_order_acquire);
+      if (sequence & 1) continue;
+      for (size_t i = 0; i < kWords; ++i) {
+        words[i] = words_[i].load(std::memory_order_relaxed);
+      }
+      // Orders the copy before the second load of the sequence number.
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (sequence_.load(std::memory_order_relaxed) == sequence) break;
+    }
+    T value;
+    std::memcpy(&value, words, sizeof(T));
+    return value;
+  }
+
+  void Store(const T& value) {
+    taskENTER_CRITICAL();
+    Write(value);
+    taskEXIT_CRITICAL();
+  }
+
+  void StoreFromISR(const T& value) {
+    const UBaseType_t saved = taskENTER_CRITICAL_FROM_ISR();
+    Write(value);
+    taskEXIT_CRITICAL_FROM_ISR(saved);
+  }
+
+  // Advances by one with every store, e.g. to tell whether the value has
+  // changed since a previous Load.
+  uint32_t version() const {
+    return sequence_.load(std::memory_order_acquire) / 2;
+  }
+
+ private:
+  static constexpr size_t kWords = (sizeof(T) + 3) / 4;
+  using Words = uint32_t[kWords];
+
+  void Write(const T& value) {
+    Words words = {};
+    std::memcpy(words, &value, sizeof(T));
+    const uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+    sequence_.store(sequence + 1, std::memory_order_relaxed);
+    // Orders the odd sequence number before the writes of the value.
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kWords; ++i) {
+      words_[i].store(words[i], std::memory_order_relaxed);
+    }
+    sequence_.store(sequence + 2, std::memory_order_release);
+  }
+
+  std::atomic<uint32_t> sequence_ = 0;
+  std::atomic<uint32_t> words_[kWords];
+};
+
+}  // namespace freertosxx
+
+#endif  // FREERTOSXX_SNAPSHOT_H
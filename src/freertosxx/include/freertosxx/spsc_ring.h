@@ -0,0 +1,128 @@
+#ifndef FREERTOSXX_SPSC_RING_H
+#define FREERTOSXX_SPSC_RING_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+
+namespace freertosxx {
+
+// The granularity at which the rings keep producer and consumer state apart.
+// The RP2040 has no data cache, so on the device this only keeps each side's
+// indices in words of their own; on a host it avoids false sharing.
+#if defined(PICO_ON_DEVICE) && PICO_ON_DEVICE
+inline constexpr size_t kCacheLineSize = sizeof(uint32_t);
+#else
+inline constexpr size_t kCacheLineSize = 64;
+#endif
+
+// A lock-free ring for one producer and one consumer of trivially copyable
+// items, e.g. ADC or PIO samples. Either side may be an ISR or run on the
+// other core: no kernel calls are made, and the Try methods never block.
+// Pair the ring with a waiter from ring_wait.h to block the consumer.
+//
+// Each side caches the other side's index and reloads it only when the ring
+// looks full (producer) or empty (consumer), so a burst touches the shared
+// indices once.
+template <typename T, int Size>
+class SpscRing {
+ public:
+  static_assert(std::is_trivially_copyable_v<T>);
+  static_assert(Size > 0 && std::has_single_bit(static_cast<unsigned>(Size)));
+
+  static constexpr int capacity() { return Size; }
+
+  // Producer side.
+
+  bool TryPush(const T& item) { return TryPushMany(std::span(&item, 1)) == 1; }
+
+  // Copies as many items as fit. Returns the number copied.
+  size_t TryPushMany(std::span<const T> items) {
+    const uint32_t tail = producer_.tail.load(std::memory_order_relaxed);
+    size_t free = Size - (tail - producer_.cached_head);
+    if (free < items.size()) {
+      producer_.cached_head = consumer_.head.load(std::memory_order_acquire);
+      free = Size - (tail - producer_.cached_head);
+    }
+    const size_t n = std::min(items.size(), free);
+    if (n == 0) return 0;
+    const uint32_t index = tail & kMask;
+    const size_t first = std::min<size_t>(n, Size - index);
+    std::memcpy(&items_[index], items.data(), first * sizeof(T));
+    std::memcpy(&items_[0], items.data() + first, (n - first) * sizeof(T));
+    producer_.tail.store(tail + n, std::memory_order_release);
+    return n;
+  }
+
+  // Consumer side.
+
+  bool TryPop(T& item) { return TryPopMany(std::span(&item, 1)) == 1; }
+
+  // Copies out as many items as are queued, up to out.size().
+  size_t TryPopMany(std::span<T> out) {
+    size_t received = 0;
+    for (std::span<const T> run = Peek(); !run.empty() && received < out.size();
+         run = Peek()) {
+      const size_t n = std::min(run.size(), out.size() - received);
+      std::memcpy(&out[received], run.data(), n * sizeof(T));
+      Consume(n);
+      received += n;
+    }
+    return received;
+  }
+
+  // The contiguous run of items at the front of the ring, in place. When the
+  // queued items wrap around the end of the ring, only the run up to the end
+  // is returned. The items stay queued until consumed.
+  std::span<const T> Peek() {
+    const uint32_t head = consumer_.head.load(std::memory_order_relaxed);
+    if (consumer_.cached_tail == head) {
+      consumer_.cached_tail = producer_.tail.load(std::memory_order_acquire);
+    }
+    const uint32_t index = head & kMask;
+    return std::span<const T>(
+        &items_[index],
+        std::min<uint32_t>(consumer_.cached_tail - head, Size - index));
+  }
+
+  // Removes the first n peeked items.
+  void Consume(size_t n) {
+    consumer_.head.store(
+        consumer_.head.load(std::memory_order_relaxed) + n,
+        std::memory_order_release);
+  }
+
+  // Either side.
+
+  size_t size() const {
+    return producer_.tail.load(std::memory_order_acquire) -
+           consumer_.head.load(std::memory_order_acquire);
+  }
+  bool empty() const { return size() == 0; }
+
+ private:
+  static constexpr uint32_t kMask = Size - 1;
+
+  // Indices are monotonic counts of items pushed and popped.
+  struct alignas(kCacheLineSize) Producer {
+    std::atomic<uint32_t> tail = 0;
+    uint32_t cached_head = 0;
+  };
+  struct alignas(kCacheLineSize) Consumer {
+    std::atomic<uint32_t> head = 0;
+    uint32_t cached_tail = 0;
+  };
+
+  Producer producer_;
+  Consumer consumer_;
+  alignas(kCacheLineSize) T items_[Size];
+};
+
+}  // namespace freertosxx
+
+#endif  // FREERTOSXX_SPSC_RING_H
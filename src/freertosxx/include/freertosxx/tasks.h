@@ -0,0 +1,135 @@
+#ifndef FREERTOSXX_TASKS_H
+#define FREERTOSXX_TASKS_H
+
+#include <cstddef>
+#include <functional>
+
+#include "FreeRTOS.h"
+#include "freertosxx/notify.h"
+#include "task.h"
+
+namespace freertosxx {
+
+// Task priorities, so that the relative priority of tasks is visible at a
+// glance. lwIP's tcpip thread runs at TCPIP_THREAD_PRIO from the lwIP config.
+enum class Priority : UBaseType_t {
+  kIdle = tskIDLE_PRIORITY,
+  kNormal = tskIDLE_PRIORITY + 1,
+  kHigh = tskIDLE_PRIORITY + 2,
+  kHighest = configMAX_PRIORITIES - 1,
+};
+
+// Masks of the cores a task may run on.
+inline constexpr UBaseType_t kAnyCore = tskNO_AFFINITY;
+inline constexpr UBaseType_t kCore0 = 1 << 0;
+inline constexpr UBaseType_t kCore1 = 1 << 1;
+
+// A task running a function.
+//
+// Every Task is registered for stack telemetry: VisitStacks and
+// StartStackMonitor report how close each task has come to overflowing its
+// stack, so that stacks can be sized from measurements.
+//
+// When the function returns, the task suspends itself until the Task is
+// destroyed. Destroying a Task deletes its task, so it must not be running
+// at the time: Join it, or make sure it is blocked.
+//
+// A task that would rather end by deleting itself must call DeleteSelf, not
+// vTaskDelete(nullptr): the idle task frees the TCB of a deleted task whose
+// stack came from the heap, after which the Task must not touch its handle.
+// Only a StaticTask, whose TCB outlives the deletion, may call vTaskDelete
+// itself, as main_task does.
+//
+// Needs INCLUDE_uxTaskGetStackHighWaterMark, INCLUDE_eTaskGetState and
+// INCLUDE_vTaskSuspend, and configUSE_CORE_AFFINITY to pin tasks to cores.
+class Task {
+ public:
+  struct Options {
+    const char* name;
+    Priority priority = Priority::kNormal;
+    UBaseType_t cores = kAnyCore;
+  };
+
+  // Creates a task with a stack of stack_words from the heap.
+  Task(Options options, size_t stack_words, std::move_only_function<void()> fn)
+      : Task(options, stack_words, std::move(fn), nullptr, nullptr) {}
+  ~Task();
+  Task(const Task&) = delete;
+  Task(Task&&) = delete;
+  Task& operator=(const Task&) = delete;
+  Task& operator=(Task&&) = delete;
+
+  TaskHandle_t handle() const { return handle_; }
+  const char* name() const { return name_; }
+
+  // Waits for the function to return. Only one task may join, and it waits
+  // on its notification at kDefaultNotifyIndex. Never returns for a task
+  // that deletes itself.
+  void Join();
+
+  // Deletes the calling task, which must be a Task's. The Task stops
+  // visiting it, and destroying the Task only unregisters it.
+  static void DeleteSelf();
+
+  struct StackStats {
+    const char* name;
+    size_t stack_words;
+    // The least free stack the task has ever had.
+    size_t min_free_words;
+    // Whether min_free_words is lower than at the previous visit.
+    bool new_low;
+  };
+  // Samples the stack of every Task and calls fn with each. Do not create or
+  // destroy a Task from fn.
+  static void VisitStacks(const std::function<void(const StackStats&)>& fn);
+
+ protected:
+  // Creates the task on the given stack and TCB, or on the heap if they are
+  // null.
+  Task(
+      Options options, size_t stack_words, std::move_only_function<void()> fn,
+      StackType_t* stack, StaticTask_t* tcb);
+
+ private:
+  static void Run(void* task);
+
+  const char* const name_;
+  const size_t stack_words_;
+  std::move_only_function<void()> fn_;
+  TaskHandle_t handle_ = nullptr;
+
+  bool finished_ = false;
+  // Set by DeleteSelf, under the registry's mutex.
+  bool deleted_ = false;
+  BinarySignal joined_{nullptr};
+  bool joining_ = false;
+
+  size_t min_free_words_ = SIZE_MAX;
+  Task* next_task_ = nullptr;
+};
+
+// A Task whose stack and TCB are part of this object, e.g. a global, rather
+// than on the heap. Needs configSUPPORT_STATIC_ALLOCATION.
+template <size_t StackWords>
+class StaticTask : public Task {
+ public:
+  StaticTask(Options options, std::move_only_function<void()> fn)
+      : Task(options, StackWords, std::move(fn), stack_, &tcb_) {}
+
+ private:
+  StackType_t stack_[StackWords];
+  StaticTask_t tcb_;
+};
+
+// Restricts the task with the given name, e.g. lwIP's TCPIP_THREAD_NAME, to
+// cores. For tasks that some library creates. Needs INCLUDE_xTaskGetHandle.
+// Returns false if there is no such task.
+bool SetCoreAffinity(const char* task_name, UBaseType_t cores);
+
+// Starts a task that samples every Task's stack each period and prints the
+// ones that reached a new low.
+void StartStackMonitor(TickType_t period);
+
+}  // namespace freertosxx
+
+#endif  // FREERTOSXX_TASKS_H
@@ -0,0 +1,184 @@
+#ifndef FREERTOSXX_TIMER_WHEEL_H
+#define FREERTOSXX_TIMER_WHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+
+#include "FreeRTOS.h"
+#include "freertosxx/notify.h"
+#include "freertosxx/tasks.h"
+
+namespace freertosxx {
+
+// Runs a timer's callback, e.g. while holding a lock that the callback
+// expects to hold. Timers without a context run their callback directly.
+using TimerContext = void (*)(std::move_only_function<void()>& fn);
+
+class TimerToken;
+
+// Runs delayed callbacks on one task. Unlike xTimerPendFunctionCall, which
+// has no delay and fails once the timer command queue fills, a wheel holds
+// any number of timers up to its pool of nodes.
+//
+// Timers live in a hierarchical wheel: kLevels levels of kSlots slots, each
+// slot of level L covering kSlots^L ticks. Scheduling and cancelling a timer
+// take O(1) time in a short critical section, and allocate nothing. As time
+// passes, the timers in a higher-level slot cascade down into the level
+// below, so each timer moves at most kLevels - 1 times. The task only wakes
+// when a timer expires or a slot is due to cascade.
+//
+// Callbacks run on the wheel's task, one at a time, in order of expiry;
+// timers that expire on the same tick run in no particular order.
+// Delays are in ticks, with a resolution of one tick, and may be up to
+// kSlots^kLevels ticks; longer delays are served by cascading more than once.
+class TimerWheel {
+ public:
+  static constexpr int kSlotBits = 6;
+  static constexpr uint32_t kSlots = 1 << kSlotBits;
+  static constexpr int kLevels = 4;
+
+  using Callback = std::move_only_function<void()>;
+
+  TimerWheel(const TimerWheel&) = delete;
+  TimerWheel& operator=(const TimerWheel&) = delete;
+
+  // Calls fn after delay ticks, in context if given. Returns a token that
+  // cancels the timer, or an empty token if every node is in use. A lambda
+  // that captures no more than a pointer or two is stored in the node; a
+  // larger one is allocated on the heap.
+  TimerToken Schedule(
+      TickType_t delay, Callback fn, TimerContext context = nullptr);
+
+  struct Stats {
+    size_t capacity;
+    size_t pending;
+    // The most timers ever pending at once.
+    size_t high_water;
+    uint32_t fired;
+    uint32_t cancelled;
+    // Schedules that found every node in use.
+    uint32_t failures;
+    // Ticks the wheel has stepped through, including while catching up.
+    uint32_t advances;
+  };
+  Stats stats() const;
+
+ protected:
+  struct Node {
+    // Links within a slot, or the free list.
+    Node* next = nullptr;
+    Node* prev = nullptr;
+    TickType_t expiry = 0;
+    // Advanced each time the node is freed, so stale tokens miss.
+    uint32_t generation = 0;
+    enum State : uint8_t { kFree, kPending, kRunning } state = kFree;
+    // Where a pending node is.
+    uint8_t level = 0;
+    uint8_t slot = 0;
+    TimerContext context = nullptr;
+    Callback fn;
+  };
+
+  TimerWheel() = default;
+  ~TimerWheel() = default;
+
+  // Called by the owner once nodes exist, before the task starts.
+  void Init(std::span<Node> nodes);
+  // Binds the wheel to the task that calls Run.
+  void Bind(TaskHandle_t task) { wake_.Bind(task); }
+  // The body of the wheel's task. Returns after Stop.
+  void Run();
+  // Makes Run return, discarding pending timers.
+  void Stop();
+
+ private:
+  friend class TimerToken;
+
+  bool Cancel(Node* node, uint32_t generation);
+
+  // The following need the critical section.
+  void Insert(Node* node);
+  void Unlink(Node* node);
+  void Free(Node* node);
+  // Expires the timers of tick now_ onto ready, cascading first if a level
+  // wraps.
+  void Advance(Node*& ready);
+  // Ticks from now_ until the wheel next has work to do.
+  TickType_t Idle() const;
+
+  std::span<Node> nodes_;
+  Node* free_ = nullptr;
+  Node* slots_[kLevels][kSlots] = {};
+  // Bit i of occupied_[level] is set while slots_[level][i] is non-empty.
+  uint64_t occupied_[kLevels] = {};
+  // The next tick to expire. Lags the tick count while the task sleeps.
+  TickType_t now_ = 0;
+  // The tick at which the sleeping task will wake.
+  TickType_t wake_at_ = 0;
+  bool sleeping_ = false;
+  bool stopping_ = false;
+  BinarySignal wake_{nullptr};
+
+  size_t pending_ = 0;
+  size_t high_water_ = 0;
+  uint32_t fired_ = 0;
+  uint32_t cancelled_ = 0;
+  uint32_t failures_ = 0;
+  uint32_t advances_ = 0;
+};
+
+// Cancels a scheduled timer. Copyable, and safe to use after the timer has
+// fired or been cancelled, as long as the wheel exists.
+class TimerToken {
+ public:
+  TimerToken() = default;
+
+  // Cancels the timer, unless it has already fired or started to. Returns
+  // whether it was cancelled. Cancelling an empty token does nothing.
+  bool Cancel() {
+    return wheel_ != nullptr && wheel_->Cancel(node_, generation_);
+  }
+
+  explicit operator bool() const { return wheel_ != nullptr; }
+
+ private:
+  friend class TimerWheel;
+
+  TimerToken(TimerWheel* wheel, TimerWheel::Node* node, uint32_t generation)
+      : wheel_(wheel), node_(node), generation_(generation) {}
+
+  TimerWheel* wheel_ = nullptr;
+  TimerWheel::Node* node_ = nullptr;
+  uint32_t generation_ = 0;
+};
+
+// A TimerWheel with Count nodes and a task of StackWords, all part of this
+// object. Callbacks run on its stack.
+template <size_t Count, size_t StackWords = 512>
+class StaticTimerWheel : public TimerWheel {
+ public:
+  explicit StaticTimerWheel(Task::Options options) {
+    Init(nodes_);
+    task_.emplace(options, [this] { Run(); });
+    Bind(task_->handle());
+  }
+  ~StaticTimerWheel() {
+    Stop();
+    task_->Join();
+  }
+
+ private:
+  Node nodes_[Count];
+  std::optional<StaticTask<StackWords>> task_;
+};
+
+// A wheel of 32 timers, on a task at Priority::kHigh with 1024 words of
+// stack, for callers that need no wheel of their own. Created on first use.
+TimerWheel& DefaultTimerWheel();
+
+}  // namespace freertosxx
+
+#endif  // FREERTOSXX_TIMER_WHEEL_H
@@ -0,0 +1,108 @@
+#ifndef FREERTOSXX_WORK_DEQUE_H
+#define FREERTOSXX_WORK_DEQUE_H
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+
+#include "freertosxx/spsc_ring.h"
+
+namespace freertosxx {
+
+// A bounded Chase-Lev work-stealing deque of trivially copyable items. Its
+// owner pushes and pops at the bottom, like a stack; any other task or core
+// may steal from the top. The owner only contends with thieves over the last
+// item.
+//
+// As with MpscRing, the compare-and-swap is lock-free on hosts and uses the
+// SDK's atomic helpers on the RP2040. As with SpscRing, top and bottom only
+// ever increase and are compared by their difference, so they may wrap.
+template <typename T, int Size>
+class WorkDeque {
+ public:
+  static_assert(std::is_trivially_copyable_v<T>);
+  static_assert(Size > 0 && std::has_single_bit(static_cast<unsigned>(Size)));
+
+  static constexpr int capacity() { return Size; }
+
+  // Owner side. Returns false if the deque is full.
+  bool Push(const T& item) {
+    const uint32_t bottom = bottom_.load(std::memory_order_relaxed);
+    const uint32_t top = top_.load(std::memory_order_acquire);
+    if (Count(top, bottom) >= Size) return false;
+    items_[bottom & kMask].store(item, std::memory_order_relaxed);
+    bottom_.store(bottom + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Owner side. Returns the most recently pushed item.
+  std::optional<T> Pop() {
+    const uint32_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(bottom, std::memory_order_relaxed);
+    // Publishes the claim on the bottom item before looking at the top, so
+    // that a thief and the owner cannot both take it.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint32_t top = top_.load(std::memory_order_relaxed);
+    const int32_t count = Count(top, bottom);
+    if (count < 0) {
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+      return std::nullopt;
+    }
+    std::optional<T> item = items_[bottom & kMask].load(
+        std::memory_order_relaxed);
+    if (count == 0) {
+      // The last item: race the thieves for it.
+      if (!top_.compare_exchange_strong(
+              top,
+              top + 1,
+              std::memory_order_seq_cst,
+              std::memory_order_relaxed)) {
+        item = std::nullopt;
+      }
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return item;
+  }
+
+  // Any task. Returns the least recently pushed item, or nullopt if the
+  // deque is empty or another thief or the owner won it.
+  std::optional<T> Steal() {
+    uint32_t top = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const uint32_t bottom = bottom_.load(std::memory_order_acquire);
+    if (Count(top, bottom) <= 0) return std::nullopt;
+    const T item = items_[top & kMask].load(std::memory_order_relaxed);
+    if (!top_.compare_exchange_strong(
+            top, top + 1, std::memory_order_seq_cst,
+            std::memory_order_relaxed)) {
+      return std::nullopt;
+    }
+    return item;
+  }
+
+  // Any task, though only a hint outside the owner.
+  bool empty() const {
+    return Count(
+               top_.load(std::memory_order_acquire),
+               bottom_.load(std::memory_order_acquire)) <= 0;
+  }
+
+ private:
+  static constexpr uint32_t kMask = Size - 1;
+
+  // The number of items between top and bottom, which is -1 while Pop has
+  // claimed the bottom of an empty deque.
+  static int32_t Count(uint32_t top, uint32_t bottom) {
+    return static_cast<int32_t>(bottom - top);
+  }
+
+  alignas(kCacheLineSize) std::atomic<uint32_t> top_ = 0;
+  alignas(kCacheLineSize) std::atomic<uint32_t> bottom_ = 0;
+  alignas(kCacheLineSize) std::atomic<T> items_[Size] = {};
+};
+
+}  // namespace freertosxx
+
+#endif  // FREERTOSXX_WORK_DEQUE_H
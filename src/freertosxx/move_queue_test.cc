@@ -0,0 +1,79 @@
+#include "freertosxx/move_queue.h"
+
+#include <array>
+#include <memory>
+#include <string>
+
+#include "FreeRTOS.h"
+#include "pico/platform.h"
+#include "pico/printf.h"
+#include "task.h"
+#include "util/expect.h"
+
+using freertosxx::MoveQueue;
+using jagspico::Expect;
+
+namespace {
+
+// A large, move-only payload that counts how often it is moved.
+struct Payload {
+  explicit Payload(int seq) : seq(seq) { data.fill(static_cast<char>(seq)); }
+  Payload(Payload&& o) : seq(o.seq), data(o.data), moves(o.moves + 1) {}
+  Payload(const Payload&) = delete;
+
+  int seq;
+  std::array<char, 256> data;
+  int moves = 0;
+};
+
+constexpr int kMessages = 1000;
+
+MoveQueue<Payload, 4> g_payloads;
+MoveQueue<std::unique_ptr<std::string>, 2> g_strings;
+
+void Producer(void*) {
+  for (int i = 0; i < kMessages; ++i) {
+    g_payloads.Emplace(i);
+  }
+  vTaskDelete(nullptr);
+}
+
+}  // namespace
+
+extern "C" void main_task(void*) {
+  // Ownership of heap objects moves through the queue.
+  g_strings.Send(std::make_unique<std::string>("hello"));
+  {
+    auto item = g_strings.Receive();
+    Expect(**item == "hello", "string");
+    std::unique_ptr<std::string> taken = std::move(*item);
+    Expect(*taken == "hello", "taken string");
+  }
+
+  // Received items hold their slot until they are destroyed.
+  g_strings.Send(std::make_unique<std::string>("a"));
+  g_strings.Send(std::make_unique<std::string>("b"));
+  auto a = g_strings.Receive();
+  Expect(
+      !g_strings.SendWithTimeout(1, std::make_unique<std::string>("c")),
+      "full while an item is held");
+  a.Reset();
+  Expect(
+      g_strings.SendWithTimeout(1, std::make_unique<std::string>("c")),
+      "slot freed by Reset");
+  Expect(**g_strings.Receive() == "b", "fifo order");
+  Expect(**g_strings.Receive() == "c", "fifo order");
+  Expect(!g_strings.ReceiveWithTimeout(1), "empty");
+
+  // Payloads are constructed in their slots and never moved or copied.
+  xTaskCreate(Producer, "producer", 512, nullptr, 1, nullptr);
+  for (int i = 0; i < kMessages; ++i) {
+    auto item = g_payloads.Receive();
+    Expect(item->seq == i, "sequence");
+    Expect(item->data[255] == static_cast<char>(i), "data");
+    Expect(item->moves == 0, "no moves");
+  }
+
+  printf("PASS\n");
+  vTaskDelete(nullptr);
+}
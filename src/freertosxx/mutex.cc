@@ -4,9 +4,19 @@
 
 namespace freertosxx {
 
-Mutex::Mutex() { mutex_ = xSemaphoreCreateMutex(); }
+Mutex::Mutex(const char* name) {
+  mutex_ = xSemaphoreCreateMutex();
+#if FREERTOSXX_MUTEX_PROFILING
+  profile_ = new internal::MutexProfile(name, this);
+#else
+  (void)name;
+#endif
+}
 
 Mutex::~Mutex() {
+#if FREERTOSXX_MUTEX_PROFILING
+  delete profile_;
+#endif
   if (mutex_ == nullptr) return;
   configASSERT(xSemaphoreGetMutexHolder(mutex_) == NULL);
   vSemaphoreDelete(mutex_);
@@ -17,6 +27,11 @@ Mutex::Mutex(Mutex&& o) { *this = std::forward<Mutex&&>(o); }
 Mutex& Mutex::operator=(Mutex&& o) {
   configASSERT(xSemaphoreGetMutexHolder(o.mutex_) == nullptr);
   mutex_ = std::exchange(o.mutex_, nullptr);
+#if FREERTOSXX_MUTEX_PROFILING
+  delete profile_;
+  profile_ = std::exchange(o.profile_, nullptr);
+  if (profile_ != nullptr) profile_->set_mutex(this);
+#endif
   return *this;
 }
 }  // namespace freertosxx
\ No newline at end of file
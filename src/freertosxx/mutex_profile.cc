@@ -0,0 +1,129 @@
+#include "freertosxx/mutex_profile.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "freertosxx/critical_section.h"
+
+#if FREERTOSXX_MUTEX_PROFILING
+#include "pico/time.h"
+#endif
+
+namespace freertosxx {
+
+#if FREERTOSXX_MUTEX_PROFILING
+
+namespace internal {
+
+namespace {
+
+MutexProfile* g_profiles = nullptr;
+
+}  // namespace
+
+MutexProfile::MutexProfile(const char* name, const void* mutex)
+    : stats_{.name = name, .mutex = mutex} {
+  CriticalSection critical_section;
+  next_ = g_profiles;
+  g_profiles = this;
+}
+
+MutexProfile::~MutexProfile() {
+  CriticalSection critical_section;
+  for (MutexProfile** p = &g_profiles; *p != nullptr; p = &(*p)->next_) {
+    if (*p == this) {
+      *p = next_;
+      break;
+    }
+  }
+}
+
+void MutexProfile::Acquired(uint32_t wait_start_us, bool waited) {
+  const uint32_t now_us = time_us_32();
+  const uint32_t wait_us = now_us - wait_start_us;
+  CriticalSection critical_section;
+  acquired_us_ = now_us;
+  ++stats_.acquisitions;
+  if (!waited) return;
+  ++stats_.contended;
+  stats_.total_wait_us += wait_us;
+  stats_.max_wait_us = std::max(stats_.max_wait_us, wait_us);
+}
+
+void MutexProfile::Failed() {
+  CriticalSection critical_section;
+  ++stats_.contended;
+  ++stats_.failures;
+}
+
+void MutexProfile::Releasing() {
+  const uint32_t hold_us = time_us_32() - acquired_us_;
+  CriticalSection critical_section;
+  stats_.max_hold_us = std::max(stats_.max_hold_us, hold_us);
+}
+
+MutexStats MutexProfile::stats() const {
+  CriticalSection critical_section;
+  return stats_;
+}
+
+}  // namespace internal
+
+void VisitMutexStats(const std::function<void(const MutexStats&)>& fn) {
+  // Like the pool registry, this assumes mutexes are not created or destroyed
+  // while it runs.
+  for (const internal::MutexProfile* profile = internal::g_profiles;
+       profile != nullptr;
+       profile = profile->next()) {
+    fn(profile->stats());
+  }
+}
+
+#else
+
+void VisitMutexStats(const std::function<void(const MutexStats&)>&) {}
+
+#endif
+
+size_t FormatMutexStats(const MutexStats& stats, std::span<char> out) {
+  if (out.empty()) return 0;
+  char unnamed[24];
+  const char* name = stats.name;
+  if (name == nullptr) {
+    snprintf(unnamed, sizeof(unnamed), "mutex@%p", stats.mutex);
+    name = unnamed;
+  }
+  const uint32_t average_wait_us =
+      stats.contended == stats.failures
+          ? 0
+          : static_cast<uint32_t>(
+                stats.total_wait_us / (stats.contended - stats.failures));
+  const int length = snprintf(
+      out.data(),
+      out.size(),
+      "%s: %lu locks, %lu contended, %lu failed, wait avg %luus max %luus, "
+      "hold max %luus",
+      name,
+      static_cast<unsigned long>(stats.acquisitions),
+      static_cast<unsigned long>(stats.contended),
+      static_cast<unsigned long>(stats.failures),
+      static_cast<unsigned long>(average_wait_us),
+      static_cast<unsigned long>(stats.max_wait_us),
+      static_cast<unsigned long>(stats.max_hold_us));
+  if (length < 0) return 0;
+  return std::min(static_cast<size_t>(length), out.size() - 1);
+}
+
+void PrintMutexStats() {
+  if (!FREERTOSXX_MUTEX_PROFILING) {
+    printf("mutex profiling disabled\n");
+    return;
+  }
+  VisitMutexStats([](const MutexStats& stats) {
+    char line[128];
+    FormatMutexStats(stats, line);
+    printf("%s\n", line);
+  });
+}
+
+}  // namespace freertosxx
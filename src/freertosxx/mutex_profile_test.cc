@@ -0,0 +1,106 @@
+#include "freertosxx/mutex_profile.h"
+
+#include <atomic>
+#include <cstring>
+
+#include "FreeRTOS.h"
+#include "freertosxx/mutex.h"
+#include "freertosxx/tasks.h"
+#include "pico/platform.h"
+#include "pico/printf.h"
+#include "pico/time.h"
+#include "task.h"
+#include "util/expect.h"
+
+using freertosxx::Mutex;
+using freertosxx::MutexLock;
+using freertosxx::MutexStats;
+using freertosxx::Task;
+using jagspico::Expect;
+
+namespace {
+
+MutexStats StatsOf(const Mutex& mutex) {
+  MutexStats found{};
+  bool seen = false;
+  freertosxx::VisitMutexStats([&](const MutexStats& stats) {
+    if (stats.mutex != &mutex) return;
+    found = stats;
+    seen = true;
+  });
+  Expect(seen, "mutex registered");
+  return found;
+}
+
+void TestUncontended() {
+  Mutex mutex("uncontended");
+  for (int i = 0; i < 3; ++i) MutexLock lock(mutex);
+  Expect(mutex.TryLock(), "try lock");
+  Expect(!mutex.LockWithTimeout(0), "already held");
+  mutex.Unlock();
+
+  const MutexStats stats = StatsOf(mutex);
+  Expect(strcmp(stats.name, "uncontended") == 0, "name");
+  Expect(stats.acquisitions == 4, "acquisitions");
+  Expect(stats.contended == 1, "failure counts as contended");
+  Expect(stats.failures == 1, "failures");
+  Expect(stats.max_wait_us == 0, "no waits");
+}
+
+void TestContended() {
+  constexpr uint32_t kHoldMs = 20;
+  Mutex mutex("contended");
+  std::atomic<bool> holding = false;
+  mutex.Lock();
+  Task waiter({.name = "waiter"}, 256, [&] {
+    MutexLock lock(mutex);
+    holding = true;
+  });
+  busy_wait_us(kHoldMs * 1000);
+  mutex.Unlock();
+  waiter.Join();
+  Expect(holding, "waiter locked");
+
+  const MutexStats stats = StatsOf(mutex);
+  Expect(stats.acquisitions == 2, "acquisitions");
+  Expect(stats.contended == 1, "contended");
+  Expect(stats.failures == 0, "no failures");
+  // The waiter may start waiting a little after we lock.
+  Expect(stats.max_wait_us >= kHoldMs * 1000 / 2, "max wait");
+  Expect(stats.total_wait_us == stats.max_wait_us, "total wait");
+  Expect(stats.max_hold_us >= kHoldMs * 1000, "max hold");
+}
+
+void TestFormat() {
+  const MutexStats stats{
+      .name = nullptr,
+      .mutex = nullptr,
+      .acquisitions = 10,
+      .contended = 3,
+      .failures = 1,
+      .total_wait_us = 300,
+      .max_wait_us = 200,
+      .max_hold_us = 50,
+  };
+  char line[128];
+  const size_t length = freertosxx::FormatMutexStats(stats, line);
+  Expect(length == strlen(line), "length");
+  Expect(strstr(line, "mutex@") == line, "unnamed mutex");
+  Expect(strstr(line, "wait avg 150us max 200us") != nullptr, "waits");
+
+  char short_line[8];
+  Expect(
+      freertosxx::FormatMutexStats(stats, short_line) == sizeof(short_line) - 1,
+      "truncated");
+}
+
+}  // namespace
+
+extern "C" void main_task(void*) {
+  TestUncontended();
+  TestContended();
+  TestFormat();
+  freertosxx::PrintMutexStats();
+  printf("PASS\n");
+  vTaskDelete(nullptr);
+}
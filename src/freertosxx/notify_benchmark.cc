@@ -0,0 +1,117 @@
+// Compares the round-trip latency of signalling another task and waiting for
+// its reply through an EventGroup and through task notifications.
+
+#include <cstdint>
+
+#include "FreeRTOS.h"
+#include "freertosxx/event.h"
+#include "freertosxx/notify.h"
+#include "pico/printf.h"
+#include "pico/time.h"
+#include "task.h"
+
+namespace {
+
+using freertosxx::BinarySignal;
+using freertosxx::Notifier;
+using freertosxx::StaticEventGroup;
+
+constexpr int kRoundTrips = 20'000;
+constexpr uint32_t kPing = 1 << 0;
+constexpr uint32_t kPong = 1 << 1;
+constexpr uint32_t kStop = 1 << 2;
+
+void Report(const char* name, uint64_t start_us) {
+  const uint64_t elapsed_us = time_us_64() - start_us;
+  printf(
+      "%-16s %6llu ns/round trip\n",
+      name,
+      elapsed_us * 1000 / kRoundTrips);
+}
+
+StaticEventGroup g_events;
+
+void EventGroupEcho(void*) {
+  while (true) {
+    const EventBits_t bits = g_events.Wait(kPing | kStop, {.clear = true});
+    if (bits & kStop) break;
+    g_events.Set(kPong);
+  }
+  vTaskDelete(nullptr);
+}
+
+void BenchmarkEventGroup() {
+  xTaskCreate(EventGroupEcho, "echo", 256, nullptr, 1, nullptr);
+  const uint64_t start = time_us_64();
+  for (int i = 0; i < kRoundTrips; ++i) {
+    g_events.Set(kPing);
+    g_events.Wait(kPong, {.clear = true});
+  }
+  Report("EventGroup", start);
+  g_events.Set(kStop);
+}
+
+// Each side signals the other through a notification bound to the other's
+// task. The benchmarks run one at a time, so the signals bound to this task
+// can share a notification index.
+struct Signals {
+  BinarySignal ping{nullptr};
+  BinarySignal pong;
+  Notifier ping_bits{nullptr};
+  Notifier pong_bits;
+};
+Signals* g_signals;
+
+void BinarySignalEcho(void*) {
+  for (int i = 0; i < kRoundTrips; ++i) {
+    g_signals->ping.Wait();
+    g_signals->pong.Give();
+  }
+  vTaskDelete(nullptr);
+}
+
+void BenchmarkBinarySignal() {
+  TaskHandle_t echo;
+  xTaskCreate(BinarySignalEcho, "echo", 256, nullptr, 1, &echo);
+  g_signals->ping.Bind(echo);
+  const uint64_t start = time_us_64();
+  for (int i = 0; i < kRoundTrips; ++i) {
+    g_signals->ping.Give();
+    g_signals->pong.Wait();
+  }
+  Report("BinarySignal", start);
+}
+
+void NotifierEcho(void*) {
+  for (int i = 0; i < kRoundTrips; ++i) {
+    g_signals->ping_bits.Wait(kPing, {.clear = true});
+    g_signals->pong_bits.Set(kPong);
+  }
+  vTaskDelete(nullptr);
+}
+
+void BenchmarkNotifier() {
+  TaskHandle_t echo;
+  xTaskCreate(NotifierEcho, "echo", 256, nullptr, 1, &echo);
+  g_signals->ping_bits.Bind(echo);
+  const uint64_t start = time_us_64();
+  for (int i = 0; i < kRoundTrips; ++i) {
+    g_signals->ping_bits.Set(kPing);
+    g_signals->pong_bits.Wait(kPong, {.clear = true});
+  }
+  Report("Notifier", start);
+}
+
+}  // namespace
+
+extern "C" void main_task(void*) {
+  // The echo tasks run at the same priority as this one, so with both cores
+  // free each round trip crosses cores twice.
+  Signals signals;
+  g_signals = &signals;
+  BenchmarkEventGroup();
+  BenchmarkBinarySignal();
+  BenchmarkNotifier();
+  printf("DONE\n");
+  vTaskDelete(nullptr);
+}
@@ -0,0 +1,74 @@
+#include "freertosxx/notify.h"
+
+#include "FreeRTOS.h"
+#include "pico/platform.h"
+#include "pico/printf.h"
+#include "task.h"
+#include "util/expect.h"
+
+using namespace freertosxx;
+using jagspico::Expect;
+
+namespace {
+
+struct Signals {
+  Notifier notifier;
+  BinarySignal binary;
+  CountingSignal counting;
+};
+
+// Signals the main task from another task.
+void Signaller(void* arg) {
+  Signals& signals = *static_cast<Signals*>(arg);
+  signals.notifier.Set(0b01);
+  vTaskDelay(pdMS_TO_TICKS(5));
+  signals.notifier.Set(0b10);
+  signals.binary.Give();
+  for (int i = 0; i < 3; ++i) signals.counting.Give();
+  vTaskDelete(nullptr);
+}
+
+}  // namespace
+
+extern "C" void main_task(void*) {
+  // Each signal bound to this task needs its own notification index.
+  static_assert(configTASK_NOTIFICATION_ARRAY_ENTRIES >= 3);
+  Signals signals{
+      .notifier = Notifier(xTaskGetCurrentTaskHandle(), 0),
+      .binary = BinarySignal(xTaskGetCurrentTaskHandle(), 1),
+      .counting = CountingSignal(xTaskGetCurrentTaskHandle(), 2),
+  };
+
+  // Timeouts.
+  Expect(signals.notifier.Wait(1, {.timeout = 1}) == 0, "notifier timeout");
+  Expect(!signals.binary.Wait({.timeout = 1}), "binary timeout");
+  Expect(signals.counting.Wait({.timeout = 0}) == 0, "counting timeout");
+
+  // Gives collapse for a binary signal but accumulate for a counting one.
+  signals.binary.Give();
+  signals.binary.Give();
+  Expect(signals.binary.Wait({.timeout = 0}), "binary given");
+  Expect(!signals.binary.Wait({.timeout = 0}), "binary gives collapse");
+  for (int i = 0; i < 3; ++i) signals.counting.Give();
+  Expect(signals.counting.Wait({.timeout = 0}) == 1, "counting takes one");
+  Expect(signals.counting.Wait({.all = true, .timeout = 0}) == 2, "take all");
+
+  // Notifier bits behave like an EventGroup's.
+  signals.notifier.Set(0b100);
+  Expect(signals.notifier.Get() == 0b100, "notifier get");
+  Expect(signals.notifier.Clear(0b100) == 0b100, "notifier clear");
+  Expect(signals.notifier.Get() == 0, "notifier cleared");
+
+  // Across tasks. The signaller sets the bits 5ms apart, so waiting for all
+  // of them sees the first set bit without returning.
+  xTaskCreate(Signaller, "signaller", 256, &signals, 1, nullptr);
+  const uint32_t bits =
+      signals.notifier.Wait(0b11, {.clear = true, .all = true});
+  Expect(bits == 0b11, "notifier all");
+  Expect(signals.notifier.Get() == 0, "notifier clear on exit");
+  Expect(signals.binary.Wait(), "binary across tasks");
+  Expect(signals.counting.Wait({.all = true}) >= 1, "counting across tasks");
+
+  printf("PASS\n");
+  vTaskDelete(nullptr);
+}
@@ -0,0 +1,112 @@
+#include "freertosxx/pool.h"
+
+#include <cstdio>
+
+#include "FreeRTOS.h"
+#include "freertosxx/critical_section.h"
+
+namespace freertosxx {
+
+namespace {
+
+UntypedBlockPool* g_pools = nullptr;
+
+}  // namespace
+
+UntypedBlockPool::UntypedBlockPool(
+    const char* name, std::byte* storage, size_t block_size, size_t count)
+    : name_(name),
+      storage_(storage),
+      block_size_(block_size),
+      capacity_(count) {
+  configASSERT(block_size % kPoolAlignment == 0);
+  CriticalSection critical_section;
+  next_pool_ = g_pools;
+  g_pools = this;
+}
+
+UntypedBlockPool::~UntypedBlockPool() {
+  configASSERT(in_use_ == 0);
+  CriticalSection critical_section;
+  for (UntypedBlockPool** p = &g_pools; *p != nullptr; p = &(*p)->next_pool_) {
+    if (*p == this) {
+      *p = next_pool_;
+      break;
+    }
+  }
+}
+
+void* UntypedBlockPool::Allocate() {
+  CriticalSection critical_section;
+  void* block;
+  if (free_ != nullptr) {
+    block = free_;
+    free_ = free_->next;
+  } else if (untouched_ < capacity_) {
+    block = storage_ + block_size_ * untouched_++;
+  } else {
+    ++failures_;
+    return nullptr;
+  }
+  ++allocations_;
+  high_water_ = std::max(high_water_, ++in_use_);
+  return block;
+}
+
+void UntypedBlockPool::Free(void* block) {
+  configASSERT(Owns(block));
+  configASSERT(
+      (static_cast<std::byte*>(block) - storage_) % block_size_ == 0);
+  CriticalSection critical_section;
+  free_ = new (block) FreeBlock{free_};
+  --in_use_;
+}
+
+PoolStats UntypedBlockPool::stats() const {
+  CriticalSection critical_section;
+  return PoolStats{
+      .name = name_,
+      .block_size = block_size_,
+      .capacity = capacity_,
+      .in_use = in_use_,
+      .high_water = high_water_,
+      .allocations = allocations_,
+      .failures = failures_,
+  };
+}
+
+void UntypedBlockPool::VisitStats(
+    const std::function<void(const PoolStats&)>& fn) {
+  for (const UntypedBlockPool* pool = g_pools; pool != nullptr;
+       pool = pool->next_pool_) {
+    fn(pool->stats());
+  }
+}
+
+void PrintMemoryStats() {
+  HeapStats_t heap;
+  vPortGetHeapStats(&heap);
+  printf(
+      "heap: %u free (%u min ever), largest block %u, %u free blocks, "
+      "%u allocs, %u frees\n",
+      heap.xAvailableHeapSpaceInBytes,
+      heap.xMinimumEverFreeBytesRemaining,
+      heap.xSizeOfLargestFreeBlockInBytes,
+      heap.xNumberOfFreeBlocks,
+      heap.xNumberOfSuccessfulAllocations,
+      heap.xNumberOfSuccessfulFrees);
+  UntypedBlockPool::VisitStats([](const PoolStats& stats) {
+    printf(
+        "pool %s (%u-byte blocks): %u/%u in use (%u max), %lu allocs, "
+        "%lu failures\n",
+        stats.name,
+        stats.block_size,
+        stats.in_use,
+        stats.capacity,
+        stats.high_water,
+        stats.allocations,
+        stats.failures);
+  });
+}
+
+}  // namespace freertosxx
@@ -0,0 +1,133 @@
+#include <list>
+#include <string_view>
+#include <vector>
+
+#include "FreeRTOS.h"
+#include "freertosxx/arena.h"
+#include "freertosxx/pool.h"
+#include "pico/platform.h"
+#include "pico/printf.h"
+#include "task.h"
+#include "util/expect.h"
+
+using freertosxx::Arena;
+using freertosxx::ArenaAllocator;
+using freertosxx::ArenaScope;
+using freertosxx::BlockPool;
+using freertosxx::PoolAllocated;
+using freertosxx::PoolAllocator;
+using freertosxx::PoolSet;
+using freertosxx::PoolStats;
+using freertosxx::StaticArena;
+using jagspico::Expect;
+
+namespace {
+
+using Pools = PoolSet<BlockPool<32, 4>, BlockPool<64, 2>>;
+Pools g_pools("test");
+
+PoolStats StatsOf(std::string_view name) {
+  PoolStats result{};
+  freertosxx::UntypedBlockPool::VisitStats([&](const PoolStats& stats) {
+    if (stats.name == name) result = stats;
+  });
+  return result;
+}
+
+struct Small : PoolAllocated<g_pools> {
+  int a, b;
+};
+
+void TestBlockPool() {
+  BlockPool<12, 3> pool("block");
+  static_assert(pool.kBlockSize == 16);
+  void* blocks[3];
+  for (void*& block : blocks) {
+    block = pool.Allocate();
+    Expect(block != nullptr && pool.Owns(block), "allocate");
+  }
+  Expect(pool.Allocate() == nullptr, "exhausted");
+  pool.Free(blocks[1]);
+  Expect(pool.Allocate() == blocks[1], "reuse freed block");
+  for (void* block : blocks) pool.Free(block);
+
+  const PoolStats stats = pool.stats();
+  Expect(stats.in_use == 0, "all freed");
+  Expect(stats.high_water == 3, "high water");
+  Expect(stats.allocations == 4, "allocations");
+  Expect(stats.failures == 1, "failures");
+}
+
+void TestPoolSet() {
+  void* small = g_pools.New(10);
+  void* large = g_pools.New(40);
+  Expect(StatsOf("test/32").in_use == 1, "small class");
+  Expect(StatsOf("test/64").in_use == 1, "large class");
+
+  // A full class spills into the next larger one, then into the heap.
+  void* more[4];
+  for (void*& p : more) p = g_pools.New(32);
+  Expect(StatsOf("test/32").failures == 1, "small class exhausted");
+  Expect(StatsOf("test/64").in_use == 2, "spill into large class");
+  void* oversize = g_pools.New(100);
+  Expect(!g_pools.Owns(oversize), "oversize from heap");
+  Expect(g_pools.heap_fallbacks() == 1, "heap fallback counted");
+
+  for (void* p : more) g_pools.Delete(p);
+  g_pools.Delete(oversize);
+  g_pools.Delete(large);
+  g_pools.Delete(small);
+  Expect(StatsOf("test/32").in_use == 0 && StatsOf("test/64").in_use == 0, "set freed");
+}
+
+void TestPoolAllocated() {
+  const uint32_t allocations = StatsOf("test/32").allocations;
+  Small* small = new Small{{}, 1, 2};
+  Expect(g_pools.Owns(small), "operator new");
+  Expect(StatsOf("test/32").allocations == allocations + 1, "operator new counted");
+  delete small;
+  Expect(StatsOf("test/32").in_use == 0, "operator delete");
+}
+
+void TestPoolAllocator() {
+  std::list<int, PoolAllocator<int, Pools>> list{
+      PoolAllocator<int, Pools>(g_pools)};
+  for (int i = 0; i < 3; ++i) list.push_back(i);
+  Expect(StatsOf("test/32").in_use == 3, "list nodes pooled");
+  list.clear();
+  Expect(StatsOf("test/32").in_use == 0, "list nodes freed");
+}
+
+void TestArena() {
+  StaticArena<64> arena;
+  {
+    ArenaScope scope(arena);
+    Expect(arena.Allocate(1) != nullptr, "arena allocate");
+    void* aligned = arena.Allocate(8, 8);
+    Expect(reinterpret_cast<uintptr_t>(aligned) % 8 == 0, "arena alignment");
+    {
+      ArenaScope inner(arena);
+      std::vector<char, ArenaAllocator<char>> v{ArenaAllocator<char>(arena)};
+      v.reserve(32);
+      Expect(arena.used() >= 48, "vector in arena");
+    }
+    Expect(arena.used() == 16, "inner scope freed");
+    Expect(arena.Allocate(64) == nullptr, "arena full");
+  }
+  Expect(arena.used() == 0, "scope freed");
+  Expect(arena.high_water() >= 48, "arena high water");
+  Expect(arena.failures() == 1, "arena failures");
+}
+
+}  // namespace
+
+extern "C" void main_task(void*) {
+  TestBlockPool();
+  TestPoolSet();
+  TestPoolAllocated();
+  TestPoolAllocator();
+  TestArena();
+  freertosxx::PrintMemoryStats();
+  printf("PASS\n");
+  vTaskDelete(nullptr);
+}
@@ -0,0 +1,108 @@
+// Compares items/sec through Queue, one item per call, with RingQueue in
+// batches.
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+#include "FreeRTOS.h"
+#include "freertosxx/queue.h"
+#include "freertosxx/ring_queue.h"
+#include "pico/printf.h"
+#include "pico/time.h"
+#include "task.h"
+
+namespace {
+
+constexpr int kItems = 100'000;
+constexpr int kDepth = 64;
+constexpr int kBatch = 16;
+
+freertosxx::StaticQueue<uint32_t, kDepth> g_queue;
+freertosxx::RingQueue<uint32_t, kDepth> g_ring;
+
+// Keeps the optimizer from discarding the received items.
+volatile uint32_t g_sink;
+
+void Report(const char* name, uint64_t start_us) {
+  const uint64_t elapsed_us = time_us_64() - start_us;
+  printf(
+      "%-24s %8llu items/s\n",
+      name,
+      elapsed_us == 0 ? 0 : kItems * UINT64_C(1000000) / elapsed_us);
+}
+
+void QueueProducer(void*) {
+  for (uint32_t i = 0; i < kItems; ++i) g_queue.Send(i);
+  vTaskDelete(nullptr);
+}
+
+void RingProducer(void* arg) {
+  const int batch = reinterpret_cast<intptr_t>(arg);
+  std::array<uint32_t, kBatch> items;
+  for (uint32_t i = 0; i < kItems; i += batch) {
+    for (int j = 0; j < batch; ++j) items[j] = i + j;
+    g_ring.SendMany(std::span(items).first(batch));
+  }
+  vTaskDelete(nullptr);
+}
+
+void BenchmarkQueue() {
+  const uint64_t start = time_us_64();
+  xTaskCreate(QueueProducer, "producer", 512, nullptr, 1, nullptr);
+  uint32_t sum = 0;
+  for (int i = 0; i < kItems; ++i) sum += g_queue.Receive();
+  g_sink = sum;
+  Report("Queue::Receive", start);
+}
+
+void BenchmarkRing(const char* name, int send_batch) {
+  const uint64_t start = time_us_64();
+  xTaskCreate(
+      RingProducer,
+      "producer",
+      512,
+      reinterpret_cast<void*>(static_cast<intptr_t>(send_batch)),
+      1,
+      nullptr);
+  std::array<uint32_t, kBatch> items;
+  uint32_t sum = 0;
+  for (int received = 0; received < kItems;) {
+    const size_t n = g_ring.ReceiveMany(items);
+    for (size_t i = 0; i < n; ++i) sum += items[i];
+    received += n;
+  }
+  g_sink = sum;
+  Report(name, start);
+}
+
+void BenchmarkRingPeek() {
+  const uint64_t start = time_us_64();
+  xTaskCreate(
+      RingProducer,
+      "producer",
+      512,
+      reinterpret_cast<void*>(static_cast<intptr_t>(kBatch)),
+      1,
+      nullptr);
+  uint32_t sum = 0;
+  for (int received = 0; received < kItems;) {
+    std::span<const uint32_t> run = g_ring.Peek();
+    for (uint32_t item : run) sum += item;
+    g_ring.Consume(run.size());
+    received += run.size();
+  }
+  g_sink = sum;
+  Report("RingQueue::Peek", start);
+}
+
+}  // namespace
+
+extern "C" void main_task(void*) {
+  BenchmarkQueue();
+  BenchmarkRing("RingQueue, send 1", 1);
+  BenchmarkRing("RingQueue, send 16", kBatch);
+  BenchmarkRingPeek();
+  printf("DONE\n");
+  vTaskDelete(nullptr);
+}
@@ -0,0 +1,136 @@
+// Measures items/s handed from a task on core 1 to a task on core 0 through
+// the lock-free rings, with each wait strategy, next to RingQueue.
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+#include "FreeRTOS.h"
+#include "freertosxx/mpsc_ring.h"
+#include "freertosxx/ring_queue.h"
+#include "freertosxx/ring_wait.h"
+#include "freertosxx/spsc_ring.h"
+#include "pico/printf.h"
+#include "pico/time.h"
+#include "task.h"
+
+using namespace freertosxx;
+
+namespace {
+
+constexpr uint32_t kItems = 200'000;
+constexpr int kDepth = 64;
+constexpr int kBatch = 16;
+
+// Keeps the optimizer from discarding the received items.
+volatile uint32_t g_sink;
+
+struct Benchmark {
+  const char* name;
+  TaskFunction_t producer;
+  void (*consumer)();
+  int producers = 1;
+};
+
+// Producers only spin when the ring is full, and run on the other core.
+template <typename Ring, typename Waiter>
+void Produce(Ring& ring, Waiter& waiter, uint32_t count) {
+  for (uint32_t i = 0; i < count;) {
+    if (ring.TryPush(i)) {
+      ++i;
+      waiter.Notify();
+    }
+  }
+}
+
+template <typename Ring, typename Waiter>
+void Consume(Ring& ring, Waiter& waiter, uint32_t count) {
+  std::array<uint32_t, kBatch> items;
+  uint32_t sum = 0;
+  for (uint32_t received = 0; received < count;) {
+    const size_t n = WaitPopMany(ring, waiter, std::span(items));
+    for (size_t i = 0; i < n; ++i) sum += items[i];
+    received += n;
+  }
+  g_sink = sum;
+}
+
+SpscRing<uint32_t, kDepth> g_spsc;
+MpscRing<uint32_t, kDepth> g_mpsc;
+RingQueue<uint32_t, kDepth> g_ring_queue;
+TaskNotifyWaiter g_notify_waiter;
+EventWaiter g_event_waiter;
+
+void Run(const Benchmark& benchmark) {
+  g_notify_waiter.Attach();
+  const uint64_t start = time_us_64();
+  for (int i = 0; i < benchmark.producers; ++i) {
+    TaskHandle_t producer;
+    xTaskCreate(benchmark.producer, "producer", 512, nullptr, 1, &producer);
+#if configUSE_CORE_AFFINITY
+    vTaskCoreAffinitySet(producer, 1 << 1);
+#endif
+  }
+  benchmark.consumer();
+  const uint64_t elapsed_us = time_us_64() - start;
+  printf(
+      "%-28s %8llu items/s\n",
+      benchmark.name,
+      elapsed_us == 0 ? 0 : kItems * UINT64_C(1000000) / elapsed_us);
+}
+
+constexpr Benchmark kBenchmarks[] = {
+    {
+        "SpscRing, task notify",
+        [](void*) {
+          Produce(g_spsc, g_notify_waiter, kItems);
+          vTaskDelete(nullptr);
+        },
+        [] { Consume(g_spsc, g_notify_waiter, kItems); },
+    },
+    {
+        "SpscRing, sev/wfe",
+        [](void*) {
+          Produce(g_spsc, g_event_waiter, kItems);
+          vTaskDelete(nullptr);
+        },
+        [] { Consume(g_spsc, g_event_waiter, kItems); },
+    },
+    {
+        "MpscRing x2, task notify",
+        [](void*) {
+          Produce(g_mpsc, g_notify_waiter, kItems / 2);
+          vTaskDelete(nullptr);
+        },
+        [] { Consume(g_mpsc, g_notify_waiter, kItems); },
+        2,
+    },
+    {
+        "RingQueue",
+        [](void*) {
+          for (uint32_t i = 0; i < kItems; ++i) g_ring_queue.Send(i);
+          vTaskDelete(nullptr);
+        },
+        [] {
+          std::array<uint32_t, kBatch> items;
+          uint32_t sum = 0;
+          for (uint32_t received = 0; received < kItems;) {
+            const size_t n = g_ring_queue.ReceiveMany(items);
+            for (size_t i = 0; i < n; ++i) sum += items[i];
+            received += n;
+          }
+          g_sink = sum;
+        },
+    },
+};
+
+}  // namespace
+
+extern "C" void main_task(void*) {
+#if configUSE_CORE_AFFINITY
+  vTaskCoreAffinitySet(nullptr, 1 << 0);
+#endif
+  for (const Benchmark& benchmark : kBenchmarks) Run(benchmark);
+  printf("DONE\n");
+  vTaskDelete(nullptr);
+}
@@ -0,0 +1,84 @@
+#include "freertosxx/ring_queue.h"
+
+#include <array>
+#include <cstdint>
+#include <numeric>
+
+#include "FreeRTOS.h"
+#include "pico/platform.h"
+#include "pico/printf.h"
+#include "task.h"
+#include "util/expect.h"
+
+using freertosxx::RingQueue;
+using jagspico::Expect;
+
+namespace {
+
+constexpr int kItems = 10000;
+
+RingQueue<uint32_t, 8> g_small;
+RingQueue<uint32_t, 64> g_stream;
+
+// Sends 0..kItems-1 in batches of varying size.
+void Producer(void*) {
+  std::array<uint32_t, 13> batch;
+  uint32_t next = 0;
+  for (int size = 1; next < kItems; size = size % batch.size() + 1) {
+    const int n = std::min<int>(size, kItems - next);
+    for (int i = 0; i < n; ++i) batch[i] = next++;
+    g_stream.SendMany(std::span(batch).first(n));
+  }
+  vTaskDelete(nullptr);
+}
+
+}  // namespace
+
+extern "C" void main_task(void*) {
+  // Timeouts.
+  std::array<uint32_t, 8> out;
+  Expect(g_small.ReceiveMany(out, 1) == 0, "receive times out when empty");
+  Expect(g_small.Peek(0).empty(), "peek times out when empty");
+  std::array<uint32_t, 10> in;
+  std::iota(in.begin(), in.end(), 0);
+  Expect(g_small.SendMany(in, 1) == 8, "send stops when full");
+  Expect(g_small.free() == 0, "full");
+
+  // Peek in place, across the wrap.
+  std::span<const uint32_t> run = g_small.Peek();
+  Expect(run.size() == 8 && run[0] == 0 && run[7] == 7, "peek");
+  g_small.Consume(6);
+  Expect(g_small.SendMany(std::span(in).subspan(8)) == 2, "send after wrap");
+  run = g_small.Peek();
+  Expect(run.size() == 2 && run[0] == 6, "peek stops at the end of the ring");
+  g_small.Consume(2);
+  run = g_small.Peek();
+  Expect(run.size() == 2 && run[0] == 8 && run[1] == 9, "peek after wrap");
+  g_small.Consume(2);
+
+  // ReceiveMany copies across the wrap.
+  g_small.SendMany(std::span(in).first(7));
+  Expect(g_small.ReceiveMany(out) == 7 && out[6] == 6, "receive many");
+
+  // ISR variants never block.
+  bool woken;
+  Expect(g_small.SendManyFromISR(in, woken) == 8, "send from isr");
+  Expect(g_small.ReceiveManyFromISR(out, woken) == 8, "receive from isr");
+  Expect(out[0] == 0 && out[7] == 7, "receive from isr contents");
+
+  // A producer task streaming through a smaller ring.
+  xTaskCreate(Producer, "producer", 512, nullptr, 1, nullptr);
+  std::array<uint32_t, 16> received;
+  uint32_t want = 0;
+  while (want < kItems) {
+    const size_t n = g_stream.ReceiveMany(received);
+    Expect(n > 0, "receive blocks until items arrive");
+    for (size_t i = 0; i < n; ++i) {
+      if (received[i] != want++) panic("FAIL: sequence at %u", want - 1);
+    }
+  }
+  Expect(g_stream.size() == 0, "stream drained");
+
+  printf("PASS\n");
+  vTaskDelete(nullptr);
+}
@@ -0,0 +1,121 @@
+// Hammers SpscRing and MpscRing from host threads. Build with
+// PICO_PLATFORM=host; the build adds -fsanitize=thread, so data races in the
+// rings fail the test as well as lost, duplicated or reordered items.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "freertosxx/mpsc_ring.h"
+#include "freertosxx/spsc_ring.h"
+
+using freertosxx::MpscRing;
+using freertosxx::SpscRing;
+
+namespace {
+
+constexpr uint32_t kItems = 1'000'000;
+constexpr int kProducers = 4;
+
+void Fail(const char* what, uint32_t got, uint32_t want) {
+  printf("FAIL: %s: got %u want %u\n", what, got, want);
+  abort();
+}
+
+void StressSpsc() {
+  static SpscRing<uint32_t, 64> ring;
+  std::thread producer([] {
+    std::array<uint32_t, 7> batch;
+    uint32_t next = 0;
+    while (next < kItems) {
+      // Alternate single pushes and batches to cover both paths and the wrap.
+      if (next % 2 == 0) {
+        if (ring.TryPush(next)) {
+          ++next;
+        } else {
+          std::this_thread::yield();
+        }
+        continue;
+      }
+      const uint32_t n = std::min<uint32_t>(batch.size(), kItems - next);
+      for (uint32_t i = 0; i < n; ++i) batch[i] = next + i;
+      const size_t pushed = ring.TryPushMany(std::span(batch).first(n));
+      if (pushed == 0) std::this_thread::yield();
+      next += pushed;
+    }
+  });
+
+  uint32_t want = 0;
+  std::array<uint32_t, 5> out;
+  while (want < kItems) {
+    // Alternate in-place peeks and copies.
+    if (want % 3 == 0) {
+      std::span<const uint32_t> run = ring.Peek();
+      for (uint32_t item : run) {
+        if (item != want) Fail("spsc peek", item, want);
+        ++want;
+      }
+      ring.Consume(run.size());
+      if (run.empty()) std::this_thread::yield();
+      continue;
+    }
+    const size_t n = ring.TryPopMany(out);
+    if (n == 0) std::this_thread::yield();
+    for (size_t i = 0; i < n; ++i) {
+      if (out[i] != want) Fail("spsc pop", out[i], want);
+      ++want;
+    }
+  }
+  producer.join();
+  if (!ring.empty()) Fail("spsc empty", ring.size(), 0);
+}
+
+void StressMpsc() {
+  static MpscRing<uint32_t, 64> ring;
+  constexpr uint32_t kPerProducer = kItems / kProducers;
+  std::vector<std::thread> producers;
+  for (uint32_t p = 0; p < kProducers; ++p) {
+    producers.emplace_back([p] {
+      // The producer id lives in the top bits, a sequence in the rest.
+      for (uint32_t i = 0; i < kPerProducer;) {
+        if (ring.TryPush(p << 24 | i)) {
+          ++i;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  std::array<uint32_t, kProducers> next = {};
+  std::array<uint32_t, 8> out;
+  for (uint32_t received = 0; received < kPerProducer * kProducers;) {
+    const size_t n = ring.TryPopMany(out);
+    if (n == 0) std::this_thread::yield();
+    for (size_t i = 0; i < n; ++i) {
+      const uint32_t p = out[i] >> 24;
+      const uint32_t seq = out[i] & 0xffffff;
+      if (p >= kProducers) Fail("mpsc producer", p, 0);
+      // Each producer's items arrive in order.
+      if (seq != next[p]) Fail("mpsc sequence", seq, next[p]);
+      ++next[p];
+    }
+    received += n;
+  }
+  for (std::thread& t : producers) t.join();
+  if (!ring.empty()) Fail("mpsc empty", 1, 0);
+}
+
+}  // namespace
+
+int main() {
+  StressSpsc();
+  StressMpsc();
+  printf("PASS\n");
+}
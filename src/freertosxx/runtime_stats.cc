@@ -0,0 +1,243 @@
+#include "freertosxx/runtime_stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+
+#include "FreeRTOS.h"
+#include "freertosxx/critical_section.h"
+#include "hardware/uart.h"
+#include "pico/platform.h"
+#include "pico/time.h"
+#include "task.h"
+
+namespace freertosxx {
+
+namespace {
+
+// Switches of the task with each number. Index 0 counts the tasks that have
+// no number yet. Only the switch hook writes these, and the kernel
+// serializes it across cores.
+std::atomic<uint32_t> g_switches[CpuMonitor::kMaxTasks + 1];
+
+#if FREERTOSXX_TRACE_RECORDS > 0
+TraceRecord g_trace[FREERTOSXX_TRACE_RECORDS];
+// Records ever written. The next goes at g_trace_written % the ring's size.
+uint32_t g_trace_written = 0;
+std::atomic<bool> g_tracing = false;
+#endif
+
+}  // namespace
+
+}  // namespace freertosxx
+
+extern "C" uint64_t FreertosxxRunTimeCounter(void) { return time_us_64(); }
+
+extern "C" void FreertosxxTaskSwitchedIn(void) {
+#if configUSE_TRACE_FACILITY == 1
+  using freertosxx::CpuMonitor;
+  UBaseType_t id = uxTaskGetTaskNumber(xTaskGetCurrentTaskHandle());
+  if (id > CpuMonitor::kMaxTasks) id = 0;
+  std::atomic<uint32_t>& switches = freertosxx::g_switches[id];
+  switches.store(
+      switches.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+#if FREERTOSXX_TRACE_RECORDS > 0
+  if (freertosxx::g_tracing.load(std::memory_order_relaxed)) {
+    freertosxx::g_trace
+        [freertosxx::g_trace_written++ % FREERTOSXX_TRACE_RECORDS] = {
+            .time_us = time_us_32(),
+            .task = static_cast<uint16_t>(id),
+            .core = static_cast<uint8_t>(get_core_num()),
+            .reserved = 0,
+        };
+  }
+#endif
+#endif
+}
+
+namespace freertosxx {
+
+#if configUSE_TRACE_FACILITY == 1 && configGENERATE_RUN_TIME_STATS == 1
+
+bool CpuMonitor::Sample() {
+  // Too large for most stacks.
+  static TaskStatus_t statuses[kMaxTasks];
+  // The slot of each status, or -1 for a task new since the last sample.
+  int slot_of[kMaxTasks];
+  bool seen[kMaxTasks] = {};
+
+  // Keeps tasks from being deleted while we number them.
+  vTaskSuspendAll();
+  configRUN_TIME_COUNTER_TYPE now = 0;
+  const size_t count = uxTaskGetSystemState(statuses, kMaxTasks, &now);
+  if (count == 0) {
+    xTaskResumeAll();
+    return false;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    const auto it = std::ranges::find(
+        slots_, statuses[i].xTaskNumber, [](const Slot& s) { return s.task; });
+    slot_of[i] = it == std::end(slots_) ? -1 : it - slots_;
+    if (slot_of[i] >= 0) seen[slot_of[i]] = true;
+  }
+  // Frees the slots of deleted tasks.
+  for (size_t s = 0; s < kMaxTasks; ++s) {
+    if (!seen[s]) slots_[s].task = 0;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    if (slot_of[i] >= 0) continue;
+    const auto it = std::ranges::find(
+        slots_, UBaseType_t{0}, [](const Slot& s) { return s.task; });
+    // There are as many slots as statuses.
+    slot_of[i] = it - slots_;
+    // A new task has run since it was created, but its earlier switches
+    // were counted as those of a task without a number.
+    *it = Slot{
+        .task = statuses[i].xTaskNumber,
+        .run_time = 0,
+        .switches = g_switches[slot_of[i] + 1].load(std::memory_order_relaxed),
+    };
+    vTaskSetTaskNumber(statuses[i].xHandle, slot_of[i] + 1);
+  }
+  xTaskResumeAll();
+
+  const uint64_t elapsed = now - previous_time_;
+  previous_time_ = now;
+  // The run time of every task, on every core, adds up to this.
+  const float capacity =
+      static_cast<float>(elapsed) * configNUMBER_OF_CORES / 100;
+  const float seconds = static_cast<float>(elapsed) / 1e6f;
+
+  float idle_percent = 0;
+  float switches = 0;
+  for (size_t i = 0; i < count; ++i) {
+    const TaskStatus_t& status = statuses[i];
+    Slot& slot = slots_[slot_of[i]];
+    const uint32_t task_switches =
+        g_switches[slot_of[i] + 1].load(std::memory_order_relaxed);
+
+    TaskLoad& load = loads_[i];
+    snprintf(load.name, sizeof(load.name), "%s", status.pcTaskName);
+    load.id = slot_of[i] + 1;
+    load.cpu_percent =
+        capacity > 0 ? (status.ulRunTimeCounter - slot.run_time) / capacity
+                     : 0;
+    load.switches_per_second =
+        seconds > 0 ? (task_switches - slot.switches) / seconds : 0;
+    load.stack_high_water = status.usStackHighWaterMark;
+    load.idle = status.uxCurrentPriority == tskIDLE_PRIORITY &&
+                std::string_view(load.name).starts_with(configIDLE_TASK_NAME);
+
+    slot.run_time = status.ulRunTimeCounter;
+    slot.switches = task_switches;
+    if (load.idle) idle_percent += load.cpu_percent;
+    switches += load.switches_per_second;
+  }
+  count_ = count;
+  std::sort(loads_, loads_ + count_, [](const TaskLoad& a, const TaskLoad& b) {
+    return a.cpu_percent > b.cpu_percent;
+  });
+  cpu_percent_ = std::max(0.0f, 100 - idle_percent);
+  switches_per_second_ = switches;
+  return true;
+}
+
+#else
+
+bool CpuMonitor::Sample() { return false; }
+
+#endif
+
+const CpuMonitor::TaskLoad* CpuMonitor::Find(std::string_view name) const {
+  for (const TaskLoad& load : tasks()) {
+    if (name == load.name) return &load;
+  }
+  return nullptr;
+}
+
+void CpuMonitor::Print() const {
+  printf(
+      "cpu %.1f%%, %.0f switches/s\n",
+      static_cast<double>(cpu_percent_),
+      static_cast<double>(switches_per_second_));
+  for (const TaskLoad& load : tasks()) {
+    printf(
+        "  %-16s %5.1f%% %7.0f/s %6lu words free\n",
+        load.name,
+        static_cast<double>(load.cpu_percent),
+        static_cast<double>(load.switches_per_second),
+        static_cast<unsigned long>(load.stack_high_water));
+  }
+}
+
+void StartTrace() {
+#if FREERTOSXX_TRACE_RECORDS > 0
+  g_tracing = true;
+#endif
+}
+
+void StopTrace() {
+#if FREERTOSXX_TRACE_RECORDS > 0
+  g_tracing = false;
+#endif
+}
+
+bool DumpTrace(uart_inst_t* uart, const CpuMonitor& monitor) {
+#if FREERTOSXX_TRACE_RECORDS > 0
+  StopTrace();
+  uint32_t written;
+  {
+    // Waits out a switch hook that is recording on the other core.
+    CriticalSection critical_section;
+    written = g_trace_written;
+  }
+  const uint32_t count =
+      std::min<uint32_t>(written, FREERTOSXX_TRACE_RECORDS);
+
+  // Neither struct has padding.
+  struct Header {
+    char magic[4];
+    uint16_t version;
+    uint16_t task_count;
+    uint32_t record_count;
+    uint32_t dropped;
+  };
+  static_assert(sizeof(Header) == 16);
+  const Header header = {
+      .magic = {'F', 'T', 'R', 'C'},
+      .version = 1,
+      .task_count = static_cast<uint16_t>(monitor.tasks().size()),
+      .record_count = count,
+      .dropped = written - count,
+  };
+  uart_write_blocking(
+      uart, reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+
+  struct Task {
+    uint16_t id;
+    char name[14];
+  };
+  static_assert(sizeof(Task) == 16);
+  for (const CpuMonitor::TaskLoad& load : monitor.tasks()) {
+    Task task = {.id = static_cast<uint16_t>(load.id)};
+    strncpy(task.name, load.name, sizeof(task.name));
+    uart_write_blocking(
+        uart, reinterpret_cast<const uint8_t*>(&task), sizeof(task));
+  }
+
+  const uint32_t first = written - count;
+  for (uint32_t i = 0; i < count; ++i) {
+    const TraceRecord& record =
+        g_trace[(first + i) % FREERTOSXX_TRACE_RECORDS];
+    uart_write_blocking(
+        uart, reinterpret_cast<const uint8_t*>(&record), sizeof(record));
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+}  // namespace freertosxx
@@ -0,0 +1,63 @@
+#include "freertosxx/runtime_stats.h"
+
+#include <atomic>
+
+#include "FreeRTOS.h"
+#include "freertosxx/tasks.h"
+#include "pico/platform.h"
+#include "pico/printf.h"
+#include "task.h"
+#include "util/expect.h"
+
+using freertosxx::CpuMonitor;
+using jagspico::Expect;
+
+namespace {
+
+}  // namespace
+
+extern "C" void main_task(void*) {
+  CpuMonitor monitor;
+  Expect(monitor.Sample(), "run time stats enabled in the FreeRTOS config");
+
+  // One task keeps a core busy, and another switches in once a tick.
+  std::atomic<bool> stop = false;
+  freertosxx::Task spinner({.name = "spinner"}, 256, [&] {
+    while (!stop) {
+    }
+  });
+  freertosxx::Task ticker({.name = "ticker"}, 256, [&] {
+    while (!stop) vTaskDelay(1);
+  });
+  freertosxx::StartTrace();
+  vTaskDelay(pdMS_TO_TICKS(50));
+  Expect(monitor.Sample(), "sample");
+  vTaskDelay(pdMS_TO_TICKS(1000));
+  Expect(monitor.Sample(), "sample");
+  freertosxx::StopTrace();
+  stop = true;
+  spinner.Join();
+  ticker.Join();
+  monitor.Print();
+
+  // One core of two.
+  const CpuMonitor::TaskLoad* spinner_load = monitor.Find("spinner");
+  Expect(spinner_load != nullptr, "spinner sampled");
+  Expect(
+      spinner_load->cpu_percent > 45 && spinner_load->cpu_percent < 55,
+      "spinner uses one core");
+  Expect(monitor.cpu_percent() >= spinner_load->cpu_percent, "total load");
+
+  const CpuMonitor::TaskLoad* ticker_load = monitor.Find("ticker");
+  Expect(ticker_load != nullptr, "ticker sampled");
+  Expect(ticker_load->cpu_percent < 5, "ticker mostly blocked");
+  // Without the switch hook, no switches are counted.
+  if (monitor.switches_per_second() > 0) {
+    Expect(
+        ticker_load->switches_per_second > configTICK_RATE_HZ / 2,
+        "ticker switches once a tick");
+  }
+
+  printf("PASS\n");
+  vTaskDelete(nullptr);
+}
@@ -0,0 +1,25 @@
+#include "freertosxx/selector.h"
+
+#include "FreeRTOS.h"
+#include "queue.h"
+
+namespace freertosxx {
+
+Selector::Selector(int capacity) : set_(xQueueCreateSet(capacity)) {
+  configASSERT(set_ != nullptr);
+}
+
+Selector::~Selector() { vQueueDelete(set_); }
+
+void Selector::Add(QueueSetMemberHandle_t member) {
+  // Fails if the member is not empty or is already in a set.
+  auto result = xQueueAddToSet(member, set_);
+  configASSERT(result == pdPASS);
+}
+
+void Selector::Remove(QueueSetMemberHandle_t member) {
+  auto result = xQueueRemoveFromSet(member, set_);
+  configASSERT(result == pdPASS);
+}
+
+}  // namespace freertosxx
@@ -0,0 +1,97 @@
+#include "freertosxx/selector.h"
+
+#include <optional>
+
+#include "FreeRTOS.h"
+#include "freertosxx/queue.h"
+#include "freertosxx/tasks.h"
+#include "pico/platform.h"
+#include "pico/printf.h"
+#include "task.h"
+#include "util/expect.h"
+
+using freertosxx::Selector;
+using freertosxx::SelectorSignal;
+using freertosxx::StaticQueue;
+using jagspico::Expect;
+
+namespace {
+
+void TestTimeout() {
+  StaticQueue<int, 4> queue;
+  Selector selector(4);
+  selector.Add(queue);
+  Selector::Ready ready = selector.Select({.timeout = pdMS_TO_TICKS(10)});
+  Expect(!ready, "nothing ready");
+  Expect(!ready.Receive(queue), "no receive on timeout");
+  selector.Remove(queue);
+}
+
+void TestTyped() {
+  StaticQueue<int, 4> numbers;
+  StaticQueue<char, 4> letters;
+  SelectorSignal signal;
+  Selector selector(4 + 4 + 1);
+  selector.Add(numbers);
+  selector.Add(letters);
+  selector.Add(signal);
+
+  numbers.Send(7);
+  letters.Send('x');
+  signal.Give();
+  numbers.Send(8);
+
+  // Sources come back in the order they became ready.
+  Selector::Ready ready = selector.Select();
+  Expect(ready.Is(numbers), "numbers first");
+  Expect(!ready.Receive(letters), "letters not ready");
+  Expect(!ready.Take(signal), "signal not ready");
+  Expect(ready.Receive(numbers) == 7, "first number");
+
+  ready = selector.Select();
+  Expect(ready.Receive(letters) == 'x', "letter");
+  ready = selector.Select();
+  Expect(ready.Take(signal), "signal");
+  ready = selector.Select();
+  Expect(ready.Receive(numbers) == 8, "second number");
+  Expect(!selector.Select({.timeout = 0}), "drained");
+}
+
+void TestAcrossTasks() {
+  constexpr int kItems = 100;
+  StaticQueue<int, 4> queue;
+  SelectorSignal done;
+  Selector selector(4 + 1);
+  selector.Add(queue);
+  selector.Add(done);
+
+  freertosxx::Task producer({.name = "producer"}, 256, [&] {
+    for (int i = 0; i < kItems; ++i) queue.Send(i);
+    done.Give();
+  });
+
+  int expected = 0;
+  bool finished = false;
+  while (!finished) {
+    Selector::Ready ready = selector.Select({.timeout = pdMS_TO_TICKS(1000)});
+    Expect(static_cast<bool>(ready), "producer keeps up");
+    if (std::optional<int> item = ready.Receive(queue)) {
+      Expect(*item == expected++, "items in order");
+    } else {
+      Expect(ready.Take(done), "done");
+      finished = true;
+    }
+  }
+  Expect(expected == kItems, "every item");
+  producer.Join();
+}
+
+}  // namespace
+
+extern "C" void main_task(void*) {
+  TestTimeout();
+  TestTyped();
+  TestAcrossTasks();
+  printf("PASS\n");
+  vTaskDelete(nullptr);
+}
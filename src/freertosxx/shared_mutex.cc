@@ -0,0 +1,96 @@
+#include "freertosxx/shared_mutex.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+
+namespace freertosxx {
+
+SharedMutex::SharedMutex()
+    : writer_(xSemaphoreCreateMutexStatic(&writer_storage_)),
+      state_(xSemaphoreCreateMutexStatic(&state_storage_)),
+      drained_(xSemaphoreCreateBinaryStatic(&drained_storage_)) {}
+
+SharedMutex::~SharedMutex() {
+  configASSERT(readers() == 0);
+  configASSERT(xSemaphoreGetMutexHolder(writer_) == nullptr);
+  vSemaphoreDelete(drained_);
+  vSemaphoreDelete(state_);
+  vSemaphoreDelete(writer_);
+}
+
+int SharedMutex::readers() const {
+  return std::ranges::count_if(
+      readers_, [](const Reader& r) { return r.task != nullptr; });
+}
+
+bool SharedMutex::TryLockShared(TickType_t timeout) {
+  // Waits behind any writer, lending it our priority.
+  if (xSemaphoreTake(writer_, timeout) != pdTRUE) return false;
+  xSemaphoreTake(state_, portMAX_DELAY);
+  Reader* slot = std::ranges::find(readers_, nullptr, &Reader::task);
+  configASSERT(slot != std::end(readers_));
+  *slot = Reader{.task = xTaskGetCurrentTaskHandle()};
+  xSemaphoreGive(state_);
+  xSemaphoreGive(writer_);
+  return true;
+}
+
+void SharedMutex::UnlockShared() {
+  xSemaphoreTake(state_, portMAX_DELAY);
+  Reader* slot = std::ranges::find(
+      readers_, xTaskGetCurrentTaskHandle(), &Reader::task);
+  configASSERT(slot != std::end(readers_));
+  const std::optional<UBaseType_t> base_priority = slot->base_priority;
+  *slot = Reader{};
+  if (writer_waiting_ && readers() == 0) xSemaphoreGive(drained_);
+  if (base_priority) vTaskPrioritySet(nullptr, *base_priority);
+  xSemaphoreGive(state_);
+}
+
+bool SharedMutex::TryLock(TickType_t timeout) {
+  TimeOut_t timeout_state;
+  vTaskSetTimeOutState(&timeout_state);
+  // Keeps out other writers and, from now on, new readers.
+  if (xSemaphoreTake(writer_, timeout) != pdTRUE) return false;
+
+  xSemaphoreTake(state_, portMAX_DELAY);
+  const UBaseType_t priority = uxTaskPriorityGet(nullptr);
+  bool locked = true;
+  while (readers() > 0) {
+    // Raises the readers we wait for to our priority, so that tasks of
+    // intermediate priority cannot hold us up by preempting them. They keep
+    // it until they unlock, even if we time out.
+    for (Reader& reader : readers_) {
+      if (reader.task == nullptr ||
+          uxTaskPriorityGet(reader.task) >= priority) {
+        continue;
+      }
+      if (!reader.base_priority) {
+        reader.base_priority = uxTaskBasePriorityGet(reader.task);
+      }
+      vTaskPrioritySet(reader.task, priority);
+    }
+
+    writer_waiting_ = true;
+    xSemaphoreGive(state_);
+    // A give left over from an earlier wait only costs another loop.
+    const bool drained =
+        xTaskCheckForTimeOut(&timeout_state, &timeout) == pdFALSE &&
+        xSemaphoreTake(drained_, timeout) == pdTRUE;
+    xSemaphoreTake(state_, portMAX_DELAY);
+    writer_waiting_ = false;
+    if (!drained && readers() > 0) {
+      locked = false;
+      break;
+    }
+  }
+  xSemaphoreGive(state_);
+  if (!locked) xSemaphoreGive(writer_);
+  return locked;
+}
+
+}  // namespace freertosxx
@@ -0,0 +1,115 @@
+#include "freertosxx/shared_mutex.h"
+
+#include <atomic>
+#include <utility>
+
+#include "FreeRTOS.h"
+#include "freertosxx/snapshot.h"
+#include "freertosxx/tasks.h"
+#include "pico/platform.h"
+#include "pico/printf.h"
+#include "task.h"
+#include "util/expect.h"
+
+using freertosxx::OwnerSharedBorrowable;
+using freertosxx::Priority;
+using freertosxx::Snapshot;
+using freertosxx::Task;
+using jagspico::Expect;
+
+namespace {
+
+struct Config {
+  int a = 0;
+  int b = 0;
+};
+
+OwnerSharedBorrowable<Config> g_config(std::in_place);
+
+void TestSharedReaders() {
+  auto read = g_config.ReadBorrow();
+  std::atomic<bool> shared = false;
+  std::atomic<bool> excluded = false;
+  Task other({.name = "reader"}, 256, [&] {
+    shared = g_config.TryReadBorrow(0).has_value();
+    excluded = !g_config.TryBorrow(0).has_value();
+  });
+  other.Join();
+  Expect(shared, "readers share");
+  Expect(excluded, "readers exclude writers");
+}
+
+void TestWriterPreferred() {
+  const UBaseType_t base_priority = uxTaskPriorityGet(nullptr);
+  std::atomic<bool> writing = false;
+  auto read = g_config.ReadBorrow();
+  Task writer({.name = "writer", .priority = Priority::kHigh}, 256, [&] {
+    auto write = g_config.Borrow();
+    writing = true;
+    write->a = 1;
+    write->b = 2;
+  });
+  // Let the writer start waiting for us.
+  vTaskDelay(pdMS_TO_TICKS(10));
+  Expect(!writing, "writer waits for readers");
+  Expect(
+      uxTaskPriorityGet(nullptr) ==
+          static_cast<UBaseType_t>(Priority::kHigh),
+      "waiting writer raises readers");
+
+  std::atomic<bool> late_reader_waited = false;
+  Task late_reader({.name = "late_reader"}, 256, [&] {
+    late_reader_waited = !g_config.TryReadBorrow(5).has_value();
+  });
+  late_reader.Join();
+  Expect(late_reader_waited, "new readers wait behind a waiting writer");
+
+  read.Release();
+  Expect(uxTaskPriorityGet(nullptr) == base_priority, "priority restored");
+  writer.Join();
+  Expect(writing, "writer ran");
+  auto after = g_config.ReadBorrow();
+  Expect(after->a == 1 && after->b == 2, "write visible");
+}
+
+struct Reading {
+  uint32_t value;
+  uint32_t inverse;
+  uint16_t extra;
+};
+
+void TestSnapshot() {
+  constexpr uint32_t kStores = 100'000;
+  Snapshot<Reading> snapshot({.value = 0, .inverse = ~0u, .extra = 0});
+  const uint32_t initial_version = snapshot.version();
+  Task writer({.name = "snapshot"}, 256, [&] {
+    for (uint32_t i = 1; i <= kStores; ++i) {
+      snapshot.Store({
+          .value = i,
+          .inverse = ~i,
+          .extra = static_cast<uint16_t>(i),
+      });
+    }
+  });
+  uint32_t last = 0;
+  while (last < kStores) {
+    const Reading reading = snapshot.Load();
+    Expect(reading.inverse == ~reading.value, "consistent snapshot");
+    Expect(reading.extra == static_cast<uint16_t>(reading.value), "extra");
+    Expect(reading.value >= last, "snapshots only move forward");
+    last = reading.value;
+    taskYIELD();
+  }
+  writer.Join();
+  Expect(snapshot.version() == initial_version + kStores, "version counts");
+}
+
+}  // namespace
+
+extern "C" void main_task(void*) {
+  TestSharedReaders();
+  TestWriterPreferred();
+  TestSnapshot();
+  printf("PASS\n");
+  vTaskDelete(nullptr);
+}
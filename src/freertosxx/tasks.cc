@@ -0,0 +1,167 @@
+#include "freertosxx/tasks.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "FreeRTOS.h"
+#include "freertosxx/mutex.h"
+#include "task.h"
+
+namespace freertosxx {
+
+namespace {
+
+struct Registry {
+  Mutex mutex{"task_registry"};
+  Task* tasks = nullptr;
+};
+
+// Constructed on first use, since Tasks may be globals.
+Registry& GetRegistry() {
+  static Registry registry;
+  return registry;
+}
+
+}  // namespace
+
+Task::Task(
+    Options options, size_t stack_words, std::move_only_function<void()> fn,
+    StackType_t* stack, StaticTask_t* tcb)
+    : name_(options.name), stack_words_(stack_words), fn_(std::move(fn)) {
+  const UBaseType_t priority = static_cast<UBaseType_t>(options.priority);
+  // Held from before the task can start until it is registered, with its
+  // handle set, so that it can call DeleteSelf right away.
+  Registry& registry = GetRegistry();
+  MutexLock lock(registry.mutex);
+#if configUSE_CORE_AFFINITY && configNUMBER_OF_CORES > 1
+  // Creating the task with its affinity keeps it from starting on another
+  // core before it is pinned.
+  if (stack != nullptr) {
+    handle_ = xTaskCreateStaticAffinitySet(
+        &Task::Run, name_, stack_words, this, priority, stack, tcb,
+        options.cores);
+  } else {
+    xTaskCreateAffinitySet(
+        &Task::Run, name_, stack_words, this, priority, options.cores,
+        &handle_);
+  }
+#else
+  if (stack != nullptr) {
+    handle_ = xTaskCreateStatic(
+        &Task::Run, name_, stack_words, this, priority, stack, tcb);
+  } else {
+    xTaskCreate(&Task::Run, name_, stack_words, this, priority, &handle_);
+  }
+#endif
+  configASSERT(handle_ != nullptr);
+  next_task_ = registry.tasks;
+  registry.tasks = this;
+}
+
+Task::~Task() {
+  configASSERT(handle_ != xTaskGetCurrentTaskHandle());
+  bool deleted;
+  {
+    Registry& registry = GetRegistry();
+    MutexLock lock(registry.mutex);
+    for (Task** t = &registry.tasks; *t != nullptr; t = &(*t)->next_task_) {
+      if (*t == this) {
+        *t = next_task_;
+        break;
+      }
+    }
+    deleted = deleted_;
+  }
+  // The kernel may already have freed a task that deleted itself.
+  if (deleted) return;
+  // A joined task may still be on its way to suspending itself on the other
+  // core. Deleting it there would leave the kernel to finish with its TCB
+  // after we are gone.
+  while (eTaskGetState(handle_) == eRunning) vTaskDelay(1);
+  vTaskDelete(handle_);
+}
+
+void Task::Run(void* arg) {
+  Task& task = *static_cast<Task*>(arg);
+  task.fn_();
+
+  taskENTER_CRITICAL();
+  task.finished_ = true;
+  const bool joining = task.joining_;
+  taskEXIT_CRITICAL();
+  if (joining) task.joined_.Give();
+  vTaskSuspend(nullptr);
+}
+
+void Task::Join() {
+  configASSERT(handle_ != xTaskGetCurrentTaskHandle());
+  taskENTER_CRITICAL();
+  const bool finished = finished_;
+  if (!finished) {
+    joined_.Bind(xTaskGetCurrentTaskHandle());
+    joining_ = true;
+  }
+  taskEXIT_CRITICAL();
+  if (!finished) joined_.Wait();
+}
+
+void Task::DeleteSelf() {
+  const TaskHandle_t self = xTaskGetCurrentTaskHandle();
+  {
+    Registry& registry = GetRegistry();
+    MutexLock lock(registry.mutex);
+    Task* task = registry.tasks;
+    while (task != nullptr && task->handle_ != self) task = task->next_task_;
+    configASSERT(task != nullptr);
+    task->deleted_ = true;
+  }
+  vTaskDelete(nullptr);
+}
+
+void Task::VisitStacks(const std::function<void(const StackStats&)>& fn) {
+  Registry& registry = GetRegistry();
+  MutexLock lock(registry.mutex);
+  for (Task* task = registry.tasks; task != nullptr; task = task->next_task_) {
+    if (task->deleted_) continue;
+    // A StaticTask may also have deleted itself with vTaskDelete, like
+    // main_task. Its TCB is still there to ask.
+    if (eTaskGetState(task->handle_) == eDeleted) continue;
+    const size_t free_words = uxTaskGetStackHighWaterMark(task->handle_);
+    const bool new_low = free_words < task->min_free_words_;
+    task->min_free_words_ = std::min(task->min_free_words_, free_words);
+    fn(StackStats{
+        .name = task->name_,
+        .stack_words = task->stack_words_,
+        .min_free_words = task->min_free_words_,
+        .new_low = new_low,
+    });
+  }
+}
+
+bool SetCoreAffinity(const char* task_name, UBaseType_t cores) {
+  TaskHandle_t task = xTaskGetHandle(task_name);
+  if (task == nullptr) return false;
+#if configUSE_CORE_AFFINITY && configNUMBER_OF_CORES > 1
+  vTaskCoreAffinitySet(task, cores);
+#endif
+  return true;
+}
+
+void StartStackMonitor(TickType_t period) {
+  static StaticTask<512> monitor(
+      {.name = "stack_monitor", .priority = Priority::kIdle}, [period] {
+        while (true) {
+          Task::VisitStacks([](const Task::StackStats& stats) {
+            if (!stats.new_low) return;
+            printf(
+                "stack %s: %u of %u words never used\n",
+                stats.name,
+                stats.min_free_words,
+                stats.stack_words);
+          });
+          vTaskDelay(period);
+        }
+      });
+}
+
+}  // namespace freertosxx
@@ -0,0 +1,106 @@
+#include "freertosxx/tasks.h"
+
+#include <atomic>
+#include <string_view>
+
+#include "FreeRTOS.h"
+#include "pico/platform.h"
+#include "pico/printf.h"
+#include "task.h"
+#include "util/expect.h"
+
+using freertosxx::Priority;
+using freertosxx::StaticTask;
+using freertosxx::Task;
+using jagspico::Expect;
+
+namespace {
+
+Task::StackStats StatsOf(std::string_view name) {
+  Task::StackStats result{};
+  Task::VisitStacks([&](const Task::StackStats& stats) {
+    if (stats.name == name) result = stats;
+  });
+  return result;
+}
+
+void TestJoin() {
+  std::atomic<int> runs = 0;
+  StaticTask<256> task(
+      {.name = "join", .priority = Priority::kHigh, .cores = freertosxx::kCore1},
+      [&] {
+        vTaskDelay(pdMS_TO_TICKS(5));
+        ++runs;
+      });
+  task.Join();
+  Expect(runs == 1, "joined after the function returned");
+}
+
+void TestJoinFinished() {
+  std::atomic<bool> ran = false;
+  Task task({.name = "finished"}, 256, [&] { ran = true; });
+  while (!ran) vTaskDelay(1);
+  vTaskDelay(pdMS_TO_TICKS(5));
+  task.Join();
+}
+
+void TestStacks() {
+  freertosxx::BinarySignal started;
+  freertosxx::BinarySignal stop{nullptr};
+  StaticTask<256> task({.name = "stacks"}, [&] {
+    started.Give();
+    stop.Wait();
+  });
+  stop.Bind(task.handle());
+  started.Wait();
+
+  const Task::StackStats first = StatsOf("stacks");
+  Expect(first.stack_words == 256, "stack size");
+  Expect(first.min_free_words > 0, "free stack");
+  Expect(first.min_free_words <= 256, "free stack fits");
+  Expect(first.new_low, "first visit is a new low");
+  const Task::StackStats second = StatsOf("stacks");
+  Expect(second.min_free_words <= first.min_free_words, "minimum only falls");
+
+  stop.Give();
+  task.Join();
+}
+
+void TestDeleteSelf() {
+  std::atomic<bool> deleting = false;
+  Task task({.name = "delete_self"}, 256, [&] {
+    deleting = true;
+    Task::DeleteSelf();
+  });
+  while (!deleting) vTaskDelay(1);
+  // Lets the idle task free the deleted task's TCB and stack, which
+  // VisitStacks and ~Task must not touch from then on.
+  vTaskDelay(pdMS_TO_TICKS(10));
+  Expect(StatsOf("delete_self").name == nullptr, "deleted task not visited");
+
+  // A task that preempts its creator, or starts on the other core, may
+  // delete itself before its constructor has returned.
+  Task eager(
+      {
+          .name = "eager_delete",
+          .priority = Priority::kHighest,
+          .cores = configNUMBER_OF_CORES > 1
+                       ? freertosxx::kCore0 << (1 - get_core_num())
+                       : freertosxx::kAnyCore,
+      },
+      256, [] { Task::DeleteSelf(); });
+  vTaskDelay(pdMS_TO_TICKS(10));
+  Expect(StatsOf("eager_delete").name == nullptr, "eager task not visited");
+}
+
+}  // namespace
+
+extern "C" void main_task(void*) {
+  TestJoin();
+  TestJoinFinished();
+  TestStacks();
+  TestDeleteSelf();
+  Expect(StatsOf("stacks").name == nullptr, "destroyed tasks unregistered");
+  printf("PASS\n");
+  Task::DeleteSelf();
+}
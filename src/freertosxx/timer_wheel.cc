@@ -0,0 +1,248 @@
+#include "freertosxx/timer_wheel.h"
+
+#include <algorithm>
+#include <bit>
+#include <iterator>
+#include <utility>
+
+#include "FreeRTOS.h"
+#include "freertosxx/critical_section.h"
+#include "task.h"
+
+namespace freertosxx {
+
+namespace {
+
+constexpr int32_t Signed(TickType_t ticks) {
+  return static_cast<int32_t>(ticks);
+}
+
+}  // namespace
+
+void TimerWheel::Init(std::span<Node> nodes) {
+  nodes_ = nodes;
+  now_ = xTaskGetTickCount();
+  for (Node& node : nodes) {
+    node.next = free_;
+    free_ = &node;
+  }
+}
+
+TimerToken TimerWheel::Schedule(
+    TickType_t delay, Callback fn, TimerContext context) {
+  CriticalSection critical_section;
+  Node* node = free_;
+  if (node == nullptr) {
+    ++failures_;
+    return TimerToken();
+  }
+  free_ = node->next;
+  const TickType_t tick = xTaskGetTickCount();
+  // An idle wheel's now_ stopped when it went to sleep. Catch it up here,
+  // because once this timer is pending Run would step through every tick
+  // in between, and a 2^31 tick gap would make the timer look overdue.
+  if (pending_ == 0) now_ = tick;
+  node->expiry = tick + delay;
+  node->state = Node::kPending;
+  node->context = context;
+  node->fn = std::move(fn);
+  Insert(node);
+  high_water_ = std::max(high_water_, ++pending_);
+  // Wake the task if it would sleep through this timer.
+  if (sleeping_ && (pending_ == 1 || Signed(node->expiry - wake_at_) < 0)) {
+    sleeping_ = false;
+    wake_.Give();
+  }
+  return TimerToken(this, node, node->generation);
+}
+
+bool TimerWheel::Cancel(Node* node, uint32_t generation) {
+  {
+    CriticalSection critical_section;
+    if (node->generation != generation || node->state != Node::kPending) {
+      return false;
+    }
+    Unlink(node);
+    // Keeps the node from being cancelled twice while we destroy its
+    // callback, which may do anything.
+    node->state = Node::kRunning;
+  }
+  node->fn = nullptr;
+  CriticalSection critical_section;
+  Free(node);
+  ++cancelled_;
+  return true;
+}
+
+TimerWheel::Stats TimerWheel::stats() const {
+  CriticalSection critical_section;
+  return Stats{
+      .capacity = nodes_.size(),
+      .pending = pending_,
+      .high_water = high_water_,
+      .fired = fired_,
+      .cancelled = cancelled_,
+      .failures = failures_,
+      .advances = advances_,
+  };
+}
+
+void TimerWheel::Insert(Node* node) {
+  TickType_t delta = Signed(node->expiry - now_) > 0 ? node->expiry - now_ : 0;
+  // Timers beyond the top level wait in its last slot and go round again.
+  constexpr TickType_t kMaxDelta = (TickType_t{1} << (kSlotBits * kLevels)) - 1;
+  delta = std::min(delta, kMaxDelta);
+  const TickType_t at = now_ + delta;
+  int level = 0;
+  while (delta >= TickType_t{1} << (kSlotBits * (level + 1))) ++level;
+  const uint32_t slot = (at >> (kSlotBits * level)) & (kSlots - 1);
+
+  node->level = level;
+  node->slot = slot;
+  Node*& head = slots_[level][slot];
+  node->prev = nullptr;
+  node->next = head;
+  if (head != nullptr) head->prev = node;
+  head = node;
+  occupied_[level] |= uint64_t{1} << slot;
+}
+
+void TimerWheel::Unlink(Node* node) {
+  if (node->next != nullptr) node->next->prev = node->prev;
+  if (node->prev != nullptr) {
+    node->prev->next = node->next;
+  } else {
+    slots_[node->level][node->slot] = node->next;
+    if (node->next == nullptr) {
+      occupied_[node->level] &= ~(uint64_t{1} << node->slot);
+    }
+  }
+}
+
+void TimerWheel::Free(Node* node) {
+  node->state = Node::kFree;
+  ++node->generation;
+  node->next = free_;
+  free_ = node;
+  --pending_;
+}
+
+void TimerWheel::Advance(Node*& ready) {
+  // Cascades every level that wraps at this tick, from the top down, so that
+  // timers can fall through several levels at once.
+  int wrapped = 0;
+  while (wrapped + 1 < kLevels &&
+         (now_ & ((TickType_t{1} << (kSlotBits * (wrapped + 1))) - 1)) == 0) {
+    ++wrapped;
+  }
+  for (int level = wrapped; level > 0; --level) {
+    const uint32_t slot = (now_ >> (kSlotBits * level)) & (kSlots - 1);
+    Node* node = std::exchange(slots_[level][slot], nullptr);
+    occupied_[level] &= ~(uint64_t{1} << slot);
+    while (node != nullptr) Insert(std::exchange(node, node->next));
+  }
+
+  const uint32_t slot = now_ & (kSlots - 1);
+  Node* node = std::exchange(slots_[0][slot], nullptr);
+  occupied_[0] &= ~(uint64_t{1} << slot);
+  while (node != nullptr) {
+    Node* expired = std::exchange(node, node->next);
+    if (Signed(expired->expiry - now_) > 0) {
+      // A timer beyond the top level, going round again.
+      Insert(expired);
+      continue;
+    }
+    expired->state = Node::kRunning;
+    expired->next = ready;
+    ready = expired;
+  }
+  ++now_;
+  ++advances_;
+}
+
+TickType_t TimerWheel::Idle() const {
+  if (pending_ == 0) return portMAX_DELAY;
+  const int offset = now_ & (kSlots - 1);
+  TickType_t idle = kSlots;
+  if (occupied_[0] != 0) {
+    idle = std::countr_zero(std::rotr(occupied_[0], offset));
+  }
+  if (std::any_of(
+          std::begin(occupied_) + 1, std::end(occupied_), [](uint64_t o) {
+            return o != 0;
+          })) {
+    // Until level 0 wraps and the level above cascades.
+    idle = std::min<TickType_t>(idle, (kSlots - offset) & (kSlots - 1));
+  }
+  return idle;
+}
+
+void TimerWheel::Run() {
+  for (;;) {
+    Node* ready = nullptr;
+    TickType_t timeout = 0;
+    {
+      CriticalSection critical_section;
+      if (stopping_) break;
+      const TickType_t tick = xTaskGetTickCount();
+      // With nothing pending there is nothing to catch up on.
+      if (pending_ == 0) now_ = tick + 1;
+      if (Signed(tick - now_) >= 0) {
+        Advance(ready);
+      } else {
+        const TickType_t idle = Idle();
+        timeout = idle == portMAX_DELAY ? portMAX_DELAY : now_ + idle - tick;
+        wake_at_ = tick + timeout;
+        sleeping_ = true;
+      }
+    }
+
+    if (ready == nullptr) {
+      wake_.Wait({.timeout = timeout});
+      CriticalSection critical_section;
+      sleeping_ = false;
+      continue;
+    }
+
+    while (ready != nullptr) {
+      Node* node = std::exchange(ready, ready->next);
+      if (node->context != nullptr) {
+        node->context(node->fn);
+      } else {
+        node->fn();
+      }
+      node->fn = nullptr;
+      CriticalSection critical_section;
+      Free(node);
+      ++fired_;
+    }
+  }
+
+  for (Node& node : nodes_) {
+    {
+      CriticalSection critical_section;
+      if (node.state != Node::kPending) continue;
+      Unlink(&node);
+    }
+    node.fn = nullptr;
+    CriticalSection critical_section;
+    Free(&node);
+  }
+}
+
+void TimerWheel::Stop() {
+  CriticalSection critical_section;
+  stopping_ = true;
+  sleeping_ = false;
+  wake_.Give();
+}
+
+TimerWheel& DefaultTimerWheel() {
+  // Callbacks like MqttClient's reconnects call into lwIP, so the stack
+  // matches a typical timer service task's.
+  static StaticTimerWheel<32, 1024> wheel(
+      {.name = "timer_wheel", .priority = Priority::kHigh});
+  return wheel;
+}
+
+}  // namespace freertosxx
@@ -0,0 +1,163 @@
+#include "freertosxx/timer_wheel.h"
+
+#include <atomic>
+#include <iterator>
+
+#include "FreeRTOS.h"
+#include "freertosxx/notify.h"
+#include "freertosxx/tasks.h"
+#include "pico/platform.h"
+#include "pico/printf.h"
+#include "task.h"
+#include "util/expect.h"
+
+using freertosxx::CountingSignal;
+using freertosxx::StaticTimerWheel;
+using freertosxx::TimerToken;
+using freertosxx::TimerWheel;
+using jagspico::Expect;
+
+namespace {
+
+// How late a timer may fire, to allow for the scheduler.
+constexpr TickType_t kSlack = pdMS_TO_TICKS(5);
+
+void TestOrder(TimerWheel& wheel) {
+  // Covers level 0, level 1 and the cascade between them.
+  constexpr TickType_t kDelays[] = {50, 10, 130, 70, 0, 64};
+  constexpr int kCount = std::size(kDelays);
+  CountingSignal fired;
+  std::atomic<int> next = 0;
+  int order[kCount];
+  TickType_t late[kCount];
+  const TickType_t start = xTaskGetTickCount();
+  for (int i = 0; i < kCount; ++i) {
+    Expect(static_cast<bool>(wheel.Schedule(kDelays[i], [&, i] {
+             late[i] = xTaskGetTickCount() - start - kDelays[i];
+             order[next++] = i;
+             fired.Give();
+           })),
+           "scheduled");
+  }
+  for (int i = 0; i < kCount; ++i) {
+    Expect(fired.Wait({.timeout = pdMS_TO_TICKS(1000)}) == 1, "fired");
+  }
+  for (int i = 1; i < kCount; ++i) {
+    Expect(kDelays[order[i - 1]] <= kDelays[order[i]], "in order of expiry");
+  }
+  for (int i = 0; i < kCount; ++i) {
+    Expect(static_cast<int32_t>(late[i]) >= 0, "not early");
+    Expect(late[i] <= kSlack, "not late");
+  }
+}
+
+void TestCancel(TimerWheel& wheel) {
+  CountingSignal fired;
+  std::atomic<bool> cancelled_ran = false;
+  TimerToken cancelled =
+      wheel.Schedule(20, [&] { cancelled_ran = true; });
+  TimerToken kept = wheel.Schedule(30, [&] { fired.Give(); });
+  Expect(cancelled.Cancel(), "cancelled");
+  Expect(!cancelled.Cancel(), "cancelled once");
+  Expect(fired.Wait({.timeout = pdMS_TO_TICKS(1000)}) == 1, "kept fired");
+  Expect(!cancelled_ran, "cancelled timer did not run");
+  Expect(!kept.Cancel(), "fired timers cannot be cancelled");
+  Expect(!TimerToken().Cancel(), "empty token");
+
+  // A stale token must not cancel the timer that reuses its node.
+  TimerToken reused = wheel.Schedule(10, [&] { fired.Give(); });
+  Expect(!kept.Cancel() && !cancelled.Cancel(), "stale tokens");
+  Expect(fired.Wait({.timeout = pdMS_TO_TICKS(1000)}) == 1, "reused fired");
+  Expect(!reused.Cancel(), "reused fired");
+}
+
+void TestLongDelay(TimerWheel& wheel) {
+  // Level 2, which cascades twice.
+  constexpr TickType_t kDelay = pdMS_TO_TICKS(4500);
+  CountingSignal fired;
+  TickType_t fired_at = 0;
+  const TickType_t start = xTaskGetTickCount();
+  wheel.Schedule(kDelay, [&] {
+    fired_at = xTaskGetTickCount();
+    fired.Give();
+  });
+  Expect(fired.Wait({.timeout = kDelay * 2}) == 1, "long timer fired");
+  Expect(fired_at - start >= kDelay, "long timer not early");
+  Expect(fired_at - start <= kDelay + kSlack, "long timer not late");
+}
+
+std::atomic<bool> g_in_context = false;
+
+void TestContext(TimerWheel& wheel) {
+  CountingSignal fired;
+  std::atomic<bool> ran_in_context = false;
+  wheel.Schedule(
+      1,
+      [&] {
+        ran_in_context = g_in_context.load();
+        fired.Give();
+      },
+      +[](std::move_only_function<void()>& fn) {
+        g_in_context = true;
+        fn();
+        g_in_context = false;
+      });
+  Expect(fired.Wait({.timeout = pdMS_TO_TICKS(1000)}) == 1, "fired");
+  Expect(ran_in_context, "ran in context");
+}
+
+// A wheel that idled for a long time must pick up at the current tick when
+// a timer is next scheduled, not step through every tick it slept through.
+void TestAfterIdle() {
+  constexpr TickType_t kIdle = pdMS_TO_TICKS(3000);
+  constexpr TickType_t kDelay = 10;
+  StaticTimerWheel<2> wheel({.name = "idle_wheel"});
+  vTaskDelay(kIdle);
+  CountingSignal fired;
+  TickType_t fired_at = 0;
+  const uint32_t advances = wheel.stats().advances;
+  const TickType_t start = xTaskGetTickCount();
+  wheel.Schedule(kDelay, [&] {
+    fired_at = xTaskGetTickCount();
+    fired.Give();
+  });
+  Expect(fired.Wait({.timeout = pdMS_TO_TICKS(1000)}) == 1, "fired");
+  Expect(fired_at - start >= kDelay, "not early after idle");
+  Expect(fired_at - start <= kDelay + kSlack, "not late after idle");
+  Expect(wheel.stats().advances - advances <= kDelay + kSlack + 1,
+         "no catching up after idle");
+}
+
+void TestExhaustion() {
+  StaticTimerWheel<2> wheel({.name = "small_wheel"});
+  TimerToken a = wheel.Schedule(1000, [] {});
+  TimerToken b = wheel.Schedule(1000, [] {});
+  Expect(a && b, "scheduled");
+  Expect(!wheel.Schedule(1000, [] {}), "out of nodes");
+  Expect(wheel.stats().failures == 1, "failure counted");
+  Expect(a.Cancel(), "cancel frees a node");
+  Expect(static_cast<bool>(wheel.Schedule(1000, [] {})), "node reused");
+  Expect(wheel.stats().high_water == 2, "high water");
+  // Destroying the wheel discards b and the last timer.
+}
+
+}  // namespace
+
+extern "C" void main_task(void*) {
+  StaticTimerWheel<8> wheel({.name = "test_wheel"});
+  TestOrder(wheel);
+  TestCancel(wheel);
+  TestLongDelay(wheel);
+  TestContext(wheel);
+  TestAfterIdle();
+  TestExhaustion();
+  const TimerWheel::Stats stats = wheel.stats();
+  Expect(stats.pending == 0, "nothing pending");
+  printf(
+      "%u fired, %u cancelled, %u max pending\n",
+      stats.fired,
+      stats.cancelled,
+      stats.high_water);
+  printf("PASS\n");
+  vTaskDelete(nullptr);
+}
@@ -0,0 +1,77 @@
+#include "homeassistant/cpu_sensors.h"
+
+#include <cstdio>
+
+#include "homeassistant/sensor_publisher.h"
+#include "util/ssprintf.h"
+
+namespace homeassistant {
+
+namespace {
+
+Entity& AddCpuSensor(
+    Device& device, std::string_view id, std::string_view name) {
+  CommonDeviceInfo info(id);
+  info.name = name;
+  info.component = "sensor";
+  // Like SensorPublisher's payloads, the state is a JSON object with the
+  // load in "value".
+  return device.AddEntity(
+      info, [](const CommonDeviceInfo& info, JsonBuilder& b) {
+        AddAggregatedSensorInfo(info, "%", b);
+      });
+}
+
+}  // namespace
+
+CpuSensors::CpuSensors(
+    Device& device, std::string_view id_prefix,
+    std::span<const std::string_view> tasks)
+    : device_(device),
+      total_(&AddCpuSensor(
+          device,
+          jagspico::ssprintf(
+              "%.*s_cpu", (int)id_prefix.size(), id_prefix.data()),
+          "CPU")) {
+  for (std::string_view task : tasks) {
+    Entity& entity = AddCpuSensor(
+        device,
+        jagspico::ssprintf(
+            "%.*s_cpu_%.*s",
+            (int)id_prefix.size(),
+            id_prefix.data(),
+            (int)task.size(),
+            task.data()),
+        jagspico::ssprintf("CPU %.*s", (int)task.size(), task.data()));
+    tasks_.push_back({std::string(task), &entity});
+  }
+}
+
+err_t CpuSensors::Publish(
+    lwipxx::MqttClient& client, const freertosxx::CpuMonitor& monitor) {
+  char payload[96];
+  snprintf(
+      payload,
+      sizeof(payload),
+      "{\"value\":%.1f,\"switches\":%.0f}",
+      static_cast<double>(monitor.cpu_percent()),
+      static_cast<double>(monitor.switches_per_second()));
+  err_t result = device_.PublishState(client, *total_, payload);
+
+  for (const Watched& watched : tasks_) {
+    const freertosxx::CpuMonitor::TaskLoad* load = monitor.Find(watched.task);
+    if (load == nullptr) continue;
+    snprintf(
+        payload,
+        sizeof(payload),
+        "{\"value\":%.1f,\"switches\":%.0f,\"stack\":%lu}",
+        static_cast<double>(load->cpu_percent),
+        static_cast<double>(load->switches_per_second),
+        static_cast<unsigned long>(load->stack_high_water));
+    const err_t err = device_.PublishState(client, *watched.entity, payload);
+    if (result == ERR_OK) result = err;
+  }
+  return result;
+}
+
+}  // namespace homeassistant
@@ -0,0 +1,253 @@
+#include "homeassistant/device.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string_view>
+
+#include "lwip/tcpip.h"
+#include "pico/unique_id.h"
+#include "util/cleanup.h"
+
+namespace homeassistant {
+
+// Timer commands issued from the timer task itself must not block, as the
+// timer task is the one that drains the command queue.
+static TickType_t TimerCommandTimeout() {
+  return xTaskGetCurrentTaskHandle() == xTimerGetTimerDaemonTaskHandle()
+             ? 0
+             : portMAX_DELAY;
+}
+
+void AddDeviceInfo(const DeviceInfo& info, JsonBuilder& builder) {
+  auto dict_closer = builder.EnterDict("device");
+  builder.Kv(
+      "identifiers",
+      info.identifier.empty() ? BoardIdentifier() : info.identifier);
+  builder.KvIf("name", info.name);
+  builder.KvIf("manufacturer", info.manufacturer);
+  builder.KvIf("model", info.model);
+  builder.KvIf("sw_version", info.sw_version);
+}
+
+Device::Device(DeviceInfo info)
+    : info_(info),
+      timer_(xTimerCreate(
+          "ha_discovery", pdMS_TO_TICKS(25), pdTRUE, this,
+          +[](TimerHandle_t timer) {
+            static_cast<Device*>(pvTimerGetTimerID(timer))->Pump();
+          })) {
+  configASSERT(timer_ != nullptr);
+}
+
+Device::~Device() {
+  xTimerDelete(timer_, portMAX_DELAY);
+  if (birth_timer_ != nullptr) xTimerDelete(birth_timer_, portMAX_DELAY);
+}
+
+Entity& Device::AddEntity(
+    const CommonDeviceInfo& info, const DiscoveryFiller& fill) {
+  configASSERT(info.component.has_value());
+  auto entity = std::unique_ptr<Entity>(new Entity(info));
+
+  JsonBuilder builder;
+  AddCommonInfo(info, entity->topics().root(), builder);
+  if (fill) fill(info, builder);
+  AddAvailabilityDiscovery(builder);
+  AddDeviceInfo(info_, builder);
+  entity->discovery_message_ = std::move(builder).Finish();
+
+  entities_.push_back(std::move(entity));
+  return *entities_.back();
+}
+
+void Device::PublishDiscovery(
+    lwipxx::MqttClient& client, DiscoveryOptions options) {
+  configASSERT(options.max_in_flight > 0);
+  events_.Clear(kDiscoveryDone);
+  LOCK_TCPIP_CORE();
+  client_ = &client;
+  options_ = std::move(options);
+  pending_.clear();
+  for (auto& entity : entities_) {
+    pending_.push_back({Item::kDiscovery, entity.get()});
+  }
+  if (options_.with_state) {
+    pending_.push_back({Item::kAvailability, nullptr});
+    for (auto& entity : entities_) {
+      if (entity->last_state_) pending_.push_back({Item::kState, entity.get()});
+    }
+  }
+  // Reverse so that items are published in the order above when popping from
+  // the back.
+  std::reverse(pending_.begin(), pending_.end());
+  progress_ = DiscoveryProgress{.total = static_cast<int>(pending_.size())};
+  in_flight_.clear();
+  in_flight_.reserve(options_.max_in_flight);
+  consecutive_failures_ = 0;
+  const TickType_t interval = std::max<TickType_t>(options_.interval, 1);
+  UNLOCK_TCPIP_CORE();
+
+  xTimerChangePeriod(timer_, interval, TimerCommandTimeout());
+  xTimerReset(timer_, TimerCommandTimeout());
+}
+
+bool Device::WaitForDiscovery(std::optional<TickType_t> timeout) {
+  return events_.Wait(kDiscoveryDone, {.timeout = timeout}) & kDiscoveryDone;
+}
+
+void Device::Pump() {
+  LOCK_TCPIP_CORE();
+  auto cleanup = jagspico::Cleanup([&] { UNLOCK_TCPIP_CORE(); });
+  ExpireInFlight();
+  if (pending_.empty() ||
+      static_cast<int>(in_flight_.size()) >= options_.max_in_flight) {
+    MaybeFinishBatch();
+    return;
+  }
+
+  const Item item = pending_.back();
+  std::string_view topic;
+  std::string_view payload;
+  switch (item.kind) {
+    case Item::kDiscovery:
+      topic = item.entity->discovery_topic();
+      payload = item.entity->discovery_message();
+      break;
+    case Item::kAvailability:
+      topic = AvailabilityTopic();
+      payload = availability_payloads::kOnline;
+      break;
+    case Item::kState:
+      topic = item.entity->state_topic();
+      payload = *item.entity->last_state_;
+      break;
+  }
+  const uint32_t id = next_publish_id_++;
+  const err_t err = client_->Publish(
+      topic,
+      payload,
+      lwipxx::MqttClient::kAtLeastOnce,
+      true,
+      [this, id](err_t err) { FinishPublish(id, err); });
+  if (err != ERR_OK) {
+    // Most likely the client's output buffer is full or we are not connected.
+    // Leave the message queued and slow down until the client recovers.
+    ++progress_.retries;
+    ++consecutive_failures_;
+    const TickType_t backoff = std::min<TickType_t>(
+        std::max<TickType_t>(options_.interval, 1)
+            << std::min(consecutive_failures_, 8),
+        kMaxRetryInterval);
+    xTimerChangePeriod(timer_, backoff, 0);
+    return;
+  }
+
+  pending_.pop_back();
+  in_flight_.push_back({.id = id, .item = item, .sent = xTaskGetTickCount()});
+  if (consecutive_failures_ > 0) {
+    consecutive_failures_ = 0;
+    xTimerChangePeriod(timer_, std::max<TickType_t>(options_.interval, 1), 0);
+  }
+}
+
+void Device::FinishPublish(uint32_t id, err_t err) {
+  LOCK_TCPIP_CORE();
+  auto cleanup = jagspico::Cleanup([&] { UNLOCK_TCPIP_CORE(); });
+  auto it = std::ranges::find(in_flight_, id, &InFlight::id);
+  // The publish timed out, or the batch it belonged to was restarted.
+  if (it == in_flight_.end()) return;
+  const Item item = it->item;
+  in_flight_.erase(it);
+
+  if (err != ERR_OK) {
+    printf("announce publish failed (%d), will retry\n", err);
+    ++progress_.retries;
+    pending_.insert(pending_.begin(), item);
+    return;
+  }
+
+  ++progress_.published;
+  if (options_.on_progress && progress_.published < progress_.total) {
+    options_.on_progress(progress_);
+  }
+  MaybeFinishBatch();
+}
+
+void Device::ExpireInFlight() {
+  const TickType_t now = xTaskGetTickCount();
+  std::erase_if(in_flight_, [&](const InFlight& publish) {
+    if (now - publish.sent < options_.ack_timeout) return false;
+    printf("announce publish not acknowledged, will retry\n");
+    ++progress_.retries;
+    pending_.insert(pending_.begin(), publish.item);
+    return true;
+  });
+}
+
+void Device::MaybeFinishBatch() {
+  if (!pending_.empty() || !in_flight_.empty() || progress_.done) return;
+  progress_.done = true;
+  xTimerStop(timer_, 0);
+  if (options_.on_progress) options_.on_progress(progress_);
+  events_.Set(kDiscoveryDone);
+}
+
+err_t Device::PublishState(
+    lwipxx::MqttClient& client, Entity& entity, std::string_view state) {
+  LOCK_TCPIP_CORE();
+  auto cleanup = jagspico::Cleanup([&] { UNLOCK_TCPIP_CORE(); });
+  if (entity.last_state_) {
+    // Reuses the existing allocation when the new state fits.
+    entity.last_state_->assign(state);
+  } else {
+    entity.last_state_.emplace(state);
+  }
+  return client.Publish(
+      entity.state_topic(), state, lwipxx::MqttClient::kBestEffort, true);
+}
+
+TickType_t Device::BirthJitter(TickType_t max_jitter) {
+  if (max_jitter == 0) return 0;
+  pico_unique_board_id_t id;
+  pico_get_unique_board_id(&id);
+  // FNV-1a, so that boards whose ids differ in only a few bits still end up
+  // far apart.
+  uint32_t hash = 2166136261u;
+  for (uint8_t byte : id.id) {
+    hash ^= byte;
+    hash *= 16777619u;
+  }
+  return hash % max_jitter;
+}
+
+err_t Device::ListenForBirth(lwipxx::MqttClient& client, BirthOptions options) {
+  birth_client_ = &client;
+  birth_options_ = std::move(options);
+  birth_options_.discovery.with_state = true;
+  if (birth_timer_ == nullptr) {
+    birth_timer_ = xTimerCreate(
+        "ha_birth", 1, pdFALSE, this, +[](TimerHandle_t timer) {
+          static_cast<Device*>(pvTimerGetTimerID(timer))->Reannounce();
+        });
+    configASSERT(birth_timer_ != nullptr);
+  }
+
+  const TickType_t delay =
+      std::max<TickType_t>(BirthJitter(birth_options_.max_jitter), 1);
+  return client.Subscribe(
+      birth_options_.topic,
+      lwipxx::MqttClient::kAtLeastOnce,
+      [this, delay](const lwipxx::MqttClient::Message& message) {
+        if (message.data != birth_options_.online_payload) return;
+        printf("home assistant is online, re-announcing in %lu ticks\n", delay);
+        // Runs in the tcpip thread, so the timer command must not block. A
+        // repeated birth message simply restarts the delay.
+        xTimerChangePeriod(birth_timer_, delay, 0);
+      });
+}
+
+void Device::Reannounce() {
+  PublishDiscovery(*birth_client_, birth_options_.discovery);
+}
+
+}  // namespace homeassistant
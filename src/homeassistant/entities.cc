@@ -0,0 +1,128 @@
+#include "homeassistant/entities.h"
+
+#include <cstdio>
+
+namespace homeassistant {
+
+void AddSwitchInfo(const CommonDeviceInfo& info, JsonBuilder& builder) {
+  builder.Kv("command_topic", RelativeChannel(topic_suffix::kCommand));
+  builder.Kv("state_topic", RelativeChannel(topic_suffix::kState));
+  builder.Kv("payload_on", switch_payloads::kOn);
+  builder.Kv("payload_off", switch_payloads::kOff);
+  builder.Kv("state_on", switch_payloads::kOn);
+  builder.Kv("state_off", switch_payloads::kOff);
+  builder.Kv("optimistic", false);
+  builder.Kv("retain", true);
+}
+
+void AddBinarySensorInfo(const CommonDeviceInfo& info, JsonBuilder& builder) {
+  builder.Kv("state_topic", RelativeChannel(topic_suffix::kState));
+  builder.Kv("payload_on", binary_sensor_payloads::kOn);
+  builder.Kv("payload_off", binary_sensor_payloads::kOff);
+}
+
+void AddNumberInfo(
+    const CommonDeviceInfo& info, const NumberInfo& number,
+    JsonBuilder& builder) {
+  builder.Kv("command_topic", RelativeChannel(topic_suffix::kCommand));
+  builder.Kv("state_topic", RelativeChannel(topic_suffix::kState));
+  builder.Kv("min", number.min);
+  builder.Kv("max", number.max);
+  builder.Kv("step", number.step);
+  builder.Kv("mode", number.mode);
+  builder.KvIf("unit_of_measurement", number.unit_of_measurement);
+  builder.Kv("optimistic", false);
+  builder.Kv("retain", true);
+}
+
+void AddLightInfo(
+    const CommonDeviceInfo& info, const LightInfo& light,
+    JsonBuilder& builder) {
+  static constexpr std::string_view kOnOff[] = {"onoff"};
+  builder.Kv("schema", "json");
+  builder.Kv("command_topic", RelativeChannel(topic_suffix::kCommand));
+  builder.Kv("state_topic", RelativeChannel(topic_suffix::kState));
+  builder.Kv(
+      "supported_color_modes",
+      light.color_modes.empty() ? std::span<const std::string_view>(kOnOff)
+                                 : light.color_modes);
+  if (!light.effects.empty()) {
+    builder.Kv("effect", true);
+    builder.Kv("effect_list", light.effects);
+  }
+  builder.Kv("optimistic", false);
+  builder.Kv("retain", true);
+}
+
+std::string LightStateMessage(const LightCommand& state) {
+  JsonBuilder builder;
+  if (state.state) {
+    builder.Kv(
+        "state", *state.state ? switch_payloads::kOn : switch_payloads::kOff);
+  }
+  builder.KvIf("brightness", state.brightness);
+  if (state.color_temp) {
+    builder.Kv("color_mode", "color_temp");
+    builder.Kv("color_temp", *state.color_temp);
+  } else if (state.rgb) {
+    builder.Kv("color_mode", "rgb");
+    auto color_closer = builder.EnterDict("color");
+    builder.Kv("r", state.rgb->r);
+    builder.Kv("g", state.rgb->g);
+    builder.Kv("b", state.rgb->b);
+  } else if (state.hs) {
+    builder.Kv("color_mode", "hs");
+    auto color_closer = builder.EnterDict("color");
+    builder.Kv("h", state.hs->h);
+    builder.Kv("s", state.hs->s);
+  }
+  builder.KvIf("effect", state.effect);
+  return std::move(builder).Finish();
+}
+
+namespace internal {
+
+void LogUnknownCommand(const lwipxx::MqttClient::Message& msg) {
+  printf(
+      "ignoring unknown command on %.*s: %.*s\n",
+      static_cast<int>(msg.topic.size()),
+      msg.topic.data(),
+      static_cast<int>(msg.data.size()),
+      msg.data.data());
+}
+
+}  // namespace internal
+
+CommandHandler CoverCommandHandler(
+    std::function<void(CoverCommand)> on_command) {
+  return PayloadCommandHandler(kCoverCommands, std::move(on_command));
+}
+
+CommandHandler SwitchCommandHandler(std::function<void(bool on)> on_command) {
+  return PayloadCommandHandler(kSwitchCommands, std::move(on_command));
+}
+
+CommandHandler NumberCommandHandler(std::function<void(float)> on_command) {
+  return [on_command = std::move(on_command)](
+             const lwipxx::MqttClient::Message& msg) {
+    if (std::optional<float> value = DecodeNumberCommand(msg.data)) {
+      on_command(*value);
+    } else {
+      internal::LogUnknownCommand(msg);
+    }
+  };
+}
+
+CommandHandler LightCommandHandler(
+    std::function<void(const LightCommand&)> on_command) {
+  return [on_command = std::move(on_command)](
+             const lwipxx::MqttClient::Message& msg) {
+    if (std::optional<LightCommand> command = DecodeLightCommand(msg.data)) {
+      on_command(*command);
+    } else {
+      internal::LogUnknownCommand(msg);
+    }
+  };
+}
+
+}  // namespace homeassistant
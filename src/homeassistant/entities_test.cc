@@ -0,0 +1,81 @@
+#include "homeassistant/entities.h"
+
+#include <string_view>
+
+#include "pico/platform.h"
+#include "pico/printf.h"
+#include "pico/stdio.h"
+#include "util/expect.h"
+
+using namespace homeassistant;
+using jagspico::Expect;
+
+enum class Fan { kOff, kLow, kMedium, kHigh, kAuto };
+
+// Payloads that share lengths and first bytes, to exercise the seed search.
+constexpr PayloadMap<Fan, 5> kFanCommands({
+    {"off", Fan::kOff},
+    {"low", Fan::kLow},
+    {"medium", Fan::kMedium},
+    {"high", Fan::kHigh},
+    {"auto", Fan::kAuto},
+});
+static_assert(kFanCommands.Find("medium") == Fan::kMedium);
+static_assert(!kFanCommands.Find("mediu"));
+
+static lwipxx::MqttClient::Message MakeMessage(std::string_view data) {
+  return {.topic = "homeassistant/test/cmd", .data = data, .flags = 0};
+}
+
+int main() {
+  stdio_init_all();
+
+  Expect(kFanCommands.Find("off") == Fan::kOff, "fan off");
+  Expect(kFanCommands.Find("low") == Fan::kLow, "fan low");
+  Expect(kFanCommands.Find("high") == Fan::kHigh, "fan high");
+  Expect(kFanCommands.Find("auto") == Fan::kAuto, "fan auto");
+  Expect(!kFanCommands.Find(""), "fan empty");
+  Expect(!kFanCommands.Find("hugh"), "fan near miss");
+  Expect(kFanCommands.Payload(Fan::kHigh) == "high", "fan payload");
+
+  Expect(
+      kCoverCommands.Find(cover_payloads::kStopCommand) == CoverCommand::kStop,
+      "cover stop");
+  Expect(kSwitchCommands.Find("ON") == true, "switch on");
+  Expect(kSwitchCommands.Find("OFF") == false, "switch off");
+  Expect(!kSwitchCommands.Find("on"), "switch is case sensitive");
+
+  int calls = 0;
+  CoverCommand last_cover = CoverCommand::kOpen;
+  auto cover_handler = CoverCommandHandler([&](CoverCommand command) {
+    ++calls;
+    last_cover = command;
+  });
+  cover_handler(MakeMessage(cover_payloads::kCloseCommand));
+  Expect(calls == 1 && last_cover == CoverCommand::kClose, "cover handler");
+  cover_handler(MakeMessage("nonsense"));
+  Expect(calls == 1, "cover handler drops unknown payloads");
+
+  float last_number = 0;
+  auto number_handler = NumberCommandHandler([&](float v) { last_number = v; });
+  number_handler(MakeMessage("12.5"));
+  Expect(last_number == 12.5f, "number handler");
+
+  std::optional<int> last_brightness;
+  auto light_handler = LightCommandHandler(
+      [&](const LightCommand& command) { last_brightness = command.brightness; });
+  light_handler(MakeMessage(R"({"state": "ON", "brightness": 99})"));
+  Expect(last_brightness == 99, "light handler");
+
+  LightCommand state;
+  state.state = true;
+  state.brightness = 99;
+  state.rgb = LightCommand::Rgb{.r = 1, .g = 2, .b = 3};
+  const std::string message = LightStateMessage(state);
+  Expect(
+      message == R"({"state": "ON", "brightness": 99, "color_mode": "rgb", )"
+                 R"("color": {"r": 1, "g": 2, "b": 3}})",
+      "light state message");
+
+  printf("PASS\n");
+}
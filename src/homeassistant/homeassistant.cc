@@ -9,16 +9,26 @@
 
 namespace homeassistant {
 
-static constexpr std::string_view kOnlinePayload = "online";
-static constexpr std::string_view kOfflinePayload = "offline";
+static constexpr std::string_view kOnlinePayload =
+    availability_payloads::kOnline;
+static constexpr std::string_view kOfflinePayload =
+    availability_payloads::kOffline;
 
-std::string_view AvailabilityTopic() {
-  static const std::string* const kAvailabilityTopic = [] {
+std::string_view BoardIdentifier() {
+  static const std::string* const kBoardIdentifier = [] {
     pico_unique_board_id_t id;
     pico_get_unique_board_id(&id);
     const uint64_t unique_id = *reinterpret_cast<uint64_t*>(id.id);
-    return new std::string(
-        jagspico::ssprintf("devices/%0llx/available", unique_id));
+    return new std::string(jagspico::ssprintf("%0llx", unique_id));
+  }();
+  return *kBoardIdentifier;
+}
+
+std::string_view AvailabilityTopic() {
+  static const std::string* const kAvailabilityTopic = [] {
+    const std::string_view id = BoardIdentifier();
+    return new std::string(jagspico::ssprintf(
+        "devices/%.*s/available", static_cast<int>(id.size()), id.data()));
   }();
   return *kAvailabilityTopic;
 }
@@ -38,8 +48,13 @@ void AddAvailabilityDiscovery(JsonBuilder& json) {
 }
 
 std::string DeviceRootTopic(const CommonDeviceInfo& info) {
+  // The views are not necessarily nul-terminated.
   return jagspico::ssprintf(
-      "homeassistant/%s/%s", info.component->data(), info.unique_id.data());
+      "homeassistant/%.*s/%.*s",
+      static_cast<int>(info.component->size()),
+      info.component->data(),
+      static_cast<int>(info.unique_id.size()),
+      info.unique_id.data());
 }
 
 std::string AbsoluteChannel(
@@ -79,7 +94,13 @@ void PublishDiscovery(
 }
 
 void AddCommonInfo(const CommonDeviceInfo& info, JsonBuilder& builder) {
-  builder.Kv("~", DeviceRootTopic(info));
+  AddCommonInfo(info, DeviceRootTopic(info), builder);
+}
+
+void AddCommonInfo(
+    const CommonDeviceInfo& info, std::string_view root_topic,
+    JsonBuilder& builder) {
+  builder.Kv("~", root_topic);
   builder.KvIf("name", info.name);
   builder.Kv("unique_id", info.unique_id);
   builder.KvIf("device_class", info.device_class);
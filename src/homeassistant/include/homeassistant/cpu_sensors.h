@@ -0,0 +1,57 @@
+#ifndef JAGSPICO_HA_CPU_SENSORS_H
+#define JAGSPICO_HA_CPU_SENSORS_H
+
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "freertosxx/runtime_stats.h"
+#include "homeassistant/device.h"
+#include "lwipxx/mqtt.h"
+
+namespace homeassistant {
+
+// Publishes a CpuMonitor's samples as Home Assistant sensors: the load of
+// the whole CPU, and that of each of a chosen set of tasks. The states are
+// JSON objects whose "value" is the load in percent; the context switch
+// rate and, for tasks, the stack high water are attributes.
+//
+//   CpuSensors cpu(device, "garage", kWatchedTasks);
+//   device.PublishDiscovery(client);
+//   freertosxx::CpuMonitor monitor;
+//   while (true) {
+//     if (monitor.Sample()) cpu.Publish(client, monitor);
+//     vTaskDelay(pdMS_TO_TICKS(10000));
+//   }
+//
+// The device must outlive this.
+class CpuSensors {
+ public:
+  // Adds the sensors to device, with the unique ids <id_prefix>_cpu and
+  // <id_prefix>_cpu_<task name>.
+  CpuSensors(
+      Device& device, std::string_view id_prefix,
+      std::span<const std::string_view> tasks);
+  CpuSensors(const CpuSensors&) = delete;
+  CpuSensors& operator=(const CpuSensors&) = delete;
+
+  // Publishes the states from monitor's latest sample. A watched task that
+  // was not in it is skipped. Returns the first error from PublishState.
+  err_t Publish(
+      lwipxx::MqttClient& client, const freertosxx::CpuMonitor& monitor);
+
+ private:
+  struct Watched {
+    std::string task;
+    Entity* entity;
+  };
+
+  Device& device_;
+  Entity* total_;
+  std::vector<Watched> tasks_;
+};
+
+}  // namespace homeassistant
+
+#endif  // JAGSPICO_HA_CPU_SENSORS_H
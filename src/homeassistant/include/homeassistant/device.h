@@ -0,0 +1,240 @@
+#ifndef JAGSPICO_HA_DEVICE_H
+#define JAGSPICO_HA_DEVICE_H
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "FreeRTOS.h"
+#include "freertosxx/event.h"
+#include "homeassistant/homeassistant.h"
+#include "homeassistant/topics.h"
+#include "lwipxx/mqtt.h"
+#include "timers.h"
+
+namespace homeassistant {
+
+// Describes the physical device that a set of entities belongs to. Home
+// Assistant groups every entity whose discovery message carries the same
+// device identifier under a single device.
+struct DeviceInfo {
+  // If empty, BoardIdentifier() is used.
+  std::string_view identifier;
+  std::optional<std::string_view> name;
+  std::optional<std::string_view> manufacturer;
+  std::optional<std::string_view> model;
+  std::optional<std::string_view> sw_version;
+};
+
+// Adds the "device" block shared by all entities of a device.
+void AddDeviceInfo(const DeviceInfo& info, JsonBuilder& builder);
+
+// One entity registered with a Device. The discovery message is rendered
+// when the entity is registered, so publishing it later costs nothing but
+// the publish itself.
+class Entity {
+ public:
+  Entity(const Entity&) = delete;
+  Entity& operator=(const Entity&) = delete;
+
+  std::string_view unique_id() const { return unique_id_; }
+  std::string_view component() const { return component_; }
+
+  const EntityTopics& topics() const { return topics_; }
+  std::string_view discovery_topic() const { return topics_.discovery(); }
+  std::string_view state_topic() const { return topics_.state(); }
+  std::string_view command_topic() const { return topics_.command(); }
+  const std::string& discovery_message() const { return discovery_message_; }
+
+  // The payload most recently passed to Device::PublishState, if any.
+  const std::optional<std::string>& last_state() const { return last_state_; }
+
+ private:
+  friend class Device;
+  explicit Entity(const CommonDeviceInfo& info)
+      : unique_id_(info.unique_id),
+        component_(*info.component),
+        topics_(info) {}
+
+  std::string unique_id_;
+  std::string component_;
+  EntityTopics topics_;
+  std::string discovery_message_;
+  std::optional<std::string> last_state_;
+};
+
+// A registry of the entities that make up one device.
+//
+// Discovery for every registered entity is published as one batch. The
+// batch is paced by a FreeRTOS software timer: on each tick at most one
+// discovery message is handed to the MQTT client, and up to max_in_flight
+// messages may be awaiting acknowledgement from the broker at once. Messages
+// that fail are retried on later ticks, with the tick period backing off while
+// the client refuses publishes.
+//
+// When Home Assistant restarts it forgets every discovered entity. It then
+// publishes a birth message and expects devices to announce themselves again.
+// ListenForBirth handles this: the device re-publishes discovery, availability
+// and the last state of each entity after a delay derived from the board's
+// unique id, so a fleet of devices doesn't hit the broker at the same instant.
+//
+// The Device must outlive any batch it has started. Entities must not be added
+// while a batch is in progress.
+class Device {
+ public:
+  explicit Device(DeviceInfo info);
+  ~Device();
+  Device(const Device&) = delete;
+  Device& operator=(const Device&) = delete;
+
+  // Fills in the component specific parts of an entity's discovery message.
+  // E.g. AddCoverInfo.
+  using DiscoveryFiller =
+      std::function<void(const CommonDeviceInfo& info, JsonBuilder& builder)>;
+
+  // Registers an entity. info.component must be set. The device block,
+  // the common info and the availability info are added to the discovery
+  // message automatically.
+  Entity& AddEntity(const CommonDeviceInfo& info, const DiscoveryFiller& fill);
+
+  const std::vector<std::unique_ptr<Entity>>& entities() const {
+    return entities_;
+  }
+  const DeviceInfo& info() const { return info_; }
+
+  struct DiscoveryProgress {
+    int published = 0;
+    int total = 0;
+    // The number of publishes that were refused or not acknowledged and had
+    // to be retried.
+    int retries = 0;
+    bool done = false;
+  };
+
+  struct DiscoveryOptions {
+    // Maximum number of discovery messages awaiting acknowledgement.
+    int max_in_flight = 4;
+
+    // Minimum delay between two discovery publishes.
+    TickType_t interval = pdMS_TO_TICKS(25);
+
+    // A publish that is not acknowledged within this long is retried. lwIP
+    // drops in-flight publishes without calling back when the connection is
+    // lost, so without this the batch would never finish.
+    TickType_t ack_timeout = pdMS_TO_TICKS(15000);
+
+    // After the discovery messages, also publish availability and the last
+    // state of every entity that has one.
+    bool with_state = false;
+
+    // Called after each acknowledged message, and once more with done set
+    // when the batch has finished. Runs in the tcpip thread or the timer
+    // task. Must not block.
+    std::function<void(const DiscoveryProgress&)> on_progress;
+  };
+
+  // Starts publishing a retained discovery message for every entity. Returns
+  // immediately. If a batch is already in progress, it is restarted.
+  //
+  // Must not be called from the tcpip thread.
+  void PublishDiscovery(lwipxx::MqttClient& client, DiscoveryOptions options);
+  void PublishDiscovery(lwipxx::MqttClient& client) {
+    PublishDiscovery(client, DiscoveryOptions());
+  }
+
+  // Waits for the last batch started with PublishDiscovery to finish. Returns
+  // false on timeout.
+  bool WaitForDiscovery(std::optional<TickType_t> timeout = std::nullopt);
+
+  // Publishes a retained state for entity, and remembers it so that it can be
+  // re-announced. Returns the result of MqttClient::Publish. Even on failure,
+  // the state is remembered.
+  err_t PublishState(
+      lwipxx::MqttClient& client, Entity& entity, std::string_view state);
+
+  struct BirthOptions {
+    // Home Assistant's birth topic and online payload.
+    std::string_view topic = "homeassistant/status";
+    std::string_view online_payload = availability_payloads::kOnline;
+
+    // The re-announce is delayed by a per-board amount in [0, max_jitter).
+    TickType_t max_jitter = pdMS_TO_TICKS(5000);
+
+    // Options for the re-announce batch. with_state is always set.
+    DiscoveryOptions discovery;
+  };
+
+  // Subscribes to Home Assistant's birth topic. Each time Home Assistant comes
+  // online, discovery, availability and the last known state of each entity
+  // are re-published.
+  [[nodiscard]] err_t ListenForBirth(
+      lwipxx::MqttClient& client, BirthOptions options);
+  [[nodiscard]] err_t ListenForBirth(lwipxx::MqttClient& client) {
+    return ListenForBirth(client, BirthOptions());
+  }
+
+  // The delay applied to this board's re-announce. Derived from the board's
+  // unique id, so it is stable for a device but differs between devices.
+  static TickType_t BirthJitter(TickType_t max_jitter);
+
+ private:
+  static constexpr EventBits_t kDiscoveryDone = 0b1;
+  static constexpr TickType_t kMaxRetryInterval = pdMS_TO_TICKS(5000);
+
+  // Publishes the next pending message, if the pipeline has room. Called from
+  // the timer task.
+  void Pump();
+
+  struct Item {
+    enum Kind { kDiscovery, kAvailability, kState };
+    Kind kind;
+    Entity* entity;
+  };
+
+  struct InFlight {
+    uint32_t id;
+    Item item;
+    TickType_t sent;
+  };
+
+  // Handles the broker's response to a publish. Called from the tcpip thread.
+  void FinishPublish(uint32_t id, err_t err);
+
+  // Requeues the publishes that have waited longer than ack_timeout.
+  void ExpireInFlight();
+
+  void MaybeFinishBatch();
+
+  // Called from the timer task when the birth jitter delay has elapsed.
+  void Reannounce();
+
+  DeviceInfo info_;
+  std::vector<std::unique_ptr<Entity>> entities_;
+
+  // Batch state. Only touched with the tcpip core lock held.
+  lwipxx::MqttClient* client_ = nullptr;
+  DiscoveryOptions options_;
+  DiscoveryProgress progress_;
+  std::vector<Item> pending_;
+  // Publishes awaiting acknowledgement, oldest first.
+  std::vector<InFlight> in_flight_;
+  int consecutive_failures_ = 0;
+  // Identifies each publish, so that a late acknowledgement for one that
+  // timed out, or that belonged to a restarted batch, is ignored.
+  uint32_t next_publish_id_ = 0;
+
+  TimerHandle_t timer_;
+  freertosxx::EventGroup events_;
+
+  // Set by ListenForBirth.
+  lwipxx::MqttClient* birth_client_ = nullptr;
+  BirthOptions birth_options_;
+  TimerHandle_t birth_timer_ = nullptr;
+};
+
+}  // namespace homeassistant
+
+#endif  // JAGSPICO_HA_DEVICE_H
@@ -0,0 +1,118 @@
+#ifndef JAGSPICO_HA_ENTITIES_H
+#define JAGSPICO_HA_ENTITIES_H
+
+#include <functional>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "homeassistant/homeassistant.h"
+#include "homeassistant/json.h"
+#include "homeassistant/payload_map.h"
+#include "lwipxx/mqtt.h"
+
+namespace homeassistant {
+
+// Discovery fillers, payloads and typed command handlers for the entity types
+// beyond cover and sensor. Pass the fillers to Device::AddEntity and the
+// handlers to MqttClient::Subscribe on the entity's command topic.
+//
+// A command handler decodes each message exactly once, before calling back
+// with a typed value. Unrecognized payloads are logged and dropped.
+
+// Home Assistant's defaults for switch and binary_sensor.
+namespace switch_payloads {
+constexpr std::string_view kOn = "ON";
+constexpr std::string_view kOff = "OFF";
+}  // namespace switch_payloads
+
+namespace binary_sensor_payloads {
+constexpr std::string_view kOn = "ON";
+constexpr std::string_view kOff = "OFF";
+}  // namespace binary_sensor_payloads
+
+enum class CoverCommand { kOpen, kClose, kStop };
+
+inline constexpr PayloadMap<CoverCommand, 3> kCoverCommands({
+    {cover_payloads::kOpenCommand, CoverCommand::kOpen},
+    {cover_payloads::kCloseCommand, CoverCommand::kClose},
+    {cover_payloads::kStopCommand, CoverCommand::kStop},
+});
+
+inline constexpr PayloadMap<bool, 2> kSwitchCommands({
+    {switch_payloads::kOn, true},
+    {switch_payloads::kOff, false},
+});
+
+constexpr std::string_view SwitchState(bool on) {
+  return on ? switch_payloads::kOn : switch_payloads::kOff;
+}
+
+constexpr std::string_view BinarySensorState(bool on) {
+  return on ? binary_sensor_payloads::kOn : binary_sensor_payloads::kOff;
+}
+
+struct NumberInfo {
+  float min = 1;
+  float max = 100;
+  float step = 1;
+  std::optional<std::string_view> unit_of_measurement;
+  // "auto", "box" or "slider".
+  std::string_view mode = "auto";
+};
+
+struct LightInfo {
+  // E.g. "onoff", "brightness", "color_temp", "hs" or "rgb". Defaults to
+  // "onoff" when empty.
+  std::span<const std::string_view> color_modes;
+  std::span<const std::string_view> effects;
+};
+
+void AddSwitchInfo(const CommonDeviceInfo& info, JsonBuilder& builder);
+void AddBinarySensorInfo(const CommonDeviceInfo& info, JsonBuilder& builder);
+void AddNumberInfo(
+    const CommonDeviceInfo& info, const NumberInfo& number,
+    JsonBuilder& builder);
+// A light using the json schema, whose commands DecodeLightCommand parses.
+void AddLightInfo(
+    const CommonDeviceInfo& info, const LightInfo& light, JsonBuilder& builder);
+
+// Renders a light's state for its state topic. Only the fields that are set
+// are included.
+std::string LightStateMessage(const LightCommand& state);
+
+using CommandHandler = lwipxx::MqttClient::DataHandler;
+
+// Dispatches payloads found in map to on_command. map is copied.
+template <typename T, size_t N>
+CommandHandler PayloadCommandHandler(
+    const PayloadMap<T, N>& map, std::function<void(T)> on_command);
+
+CommandHandler CoverCommandHandler(
+    std::function<void(CoverCommand)> on_command);
+CommandHandler SwitchCommandHandler(std::function<void(bool on)> on_command);
+CommandHandler NumberCommandHandler(std::function<void(float)> on_command);
+CommandHandler LightCommandHandler(
+    std::function<void(const LightCommand&)> on_command);
+
+namespace internal {
+void LogUnknownCommand(const lwipxx::MqttClient::Message& msg);
+}  // namespace internal
+
+template <typename T, size_t N>
+CommandHandler PayloadCommandHandler(
+    const PayloadMap<T, N>& map, std::function<void(T)> on_command) {
+  return [map, on_command = std::move(on_command)](
+             const lwipxx::MqttClient::Message& msg) {
+    if (std::optional<T> command = map.Find(msg.data)) {
+      on_command(*command);
+    } else {
+      internal::LogUnknownCommand(msg);
+    }
+  };
+}
+
+}  // namespace homeassistant
+
+#endif  // JAGSPICO_HA_ENTITIES_H
@@ -46,6 +46,25 @@ class JsonBuilder {
     want_sep = true;
   }
 
+  void Kv(std::string_view key, int number) {
+    Key(key);
+    json_.append(std::to_string(number));
+    want_sep = true;
+  }
+
+  void Kv(std::string_view key, std::span<const std::string_view> values) {
+    Key(key);
+    json_.append("[");
+    for (size_t i = 0; i < values.size(); ++i) {
+      if (i > 0) json_.append(", ");
+      json_.append("\"");
+      json_.append(values[i]);
+      json_.append("\"");
+    }
+    json_.append("]");
+    want_sep = true;
+  }
+
   void Kv(std::string_view key, const char* text) {
     Kv(key, std::string_view(text));
   }
@@ -85,6 +104,9 @@ class JsonBuilder {
   bool want_sep = false;
 };
 
+// A hex rendering of the board's unique id. Stable across reboots.
+std::string_view BoardIdentifier();
+
 std::string_view AvailabilityTopic();
 void SetAvailablityLwt(lwipxx::MqttClient::ConnectInfo& info);
 
@@ -116,7 +138,13 @@ void PublishDiscovery(
     std::string_view discovery_message);
 
 void AddCommonInfo(const CommonDeviceInfo& info, JsonBuilder& builder);
+// As above, with a precomputed DeviceRootTopic(info).
+void AddCommonInfo(
+    const CommonDeviceInfo& info, std::string_view root_topic,
+    JsonBuilder& builder);
 
+// These build a new string on every call. Prefer EntityTopics (topics.h) for
+// topics that are used repeatedly.
 std::string DeviceRootTopic(const CommonDeviceInfo& info);
 
 // DeviceRootTopic(info) "/" suffix
@@ -135,6 +163,11 @@ constexpr std::string_view kCommand = "cmd";
 constexpr std::string_view kState = "sta";
 }  // namespace topic_suffix
 
+namespace availability_payloads {
+constexpr std::string_view kOnline = "online";
+constexpr std::string_view kOffline = "offline";
+}  // namespace availability_payloads
+
 namespace cover_payloads {
 constexpr std::string_view kOpenCommand = "o";
 constexpr std::string_view kCloseCommand = "c";
@@ -0,0 +1,121 @@
+#ifndef JAGSPICO_HA_JSON_H
+#define JAGSPICO_HA_JSON_H
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+
+namespace homeassistant {
+
+// An in-place, SAX-style JSON tokenizer for command payloads.
+//
+// The tokenizer never allocates and never copies: every string and number is
+// reported as a view into the input, e.g. MqttClient::Message::data, so the
+// views are only valid as long as the input is. Strings are reported raw,
+// without their quotes and with escape sequences left as they are. Use
+// JsonUnescape if a string may contain escapes and the decoded form matters.
+
+// Receives the tokens of a document in order. Each method returns false to
+// stop parsing, in which case ParseJson returns kStopped.
+class JsonVisitor {
+ public:
+  virtual ~JsonVisitor() = default;
+
+  virtual bool StartObject() { return true; }
+  virtual bool EndObject() { return true; }
+  virtual bool StartArray() { return true; }
+  virtual bool EndArray() { return true; }
+  virtual bool Key(std::string_view /*raw*/) { return true; }
+  virtual bool String(std::string_view /*raw*/) { return true; }
+  // text is the number exactly as it appears in the input. See JsonToInt and
+  // JsonToFloat.
+  virtual bool Number(std::string_view /*text*/) { return true; }
+  virtual bool Bool(bool /*value*/) { return true; }
+  virtual bool Null() { return true; }
+};
+
+enum class JsonError {
+  kOk,
+  kSyntax,
+  // The document has more tokens than JsonLimits::max_tokens.
+  kTooManyTokens,
+  // The document nests deeper than JsonLimits::max_depth.
+  kTooDeep,
+  // The visitor asked to stop.
+  kStopped,
+};
+
+const char* JsonErrorString(JsonError error);
+
+struct JsonLimits {
+  // Keys, scalars, objects and arrays each count as one token.
+  int max_tokens = 64;
+  // At most 32.
+  int max_depth = 8;
+};
+
+// Tokenizes json, which must hold exactly one JSON value, calling visitor for
+// each token. Validation is strict enough to reject malformed input, but
+// the document is only checked up to the point where the visitor stops.
+JsonError ParseJson(
+    std::string_view json, JsonVisitor& visitor, JsonLimits limits = {});
+
+// Decodes the escape sequences in a raw string token into out. Returns the
+// decoded string, or nullopt if out is too small or an escape is malformed.
+// \u escapes are encoded as UTF-8, and an unpaired surrogate or an escape JSON
+// doesn't define, e.g. \x, is malformed.
+std::optional<std::string_view> JsonUnescape(
+    std::string_view raw, std::span<char> out);
+
+std::optional<int32_t> JsonToInt(std::string_view text);
+// Returns nullopt unless text is a finite number that fits in a float.
+std::optional<float> JsonToFloat(std::string_view text);
+
+// Decoders for the command payloads of Home Assistant's MQTT entities. The
+// string_views in the results point into the payload.
+
+// A command for a light using the "json" schema.
+// https://www.home-assistant.io/integrations/light.mqtt/#json-schema
+struct LightCommand {
+  struct Rgb {
+    uint8_t r = 0;
+    uint8_t g = 0;
+    uint8_t b = 0;
+  };
+  struct Hs {
+    float h = 0;
+    float s = 0;
+  };
+
+  std::optional<bool> state;
+  std::optional<int> brightness;
+  std::optional<int> color_temp;
+  std::optional<Rgb> rgb;
+  std::optional<Hs> hs;
+  std::optional<float> transition;
+  std::optional<std::string_view> effect;
+};
+std::optional<LightCommand> DecodeLightCommand(std::string_view payload);
+
+// A command for a number entity. Accepts the plain numeric payload Home
+// Assistant sends by default, or {"value": <number>} as produced by a
+// command_template.
+std::optional<float> DecodeNumberCommand(std::string_view payload);
+
+// A command for a climate entity whose command topics share a
+// command_template rendering a JSON object, e.g.
+//   {"mode": "heat", "temperature": 21.5}
+struct ClimateCommand {
+  std::optional<std::string_view> mode;
+  std::optional<std::string_view> fan_mode;
+  std::optional<std::string_view> preset_mode;
+  std::optional<float> temperature;
+  std::optional<float> target_temp_low;
+  std::optional<float> target_temp_high;
+};
+std::optional<ClimateCommand> DecodeClimateCommand(std::string_view payload);
+
+}  // namespace homeassistant
+
+#endif  // JAGSPICO_HA_JSON_H
@@ -0,0 +1,97 @@
+#ifndef JAGSPICO_HA_PAYLOAD_MAP_H
+#define JAGSPICO_HA_PAYLOAD_MAP_H
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace homeassistant {
+
+namespace internal {
+// Deliberately not constexpr: calling it from PayloadMap's consteval
+// constructor turns a bad table into a compile error that names the problem.
+void PayloadMapHasDuplicateOrInseparablePayloads();
+}  // namespace internal
+
+// Maps a fixed set of payload strings to values in constant time.
+//
+// The table is built at compile time. The constructor searches for a hash
+// seed under which every payload lands in a slot of its own, so Find costs
+// one hash of the payload's length and first, middle and last bytes plus at
+// most one comparison, however many payloads the map holds. Payloads that
+// agree in all of those cannot be separated and fail to compile, as do
+// duplicates.
+//
+//   constexpr PayloadMap<Fan, 3> kFanCommands({
+//       {"low", Fan::kLow}, {"medium", Fan::kMedium}, {"high", Fan::kHigh}});
+//   std::optional<Fan> fan = kFanCommands.Find(msg.data);
+template <typename T, size_t N>
+class PayloadMap {
+ public:
+  struct Entry {
+    std::string_view payload;
+    T value;
+  };
+
+  consteval PayloadMap(const Entry (&entries)[N]) {
+    static_assert(N > 0 && N < 128);
+    for (size_t i = 0; i < N; ++i) entries_[i] = entries[i];
+    for (uint32_t seed = 1; seed < (1u << 16); ++seed) {
+      if (TryBuild(seed)) return;
+    }
+    internal::PayloadMapHasDuplicateOrInseparablePayloads();
+  }
+
+  constexpr std::optional<T> Find(std::string_view payload) const {
+    const int8_t index = slots_[Hash(payload, seed_)];
+    if (index < 0 || entries_[index].payload != payload) return std::nullopt;
+    return entries_[index].value;
+  }
+
+  // The payload that maps to value, or an empty view. Linear in N; meant for
+  // publishing state, which is rare next to decoding commands.
+  constexpr std::string_view Payload(T value) const {
+    for (const Entry& entry : entries_) {
+      if (entry.value == value) return entry.payload;
+    }
+    return {};
+  }
+
+ private:
+  static constexpr int kBits = std::bit_width(2 * N - 1);
+  static constexpr size_t kSlots = size_t{1} << kBits;
+
+  static constexpr size_t Hash(std::string_view s, uint32_t seed) {
+    constexpr uint32_t kPrime = 0x01000193;
+    uint32_t h = seed;
+    h = (h ^ static_cast<uint32_t>(s.size())) * kPrime;
+    if (!s.empty()) {
+      h = (h ^ static_cast<uint8_t>(s.front())) * kPrime;
+      h = (h ^ static_cast<uint8_t>(s[s.size() / 2])) * kPrime;
+      h = (h ^ static_cast<uint8_t>(s.back())) * kPrime;
+    }
+    return h >> (32 - kBits);
+  }
+
+  constexpr bool TryBuild(uint32_t seed) {
+    slots_.fill(-1);
+    for (size_t i = 0; i < N; ++i) {
+      int8_t& slot = slots_[Hash(entries_[i].payload, seed)];
+      if (slot >= 0) return false;
+      slot = static_cast<int8_t>(i);
+    }
+    seed_ = seed;
+    return true;
+  }
+
+  std::array<Entry, N> entries_{};
+  std::array<int8_t, kSlots> slots_{};
+  uint32_t seed_ = 0;
+};
+
+}  // namespace homeassistant
+
+#endif  // JAGSPICO_HA_PAYLOAD_MAP_H
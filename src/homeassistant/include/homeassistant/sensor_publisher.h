@@ -0,0 +1,144 @@
+#ifndef JAGSPICO_HA_SENSOR_PUBLISHER_H
+#define JAGSPICO_HA_SENSOR_PUBLISHER_H
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string_view>
+
+#include "FreeRTOS.h"
+#include "freertosxx/executor.h"
+#include "homeassistant/homeassistant.h"
+#include "task.h"
+
+namespace homeassistant {
+
+// Decides when a sensor's state is worth publishing.
+//
+// Samples are aggregated over a fixed window (min, max, mean, last). When a
+// window closes, its chosen statistic is published only if it has moved by
+// more than the deadband since the last publish. A window that moved before
+// min_interval has passed since then is held, and published once it has,
+// unless a later window closes first and takes its place. Regardless of the
+// deadband, the state is published again once max_interval passes, so Home
+// Assistant can tell that the sensor is still alive.
+//
+// Payloads are formatted into a buffer owned by the publisher, so this class
+// does not allocate. The payload is a JSON object:
+//
+//   {"value":21.53,"min":21.40,"max":21.60,"mean":21.53,"last":21.50,"n":40}
+//
+// Pair it with AddAggregatedSensorInfo, which tells Home Assistant to take the
+// state from "value" and the rest as attributes.
+//
+// Not thread-safe.
+class SensorPublisher {
+ public:
+  enum class Statistic { kLast, kMean, kMin, kMax };
+
+  struct Options {
+    // The statistic that becomes the sensor's state, and that the deadband is
+    // applied to.
+    Statistic statistic = Statistic::kMean;
+
+    // Publish when the statistic differs from the last published one by more
+    // than this.
+    float deadband = 0.0f;
+
+    // Length of the aggregation window.
+    TickType_t window = pdMS_TO_TICKS(1000);
+
+    // Never publish more often than this.
+    TickType_t min_interval = pdMS_TO_TICKS(1000);
+
+    // Always publish at least this often, even if nothing changed.
+    TickType_t max_interval = pdMS_TO_TICKS(5 * 60 * 1000);
+
+    // Digits after the decimal point.
+    int precision = 2;
+  };
+
+  struct WindowStats {
+    float min = 0;
+    float max = 0;
+    float mean = 0;
+    float last = 0;
+    int count = 0;
+  };
+
+  explicit SensorPublisher(Options options) : options_(options) {}
+
+  // Adds a sample. Returns the payload to publish if this sample closed a
+  // window that should be published. The returned view is valid until the
+  // next call to AddSample or Poll. NaN samples are ignored.
+  std::optional<std::string_view> AddSample(
+      float value, TickType_t now = xTaskGetTickCount());
+
+  // Call periodically when samples may stop arriving. Closes the current
+  // window if it has expired, publishes a held window once min_interval has
+  // passed, and re-publishes the last state when max_interval has passed
+  // without a publish.
+  std::optional<std::string_view> Poll(TickType_t now = xTaskGetTickCount());
+
+  // The statistics of the most recently published window.
+  const std::optional<WindowStats>& last_published() const {
+    return last_published_;
+  }
+
+ private:
+  static constexpr size_t kPayloadSize = 128;
+
+  float Select(const WindowStats& stats) const;
+
+  // Closes the window and returns the payload if it is to be published.
+  std::optional<std::string_view> CloseWindow(TickType_t now);
+
+  // Publishes the held window if min_interval has passed.
+  std::optional<std::string_view> PublishPending(TickType_t now);
+
+  std::string_view Publish(const WindowStats& stats, TickType_t now);
+
+  std::string_view Format(const WindowStats& stats);
+
+  Options options_;
+
+  // The open window.
+  bool window_open_ = false;
+  TickType_t window_start_ = 0;
+  float min_ = 0;
+  float max_ = 0;
+  float sum_ = 0;
+  float last_ = 0;
+  int count_ = 0;
+
+  std::optional<WindowStats> last_published_;
+  TickType_t last_publish_time_ = 0;
+
+  // A window that moved, but closed before min_interval had passed.
+  std::optional<WindowStats> pending_;
+
+  std::array<char, kPayloadSize> payload_;
+};
+
+// Adds samples[i] to publishers[i] for each i, with the filtering and
+// formatting spread across executor's workers. Calls publish(i, payload) for
+// each publisher that has a payload to publish, on any of the workers, and
+// possibly for several publishers at once. Each payload is valid until its
+// publisher's next AddSample or Poll.
+void AddSamples(
+    freertosxx::Executor& executor, std::span<SensorPublisher> publishers,
+    std::span<const float> samples, TickType_t now,
+    const std::function<void(size_t, std::string_view)>& publish);
+
+// Like AddSensorInfo, but for the payloads produced by SensorPublisher: the
+// state is read from the "value" field, and the window statistics are exposed
+// as attributes.
+void AddAggregatedSensorInfo(
+    const CommonDeviceInfo& info,
+    std::optional<std::string_view> unit_of_measurement, JsonBuilder& builder);
+
+}  // namespace homeassistant
+
+#endif  // JAGSPICO_HA_SENSOR_PUBLISHER_H
@@ -0,0 +1,65 @@
+#ifndef JAGSPICO_HA_TOPICS_H
+#define JAGSPICO_HA_TOPICS_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+#include "homeassistant/homeassistant.h"
+
+namespace homeassistant {
+
+// Every MQTT topic an entity uses, computed once.
+//
+// All topics live in a single allocation, each followed by a nul terminator,
+// so the views returned here can be passed straight to MqttClient::Publish and
+// MqttClient::Subscribe (which hand topic.data() to lwIP as a C string). The
+// views stay valid for the lifetime of the table.
+class EntityTopics {
+ public:
+  enum Channel {
+    // homeassistant/<component>/<unique_id>
+    kRoot,
+    // <root>/config
+    kDiscovery,
+    // <root>/sta
+    kState,
+    // <root>/cmd
+    kCommand,
+    // The device-wide availability topic. See AvailabilityTopic().
+    kAvailability,
+    kNumChannels,
+  };
+
+  // info.component must be set.
+  explicit EntityTopics(const CommonDeviceInfo& info);
+
+  EntityTopics(EntityTopics&&) = default;
+  EntityTopics& operator=(EntityTopics&&) = default;
+
+  std::string_view operator[](Channel channel) const {
+    return std::string_view(
+        &arena_[offsets_[channel]],
+        offsets_[channel + 1] - offsets_[channel] - 1);
+  }
+
+  std::string_view root() const { return (*this)[kRoot]; }
+  std::string_view discovery() const { return (*this)[kDiscovery]; }
+  std::string_view state() const { return (*this)[kState]; }
+  std::string_view command() const { return (*this)[kCommand]; }
+  std::string_view availability() const { return (*this)[kAvailability]; }
+
+  // Total size of the arena, including terminators.
+  size_t arena_size() const { return offsets_[kNumChannels]; }
+
+ private:
+  std::unique_ptr<char[]> arena_;
+  // offsets_[i] is the start of channel i. offsets_[kNumChannels] is the end
+  // of the arena.
+  std::array<uint16_t, kNumChannels + 1> offsets_;
+};
+
+}  // namespace homeassistant
+
+#endif  // JAGSPICO_HA_TOPICS_H
@@ -0,0 +1,581 @@
+#include "homeassistant/json.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+namespace homeassistant {
+
+namespace {
+
+bool IsWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+int HexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+class Tokenizer {
+ public:
+  Tokenizer(std::string_view json, JsonVisitor& visitor, JsonLimits limits)
+      : p_(json.data()),
+        end_(json.data() + json.size()),
+        visitor_(visitor),
+        limits_(limits) {}
+
+  JsonError Run();
+
+ private:
+  enum State {
+    kExpectValue,
+    // Just after '['.
+    kExpectValueOrClose,
+    kExpectKey,
+    // Just after '{'.
+    kExpectKeyOrClose,
+    kAfterValue,
+  };
+
+  void SkipWhitespace() {
+    while (p_ != end_ && IsWhitespace(*p_)) ++p_;
+  }
+
+  bool CountToken() { return ++tokens_ <= limits_.max_tokens; }
+
+  // Scans a string whose opening quote is at p_. Leaves p_ after the closing
+  // quote.
+  std::optional<std::string_view> ScanString();
+  // Scans a number starting at p_.
+  std::optional<std::string_view> ScanNumber();
+  bool ScanLiteral(std::string_view literal);
+
+  // Parses the value at p_. Objects and arrays are only opened.
+  JsonError StartValue(State& state);
+  JsonError Close(bool object);
+
+  const char* p_;
+  const char* const end_;
+  JsonVisitor& visitor_;
+  const JsonLimits limits_;
+  int tokens_ = 0;
+  int depth_ = 0;
+  // Bit i is set if the container at depth i + 1 is an object.
+  uint32_t is_object_ = 0;
+};
+
+std::optional<std::string_view> Tokenizer::ScanString() {
+  const char* const start = ++p_;
+  while (p_ != end_) {
+    const char c = *p_;
+    if (c == '"') {
+      std::string_view raw(start, p_ - start);
+      ++p_;
+      return raw;
+    }
+    if (static_cast<unsigned char>(c) < 0x20) return std::nullopt;
+    if (c != '\\') {
+      ++p_;
+      continue;
+    }
+    if (++p_ == end_) return std::nullopt;
+    switch (*p_) {
+      case '"':
+      case '\\':
+      case '/':
+      case 'b':
+      case 'f':
+      case 'n':
+      case 'r':
+      case 't':
+        ++p_;
+        break;
+      case 'u':
+        ++p_;
+        if (end_ - p_ < 4) return std::nullopt;
+        for (int i = 0; i < 4; ++i) {
+          if (HexValue(*p_++) < 0) return std::nullopt;
+        }
+        break;
+      default:
+        return std::nullopt;
+    }
+  }
+  return std::nullopt;
+}
+
+std::optional<std::string_view> Tokenizer::ScanNumber() {
+  const char* const start = p_;
+  if (p_ != end_ && *p_ == '-') ++p_;
+  if (p_ == end_) return std::nullopt;
+  if (*p_ == '0') {
+    ++p_;
+  } else if (IsDigit(*p_)) {
+    while (p_ != end_ && IsDigit(*p_)) ++p_;
+  } else {
+    return std::nullopt;
+  }
+  if (p_ != end_ && *p_ == '.') {
+    ++p_;
+    if (p_ == end_ || !IsDigit(*p_)) return std::nullopt;
+    while (p_ != end_ && IsDigit(*p_)) ++p_;
+  }
+  if (p_ != end_ && (*p_ == 'e' || *p_ == 'E')) {
+    ++p_;
+    if (p_ != end_ && (*p_ == '+' || *p_ == '-')) ++p_;
+    if (p_ == end_ || !IsDigit(*p_)) return std::nullopt;
+    while (p_ != end_ && IsDigit(*p_)) ++p_;
+  }
+  return std::string_view(start, p_ - start);
+}
+
+bool Tokenizer::ScanLiteral(std::string_view literal) {
+  if (static_cast<size_t>(end_ - p_) < literal.size() ||
+      std::memcmp(p_, literal.data(), literal.size()) != 0) {
+    return false;
+  }
+  p_ += literal.size();
+  return true;
+}
+
+JsonError Tokenizer::StartValue(State& state) {
+  if (!CountToken()) return JsonError::kTooManyTokens;
+  bool keep_going = true;
+  switch (*p_) {
+    case '{':
+    case '[': {
+      const bool object = *p_ == '{';
+      if (depth_ >= limits_.max_depth || depth_ >= 32) {
+        return JsonError::kTooDeep;
+      }
+      ++p_;
+      if (object) {
+        is_object_ |= 1u << depth_;
+      } else {
+        is_object_ &= ~(1u << depth_);
+      }
+      ++depth_;
+      keep_going = object ? visitor_.StartObject() : visitor_.StartArray();
+      state = object ? kExpectKeyOrClose : kExpectValueOrClose;
+      break;
+    }
+    case '"': {
+      auto raw = ScanString();
+      if (!raw) return JsonError::kSyntax;
+      keep_going = visitor_.String(*raw);
+      state = kAfterValue;
+      break;
+    }
+    case 't':
+    case 'f': {
+      const bool value = *p_ == 't';
+      if (!ScanLiteral(value ? "true" : "false")) return JsonError::kSyntax;
+      keep_going = visitor_.Bool(value);
+      state = kAfterValue;
+      break;
+    }
+    case 'n':
+      if (!ScanLiteral("null")) return JsonError::kSyntax;
+      keep_going = visitor_.Null();
+      state = kAfterValue;
+      break;
+    default: {
+      auto text = ScanNumber();
+      if (!text) return JsonError::kSyntax;
+      keep_going = visitor_.Number(*text);
+      state = kAfterValue;
+      break;
+    }
+  }
+  return keep_going ? JsonError::kOk : JsonError::kStopped;
+}
+
+JsonError Tokenizer::Close(bool object) {
+  if (depth_ == 0) return JsonError::kSyntax;
+  const bool top_is_object = is_object_ & (1u << (depth_ - 1));
+  if (top_is_object != object) return JsonError::kSyntax;
+  ++p_;
+  --depth_;
+  const bool keep_going = object ? visitor_.EndObject() : visitor_.EndArray();
+  return keep_going ? JsonError::kOk : JsonError::kStopped;
+}
+
+JsonError Tokenizer::Run() {
+  State state = kExpectValue;
+  while (true) {
+    SkipWhitespace();
+    if (p_ == end_) {
+      return state == kAfterValue && depth_ == 0 ? JsonError::kOk
+                                                 : JsonError::kSyntax;
+    }
+
+    JsonError err = JsonError::kOk;
+    switch (state) {
+      case kExpectKeyOrClose:
+        if (*p_ == '}') {
+          err = Close(/*object=*/true);
+          state = kAfterValue;
+          break;
+        }
+        [[fallthrough]];
+      case kExpectKey: {
+        if (*p_ != '"') return JsonError::kSyntax;
+        if (!CountToken()) return JsonError::kTooManyTokens;
+        auto raw = ScanString();
+        if (!raw) return JsonError::kSyntax;
+        if (!visitor_.Key(*raw)) return JsonError::kStopped;
+        SkipWhitespace();
+        if (p_ == end_ || *p_ != ':') return JsonError::kSyntax;
+        ++p_;
+        state = kExpectValue;
+        break;
+      }
+      case kExpectValueOrClose:
+        if (*p_ == ']') {
+          err = Close(/*object=*/false);
+          state = kAfterValue;
+          break;
+        }
+        [[fallthrough]];
+      case kExpectValue:
+        err = StartValue(state);
+        break;
+      case kAfterValue:
+        // Anything but whitespace after a complete document is an error.
+        if (depth_ == 0) return JsonError::kSyntax;
+        if (*p_ == ',') {
+          ++p_;
+          state = is_object_ & (1u << (depth_ - 1)) ? kExpectKey : kExpectValue;
+        } else if (*p_ == '}' || *p_ == ']') {
+          err = Close(*p_ == '}');
+        } else {
+          return JsonError::kSyntax;
+        }
+        break;
+    }
+    if (err != JsonError::kOk) return err;
+  }
+}
+
+// Collects the scalar members of a flat object, plus the members of objects
+// nested one level down. Subclasses see each member with the key of its
+// enclosing object, if any.
+class MemberVisitor : public JsonVisitor {
+ public:
+  bool StartObject() override {
+    ++depth_;
+    if (depth_ == 2) parent_ = key_;
+    return depth_ <= 2;
+  }
+  bool EndObject() override {
+    if (depth_ == 2) parent_ = {};
+    --depth_;
+    return true;
+  }
+  // Arrays are not used by any of the schemas we decode.
+  bool StartArray() override { return false; }
+  bool Key(std::string_view raw) override {
+    key_ = raw;
+    return true;
+  }
+  // Scalars at depth 0 mean that the document isn't an object.
+  bool String(std::string_view raw) override {
+    return depth_ > 0 && Member(parent_, key_, Value{.text = raw});
+  }
+  bool Number(std::string_view text) override {
+    return depth_ > 0 &&
+           Member(parent_, key_, Value{.text = text, .is_number = true});
+  }
+  bool Bool(bool value) override {
+    return depth_ > 0 && Member(parent_, key_, Value{.boolean = value});
+  }
+  bool Null() override { return depth_ > 0; }
+
+ protected:
+  struct Value {
+    std::string_view text = {};
+    bool is_number = false;
+    std::optional<bool> boolean = std::nullopt;
+
+    std::optional<float> AsFloat() const {
+      return is_number ? JsonToFloat(text) : std::nullopt;
+    }
+    std::optional<int32_t> AsInt() const {
+      return is_number ? JsonToInt(text) : std::nullopt;
+    }
+  };
+
+  // Returns false if the document doesn't match the schema.
+  virtual bool Member(
+      std::string_view parent, std::string_view key, const Value& value) = 0;
+
+ private:
+  int depth_ = 0;
+  std::string_view parent_;
+  std::string_view key_;
+};
+
+class LightVisitor : public MemberVisitor {
+ public:
+  LightCommand command;
+
+ protected:
+  bool Member(
+      std::string_view parent, std::string_view key,
+      const Value& value) override {
+    if (parent.empty()) {
+      if (key == "state") {
+        if (value.text == "ON") {
+          command.state = true;
+        } else if (value.text == "OFF") {
+          command.state = false;
+        } else {
+          return false;
+        }
+      } else if (key == "brightness") {
+        command.brightness = value.AsInt();
+        return command.brightness.has_value();
+      } else if (key == "color_temp") {
+        command.color_temp = value.AsInt();
+        return command.color_temp.has_value();
+      } else if (key == "transition") {
+        command.transition = value.AsFloat();
+        return command.transition.has_value();
+      } else if (key == "effect") {
+        command.effect = value.text;
+      }
+      return true;
+    }
+    if (parent != "color") return true;
+
+    if (key == "r" || key == "g" || key == "b") {
+      auto v = value.AsInt();
+      if (!v || *v < 0 || *v > 255) return false;
+      if (!command.rgb) command.rgb.emplace();
+      uint8_t& channel = key == "r"   ? command.rgb->r
+                         : key == "g" ? command.rgb->g
+                                      : command.rgb->b;
+      channel = *v;
+    } else if (key == "h" || key == "s") {
+      auto v = value.AsFloat();
+      if (!v) return false;
+      if (!command.hs) command.hs.emplace();
+      (key == "h" ? command.hs->h : command.hs->s) = *v;
+    }
+    return true;
+  }
+};
+
+class NumberVisitor : public MemberVisitor {
+ public:
+  std::optional<float> value;
+
+ protected:
+  bool Member(
+      std::string_view parent, std::string_view key,
+      const Value& v) override {
+    if (parent.empty() && key == "value") {
+      value = v.AsFloat();
+      return value.has_value();
+    }
+    return true;
+  }
+};
+
+class ClimateVisitor : public MemberVisitor {
+ public:
+  ClimateCommand command;
+
+ protected:
+  bool Member(
+      std::string_view parent, std::string_view key,
+      const Value& value) override {
+    if (!parent.empty()) return true;
+    std::optional<float>* number = nullptr;
+    if (key == "mode") {
+      command.mode = value.text;
+    } else if (key == "fan_mode") {
+      command.fan_mode = value.text;
+    } else if (key == "preset_mode") {
+      command.preset_mode = value.text;
+    } else if (key == "temperature") {
+      number = &command.temperature;
+    } else if (key == "target_temp_low") {
+      number = &command.target_temp_low;
+    } else if (key == "target_temp_high") {
+      number = &command.target_temp_high;
+    }
+    if (number == nullptr) return true;
+    *number = value.AsFloat();
+    return number->has_value();
+  }
+};
+
+// Parses payload with visitor. MemberVisitor rejects anything but an object.
+bool DecodeObject(std::string_view payload, MemberVisitor& visitor) {
+  return ParseJson(payload, visitor) == JsonError::kOk;
+}
+
+}  // namespace
+
+const char* JsonErrorString(JsonError error) {
+  switch (error) {
+    case JsonError::kOk:
+      return "ok";
+    case JsonError::kSyntax:
+      return "syntax error";
+    case JsonError::kTooManyTokens:
+      return "too many tokens";
+    case JsonError::kTooDeep:
+      return "nested too deeply";
+    case JsonError::kStopped:
+      return "stopped";
+  }
+  return "unknown";
+}
+
+JsonError ParseJson(
+    std::string_view json, JsonVisitor& visitor, JsonLimits limits) {
+  return Tokenizer(json, visitor, limits).Run();
+}
+
+std::optional<std::string_view> JsonUnescape(
+    std::string_view raw, std::span<char> out) {
+  size_t n = 0;
+  auto put = [&](char c) {
+    if (n == out.size()) return false;
+    out[n++] = c;
+    return true;
+  };
+  for (size_t i = 0; i < raw.size(); ++i) {
+    char c = raw[i];
+    if (c != '\\') {
+      if (!put(c)) return std::nullopt;
+      continue;
+    }
+    if (++i == raw.size()) return std::nullopt;
+    switch (raw[i]) {
+      case 'b':
+        c = '\b';
+        break;
+      case 'f':
+        c = '\f';
+        break;
+      case 'n':
+        c = '\n';
+        break;
+      case 'r':
+        c = '\r';
+        break;
+      case 't':
+        c = '\t';
+        break;
+      case 'u': {
+        auto read_hex4 = [&](size_t at) -> int32_t {
+          if (at + 4 > raw.size()) return -1;
+          int32_t v = 0;
+          for (size_t k = at; k < at + 4; ++k) {
+            const int h = HexValue(raw[k]);
+            if (h < 0) return -1;
+            v = v << 4 | h;
+          }
+          return v;
+        };
+        int32_t cp = read_hex4(i + 1);
+        if (cp < 0) return std::nullopt;
+        i += 4;
+        if (cp >= 0xd800 && cp <= 0xdbff) {
+          // A high surrogate must be followed by an escaped low surrogate.
+          if (i + 2 >= raw.size() || raw[i + 1] != '\\' || raw[i + 2] != 'u') {
+            return std::nullopt;
+          }
+          const int32_t low = read_hex4(i + 3);
+          if (low < 0xdc00 || low > 0xdfff) return std::nullopt;
+          cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+          i += 6;
+        } else if (cp >= 0xdc00 && cp <= 0xdfff) {
+          // So must a low one be preceded by a high one.
+          return std::nullopt;
+        }
+        bool ok;
+        if (cp < 0x80) {
+          ok = put(cp);
+        } else if (cp < 0x800) {
+          ok = put(0xc0 | cp >> 6) && put(0x80 | (cp & 0x3f));
+        } else if (cp < 0x10000) {
+          ok = put(0xe0 | cp >> 12) && put(0x80 | (cp >> 6 & 0x3f)) &&
+               put(0x80 | (cp & 0x3f));
+        } else {
+          ok = put(0xf0 | cp >> 18) && put(0x80 | (cp >> 12 & 0x3f)) &&
+               put(0x80 | (cp >> 6 & 0x3f)) && put(0x80 | (cp & 0x3f));
+        }
+        if (!ok) return std::nullopt;
+        continue;
+      }
+      case '"':
+      case '\\':
+      case '/':
+        c = raw[i];
+        break;
+      default:
+        return std::nullopt;
+    }
+    if (!put(c)) return std::nullopt;
+  }
+  return std::string_view(out.data(), n);
+}
+
+std::optional<int32_t> JsonToInt(std::string_view text) {
+  int32_t v;
+  auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), v);
+  if (ec != std::errc() || end != text.data() + text.size()) {
+    return std::nullopt;
+  }
+  return v;
+}
+
+std::optional<float> JsonToFloat(std::string_view text) {
+  float v;
+  auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), v);
+  // from_chars also reads "nan" and "inf", which are not JSON numbers.
+  if (ec != std::errc() || end != text.data() + text.size() ||
+      !std::isfinite(v)) {
+    return std::nullopt;
+  }
+  return v;
+}
+
+std::optional<LightCommand> DecodeLightCommand(std::string_view payload) {
+  LightVisitor visitor;
+  if (!DecodeObject(payload, visitor)) return std::nullopt;
+  return visitor.command;
+}
+
+std::optional<float> DecodeNumberCommand(std::string_view payload) {
+  // Trim, so that a bare number with surrounding whitespace is accepted.
+  while (!payload.empty() && IsWhitespace(payload.front())) {
+    payload.remove_prefix(1);
+  }
+  while (!payload.empty() && IsWhitespace(payload.back())) {
+    payload.remove_suffix(1);
+  }
+  if (!payload.empty() && payload.front() != '{') return JsonToFloat(payload);
+
+  NumberVisitor visitor;
+  if (!DecodeObject(payload, visitor)) return std::nullopt;
+  return visitor.value;
+}
+
+std::optional<ClimateCommand> DecodeClimateCommand(std::string_view payload) {
+  ClimateVisitor visitor;
+  if (!DecodeObject(payload, visitor)) return std::nullopt;
+  return visitor.command;
+}
+
+}  // namespace homeassistant
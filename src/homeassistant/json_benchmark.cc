@@ -0,0 +1,70 @@
+// Measures how many typical Home Assistant command payloads per second the
+// JSON decoders handle. Builds for the device or, with PICO_PLATFORM=host,
+// for the host.
+
+#include <cstdint>
+#include <string_view>
+
+#include "homeassistant/json.h"
+#include "pico/printf.h"
+#include "pico/stdio.h"
+#include "pico/time.h"
+
+using namespace homeassistant;
+
+namespace {
+
+constexpr std::string_view kLightPayload =
+    R"({"state": "ON", "brightness": 200, "color": {"r": 255, "g": 128, )"
+    R"("b": 0}, "transition": 2})";
+constexpr std::string_view kLightOffPayload = R"({"state": "OFF"})";
+constexpr std::string_view kNumberPayload = "42.5";
+constexpr std::string_view kClimatePayload =
+    R"({"mode": "heat", "temperature": 21.5})";
+
+// Keeps the optimizer from discarding the decode.
+volatile int g_sink;
+
+template <typename F>
+void Run(const char* name, std::string_view payload, int iterations, F f) {
+  const uint64_t start = time_us_64();
+  for (int i = 0; i < iterations; ++i) {
+    g_sink = g_sink + f(payload);
+  }
+  const uint64_t elapsed_us = time_us_64() - start;
+  const uint64_t per_second =
+      elapsed_us == 0 ? 0 : iterations * UINT64_C(1000000) / elapsed_us;
+  printf(
+      "%-10s %3u bytes: %8llu msgs/s, %6.2f MB/s\n",
+      name,
+      static_cast<unsigned>(payload.size()),
+      per_second,
+      static_cast<double>(per_second) * payload.size() / 1e6);
+}
+
+}  // namespace
+
+int main() {
+  stdio_init_all();
+
+  constexpr int kIterations = PICO_ON_DEVICE ? 20'000 : 2'000'000;
+  Run("light", kLightPayload, kIterations, [](std::string_view p) {
+    return DecodeLightCommand(p)->brightness.value_or(0);
+  });
+  Run("light_off", kLightOffPayload, kIterations, [](std::string_view p) {
+    return DecodeLightCommand(p)->state.value_or(false) ? 1 : 0;
+  });
+  Run("number", kNumberPayload, kIterations, [](std::string_view p) {
+    return static_cast<int>(DecodeNumberCommand(p).value_or(0));
+  });
+  Run("climate", kClimatePayload, kIterations, [](std::string_view p) {
+    return static_cast<int>(DecodeClimateCommand(p)->temperature.value_or(0));
+  });
+
+  // Tokenizing alone, without decoding into a struct.
+  Run("tokenize", kLightPayload, kIterations, [](std::string_view p) {
+    JsonVisitor visitor;
+    return static_cast<int>(ParseJson(p, visitor));
+  });
+  printf("DONE\n");
+}
@@ -0,0 +1,161 @@
+#include "homeassistant/json.h"
+
+#include <array>
+#include <string>
+#include <string_view>
+
+#include "pico/platform.h"
+#include "pico/printf.h"
+#include "pico/stdio.h"
+#include "util/expect.h"
+
+using namespace homeassistant;
+using jagspico::Expect;
+
+// Renders the token stream so it can be compared against a string.
+class RecordingVisitor : public JsonVisitor {
+ public:
+  bool StartObject() override { return Add("{"); }
+  bool EndObject() override { return Add("}"); }
+  bool StartArray() override { return Add("["); }
+  bool EndArray() override { return Add("]"); }
+  bool Key(std::string_view raw) override { return Add("k:", raw); }
+  bool String(std::string_view raw) override { return Add("s:", raw); }
+  bool Number(std::string_view text) override { return Add("n:", text); }
+  bool Bool(bool value) override { return Add(value ? "true" : "false"); }
+  bool Null() override { return Add("null"); }
+
+  std::string tokens;
+
+ private:
+  bool Add(std::string_view kind, std::string_view text = {}) {
+    if (!tokens.empty()) tokens.append(" ");
+    tokens.append(kind);
+    tokens.append(text);
+    return true;
+  }
+};
+
+static void ExpectTokens(std::string_view json, std::string_view want) {
+  RecordingVisitor visitor;
+  const JsonError err = ParseJson(json, visitor);
+  if (err != JsonError::kOk) {
+    panic(
+        "FAIL: %.*s: %s",
+        static_cast<int>(json.size()),
+        json.data(),
+        JsonErrorString(err));
+  }
+  if (visitor.tokens != want) {
+    panic(
+        "FAIL: %.*s: want %.*s got %s",
+        static_cast<int>(json.size()),
+        json.data(),
+        static_cast<int>(want.size()),
+        want.data(),
+        visitor.tokens.c_str());
+  }
+}
+
+static void ExpectError(
+    std::string_view json, JsonError want, JsonLimits limits = {}) {
+  JsonVisitor visitor;
+  const JsonError err = ParseJson(json, visitor, limits);
+  if (err != want) {
+    panic(
+        "FAIL: %.*s: want %s got %s",
+        static_cast<int>(json.size()),
+        json.data(),
+        JsonErrorString(want),
+        JsonErrorString(err));
+  }
+}
+
+int main() {
+  stdio_init_all();
+
+  ExpectTokens("  42 ", "n:42");
+  ExpectTokens("-0.5e+3", "n:-0.5e+3");
+  ExpectTokens(R"("a\"b")", R"(s:a\"b)");
+  ExpectTokens(R"("\u00e9\ud83d\ude00")", R"(s:\u00e9\ud83d\ude00)");
+  ExpectTokens("[]", "[ ]");
+  ExpectTokens("{}", "{ }");
+  ExpectTokens(
+      R"({"a": [1, true, null], "b": {"c": "d"}})",
+      "{ k:a [ n:1 true null ] k:b { k:c s:d } }");
+
+  ExpectError("", JsonError::kSyntax);
+  ExpectError("{", JsonError::kSyntax);
+  ExpectError("[1,]", JsonError::kSyntax);
+  ExpectError(R"({"a" 1})", JsonError::kSyntax);
+  ExpectError(R"({"a": 1,})", JsonError::kSyntax);
+  ExpectError("[1}", JsonError::kSyntax);
+  ExpectError("01", JsonError::kSyntax);
+  ExpectError("1.", JsonError::kSyntax);
+  ExpectError("tru", JsonError::kSyntax);
+  ExpectError("1 2", JsonError::kSyntax);
+  ExpectError(R"("\x")", JsonError::kSyntax);
+  ExpectError(R"("\u12")", JsonError::kSyntax);
+  ExpectError("\"a\nb\"", JsonError::kSyntax);
+  ExpectError("[[[]]]", JsonError::kTooDeep, {.max_depth = 2});
+  ExpectError("[1, 2, 3]", JsonError::kTooManyTokens, {.max_tokens = 3});
+
+  std::array<char, 16> buf;
+  auto unescaped = JsonUnescape(R"(a\né😀)", buf);
+  Expect(
+      unescaped == std::string_view("a\n\xc3\xa9\xf0\x9f\x98\x80"),
+      "unescape");
+  unescaped = JsonUnescape(R"(\u00e9)", buf);
+  Expect(unescaped == std::string_view("\xc3\xa9"), "unescape \\u00e9");
+  unescaped = JsonUnescape(R"(\ud83d\ude00)", buf);
+  Expect(
+      unescaped == std::string_view("\xf0\x9f\x98\x80"),
+      "unescape surrogate pair");
+  Expect(!JsonUnescape(R"(\ud83d)", buf), "unescape lone high surrogate");
+  Expect(!JsonUnescape(R"(\ud83dx)", buf), "unescape unpaired surrogate");
+  Expect(!JsonUnescape(R"(\ude00)", buf), "unescape lone low surrogate");
+  Expect(!JsonUnescape(R"(\u12)", buf), "unescape short \\u");
+  unescaped = JsonUnescape(R"(\"\\\/)", buf);
+  Expect(unescaped == std::string_view("\"\\/"), "unescape \\\", \\\\ and \\/");
+  Expect(!JsonUnescape(R"(\x41)", buf), "unescape unknown escape");
+  Expect(
+      !JsonUnescape("0123456789abcdefg", buf), "unescape out of space");
+
+  auto light = DecodeLightCommand(
+      R"({"state": "ON", "brightness": 128, "color": {"r": 255, "g": 10, )"
+      R"("b": 0}, "transition": 1.5, "effect": "rainbow"})");
+  Expect(light.has_value(), "light decodes");
+  Expect(light->state == true, "light state");
+  Expect(light->brightness == 128, "light brightness");
+  Expect(light->rgb && light->rgb->r == 255 && light->rgb->g == 10 &&
+             light->rgb->b == 0,
+         "light rgb");
+  Expect(light->transition == 1.5f, "light transition");
+  Expect(light->effect == "rainbow", "light effect");
+  Expect(!light->color_temp && !light->hs, "light unset fields");
+
+  light = DecodeLightCommand(R"({"state": "OFF"})");
+  Expect(light && light->state == false && !light->brightness, "light off");
+  Expect(!DecodeLightCommand(R"({"state": "MAYBE"})"), "light bad state");
+  Expect(!DecodeLightCommand(R"({"color": {"r": 256}})"), "light bad rgb");
+  Expect(!DecodeLightCommand("[1]"), "light not an object");
+  Expect(!DecodeLightCommand("ON"), "light not json");
+
+  Expect(DecodeNumberCommand("21.5") == 21.5f, "number plain");
+  Expect(DecodeNumberCommand(" -3 ") == -3.0f, "number whitespace");
+  Expect(DecodeNumberCommand(R"({"value": 7})") == 7.0f, "number json");
+  Expect(!DecodeNumberCommand("abc"), "number garbage");
+  Expect(!DecodeNumberCommand("nan"), "number nan");
+  Expect(!DecodeNumberCommand("-inf"), "number inf");
+  Expect(!DecodeNumberCommand("1e39"), "number out of range");
+
+  auto climate = DecodeClimateCommand(
+      R"({"mode": "heat", "temperature": 21.5, "fan_mode": "auto"})");
+  Expect(climate.has_value(), "climate decodes");
+  Expect(climate->mode == "heat", "climate mode");
+  Expect(climate->temperature == 21.5f, "climate temperature");
+  Expect(climate->fan_mode == "auto", "climate fan mode");
+  Expect(!climate->target_temp_low, "climate unset fields");
+
+  printf("PASS\n");
+}
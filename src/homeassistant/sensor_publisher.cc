@@ -0,0 +1,164 @@
+#include "homeassistant/sensor_publisher.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace homeassistant {
+
+std::optional<std::string_view> SensorPublisher::AddSample(
+    float value, TickType_t now) {
+  if (std::isnan(value)) return Poll(now);
+
+  // The sample that arrives after the window expired belongs to the next
+  // window.
+  std::optional<std::string_view> payload;
+  if (window_open_ && now - window_start_ >= options_.window) {
+    payload = CloseWindow(now);
+  }
+
+  if (!window_open_) {
+    window_open_ = true;
+    window_start_ = now;
+    min_ = max_ = value;
+    sum_ = 0;
+    count_ = 0;
+  }
+  min_ = std::min(min_, value);
+  max_ = std::max(max_, value);
+  sum_ += value;
+  last_ = value;
+  ++count_;
+
+  if (payload) return payload;
+  // Let the very first sample through, so the sensor has a state as soon as
+  // possible.
+  if (!last_published_) return CloseWindow(now);
+  return PublishPending(now);
+}
+
+std::optional<std::string_view> SensorPublisher::Poll(TickType_t now) {
+  if (window_open_ && now - window_start_ >= options_.window) {
+    return CloseWindow(now);
+  }
+  if (auto payload = PublishPending(now)) return payload;
+  if (last_published_ && now - last_publish_time_ >= options_.max_interval) {
+    last_publish_time_ = now;
+    return Format(*last_published_);
+  }
+  return std::nullopt;
+}
+
+float SensorPublisher::Select(const WindowStats& stats) const {
+  switch (options_.statistic) {
+    case Statistic::kLast:
+      return stats.last;
+    case Statistic::kMean:
+      return stats.mean;
+    case Statistic::kMin:
+      return stats.min;
+    case Statistic::kMax:
+      return stats.max;
+  }
+  return stats.last;
+}
+
+std::optional<std::string_view> SensorPublisher::CloseWindow(TickType_t now) {
+  window_open_ = false;
+  const WindowStats stats{
+      .min = min_,
+      .max = max_,
+      .mean = sum_ / count_,
+      .last = last_,
+      .count = count_,
+  };
+
+  // This window supersedes any that is held, whether it moved or not.
+  pending_.reset();
+  if (last_published_) {
+    const TickType_t since_publish = now - last_publish_time_;
+    const bool moved = std::fabs(Select(stats) - Select(*last_published_)) >
+                       options_.deadband;
+    const bool overdue = since_publish >= options_.max_interval;
+    const bool too_soon = since_publish < options_.min_interval;
+    if (!overdue && !moved) return std::nullopt;
+    if (!overdue && too_soon) {
+      pending_ = stats;
+      return std::nullopt;
+    }
+  }
+  return Publish(stats, now);
+}
+
+std::optional<std::string_view> SensorPublisher::PublishPending(
+    TickType_t now) {
+  if (!pending_ || now - last_publish_time_ < options_.min_interval) {
+    return std::nullopt;
+  }
+  const WindowStats stats = *pending_;
+  pending_.reset();
+  return Publish(stats, now);
+}
+
+std::string_view SensorPublisher::Publish(
+    const WindowStats& stats, TickType_t now) {
+  last_published_ = stats;
+  last_publish_time_ = now;
+  return Format(stats);
+}
+
+std::string_view SensorPublisher::Format(const WindowStats& stats) {
+  const int p = options_.precision;
+  const int len = snprintf(
+      payload_.data(),
+      payload_.size(),
+      "{\"value\":%.*f,\"min\":%.*f,\"max\":%.*f,\"mean\":%.*f,\"last\":%.*f,"
+      "\"n\":%d}",
+      p,
+      static_cast<double>(Select(stats)),
+      p,
+      static_cast<double>(stats.min),
+      p,
+      static_cast<double>(stats.max),
+      p,
+      static_cast<double>(stats.mean),
+      p,
+      static_cast<double>(stats.last),
+      stats.count);
+  if (len < 0 || static_cast<size_t>(len) >= payload_.size()) {
+    panic(
+        "sensor payload does not fit in %d bytes\n",
+        static_cast<int>(payload_.size()));
+  }
+  return std::string_view(payload_.data(), len);
+}
+
+void AddSamples(
+    freertosxx::Executor& executor, std::span<SensorPublisher> publishers,
+    std::span<const float> samples, TickType_t now,
+    const std::function<void(size_t, std::string_view)>& publish) {
+  configASSERT(publishers.size() == samples.size());
+  // Each publisher is only touched by the runner that has its index, so the
+  // publishers need no locking.
+  executor.ParallelFor(publishers.size(), 1, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      if (auto payload = publishers[i].AddSample(samples[i], now)) {
+        publish(i, *payload);
+      }
+    }
+  });
+}
+
+void AddAggregatedSensorInfo(
+    const CommonDeviceInfo& info,
+    std::optional<std::string_view> unit_of_measurement, JsonBuilder& builder) {
+  builder.Kv("state_topic", RelativeChannel(topic_suffix::kState));
+  builder.Kv("value_template", "{{ value_json.value }}");
+  builder.Kv("json_attributes_topic", RelativeChannel(topic_suffix::kState));
+  if (unit_of_measurement) {
+    builder.Kv("unit_of_measurement", *unit_of_measurement);
+  }
+  builder.Kv("state_class", "measurement");
+}
+
+}  // namespace homeassistant
@@ -0,0 +1,112 @@
+#include "homeassistant/sensor_publisher.h"
+
+#include <string_view>
+
+#include "pico/printf.h"
+#include "pico/stdio.h"
+
+using homeassistant::SensorPublisher;
+
+static void ExpectPayload(
+    const std::optional<std::string_view>& got, std::string_view want,
+    int line) {
+  if (!got) {
+    panic(
+        "FAIL line %d: want %.*s got nothing",
+        line,
+        static_cast<int>(want.size()),
+        want.data());
+  }
+  if (*got != want) {
+    panic(
+        "FAIL line %d: want %.*s got %.*s",
+        line,
+        static_cast<int>(want.size()),
+        want.data(),
+        static_cast<int>(got->size()),
+        got->data());
+  }
+}
+
+static void ExpectNothing(
+    const std::optional<std::string_view>& got, int line) {
+  if (got) {
+    panic(
+        "FAIL line %d: want nothing got %.*s",
+        line,
+        static_cast<int>(got->size()),
+        got->data());
+  }
+}
+
+int main() {
+  stdio_init_all();
+
+  SensorPublisher publisher({
+      .deadband = 0.5f,
+      .window = 100,
+      .min_interval = 300,
+      .max_interval = 1000,
+      .precision = 1,
+  });
+
+  // The first sample is published right away.
+  ExpectPayload(
+      publisher.AddSample(20.0f, 0),
+      R"({"value":20.0,"min":20.0,"max":20.0,"mean":20.0,"last":20.0,"n":1})",
+      __LINE__);
+
+  // Samples inside the deadband are aggregated but not published.
+  ExpectNothing(publisher.AddSample(20.2f, 10), __LINE__);
+  ExpectNothing(publisher.AddSample(19.8f, 50), __LINE__);
+  ExpectNothing(publisher.AddSample(20.0f, 150), __LINE__);
+
+  // The mean moves past the deadband, but min_interval has not passed yet.
+  ExpectNothing(publisher.AddSample(25.0f, 160), __LINE__);
+  ExpectNothing(publisher.AddSample(25.0f, 170), __LINE__);
+
+  // That window is held when it closes, and the one after it closes after
+  // min_interval has passed, and takes its place.
+  ExpectNothing(publisher.AddSample(23.0f, 260), __LINE__);
+  ExpectPayload(
+      publisher.Poll(360),
+      R"({"value":23.0,"min":23.0,"max":23.0,"mean":23.0,"last":23.0,"n":1})",
+      __LINE__);
+
+  // Aggregates cover the whole window.
+  ExpectNothing(publisher.AddSample(30.0f, 600), __LINE__);
+  ExpectNothing(publisher.AddSample(20.0f, 620), __LINE__);
+  ExpectNothing(publisher.AddSample(28.0f, 640), __LINE__);
+  ExpectPayload(
+      publisher.AddSample(0.0f, 700),
+      R"({"value":26.0,"min":20.0,"max":30.0,"mean":26.0,"last":28.0,"n":3})",
+      __LINE__);
+
+  // NaN is ignored.
+  ExpectNothing(publisher.AddSample(__builtin_nanf(""), 710), __LINE__);
+
+  // The window of 0.0 moved, but closes before min_interval has passed. It
+  // is held, and published once min_interval has passed.
+  ExpectNothing(publisher.Poll(800), __LINE__);
+  ExpectNothing(publisher.Poll(999), __LINE__);
+  ExpectPayload(
+      publisher.Poll(1000),
+      R"({"value":0.0,"min":0.0,"max":0.0,"mean":0.0,"last":0.0,"n":1})",
+      __LINE__);
+
+  // A held window is dropped if the next one moves back.
+  ExpectNothing(publisher.AddSample(5.0f, 1050), __LINE__);
+  ExpectNothing(publisher.Poll(1150), __LINE__);
+  ExpectNothing(publisher.AddSample(0.2f, 1160), __LINE__);
+  ExpectNothing(publisher.Poll(1260), __LINE__);
+  ExpectNothing(publisher.AddSample(0.2f, 1300), __LINE__);
+
+  // Nothing moved, but max_interval forces a publish of the last state.
+  ExpectNothing(publisher.Poll(1999), __LINE__);
+  ExpectPayload(
+      publisher.Poll(2000),
+      R"({"value":0.0,"min":0.0,"max":0.0,"mean":0.0,"last":0.0,"n":1})",
+      __LINE__);
+
+  printf("PASS\n");
+}
@@ -1,6 +1,8 @@
 #include <cstdio>
 
 #include "freertosxx/mutex.h"
+#include "homeassistant/device.h"
+#include "homeassistant/entities.h"
 #include "homeassistant/homeassistant.h"
 #include "lwipxx/mqtt.h"
 #include "pico/time.h"
@@ -13,12 +15,49 @@ extern "C" void main_task(void* arg) {
   device_info.component = "cover";
   device_info.device_class = "awning";
 
-  JsonBuilder b;
-  AddCommonInfo(device_info, b);
-  AddCoverInfo(device_info, b);
-  AddAvailabilityDiscovery(b);
-  std::string discovery_message = std::move(b).Finish();
-  printf("%s\n", discovery_message.c_str());
+  Device device({.name = "test_device_name", .model = "pico_w"});
+  Entity& cover = device.AddEntity(device_info, AddCoverInfo);
+  printf("%s\n", cover.discovery_message().c_str());
+
+  CommonDeviceInfo switch_info("test_device_switch");
+  switch_info.component = "switch";
+  Entity& switch_entity = device.AddEntity(switch_info, AddSwitchInfo);
+
+  CommonDeviceInfo binary_sensor_info("test_device_binary_sensor");
+  binary_sensor_info.component = "binary_sensor";
+  binary_sensor_info.device_class = "motion";
+  Entity& binary_sensor =
+      device.AddEntity(binary_sensor_info, AddBinarySensorInfo);
+
+  CommonDeviceInfo number_info("test_device_number");
+  number_info.component = "number";
+  Entity& number = device.AddEntity(
+      number_info, [](const CommonDeviceInfo& info, JsonBuilder& b) {
+        AddNumberInfo(info, {.min = 0, .max = 10, .step = 0.5f}, b);
+      });
+
+  CommonDeviceInfo light_info("test_device_light");
+  light_info.component = "light";
+  static constexpr std::string_view kColorModes[] = {"rgb"};
+  Entity& light = device.AddEntity(
+      light_info, [](const CommonDeviceInfo& info, JsonBuilder& b) {
+        AddLightInfo(info, {.color_modes = kColorModes}, b);
+      });
+
+  // A handful of extra entities to exercise batched discovery.
+  std::vector<std::string> sensor_ids;
+  for (int i = 0; i < 8; ++i) {
+    sensor_ids.push_back(jagspico::ssprintf("test_device_sensor%d", i));
+  }
+  for (const std::string& id : sensor_ids) {
+    CommonDeviceInfo sensor_info(id);
+    sensor_info.component = "sensor";
+    sensor_info.device_class = "temperature";
+    device.AddEntity(
+        sensor_info, [](const CommonDeviceInfo& info, JsonBuilder& b) {
+          AddSensorInfo(info, "°C", b);
+        });
+  }
 
   lwipxx::MqttClient::ConnectInfo connect_info{
       .broker_address = std::string(MQTT_HOST),
@@ -37,20 +76,56 @@ extern "C" void main_task(void* arg) {
   }
   lwipxx::MqttClient& mqtt_client = **maybe_mqtt_client;
 
-  auto message_handler = [&](const lwipxx::MqttClient::Message& msg) {
-    if (msg.data == cover_payloads::kOpenCommand) {
-      printf("received open\n");
-    } else if (msg.data == cover_payloads::kCloseCommand) {
-      printf("received close\n");
-    } else if (msg.data == cover_payloads::kStopCommand) {
-      printf("received stop\n");
+  auto cover_handler = CoverCommandHandler([](CoverCommand command) {
+    switch (command) {
+      case CoverCommand::kOpen:
+        printf("received open\n");
+        break;
+      case CoverCommand::kClose:
+        printf("received close\n");
+        break;
+      case CoverCommand::kStop:
+        printf("received stop\n");
+        break;
     }
-  };
+  });
+  if (ERR_OK != mqtt_client.Subscribe(
+                    cover.command_topic(),
+                    lwipxx::MqttClient::kAtLeastOnce,
+                    cover_handler)) {
+    panic("subscribe error\n");
+  }
 
-  std::string cmd_chan = AbsoluteChannel(device_info, topic_suffix::kCommand);
-  if (ERR_OK !=
-      mqtt_client.Subscribe(
-          cmd_chan, lwipxx::MqttClient::kAtLeastOnce, message_handler)) {
+  // Commands are echoed back as state, as a real device would once it has
+  // acted on them.
+  auto switch_handler = SwitchCommandHandler([&](bool on) {
+    printf("received switch %s\n", on ? "on" : "off");
+    device.PublishState(mqtt_client, switch_entity, SwitchState(on));
+  });
+  auto number_handler = NumberCommandHandler([&](float value) {
+    printf("received number %f\n", value);
+    device.PublishState(
+        mqtt_client, number, jagspico::ssprintf("%g", value));
+  });
+  auto light_handler = LightCommandHandler([&](const LightCommand& command) {
+    printf(
+        "received light state=%d brightness=%d\n",
+        command.state.value_or(false),
+        command.brightness.value_or(-1));
+    device.PublishState(mqtt_client, light, LightStateMessage(command));
+  });
+  if (ERR_OK != mqtt_client.Subscribe(
+                    switch_entity.command_topic(),
+                    lwipxx::MqttClient::kAtLeastOnce,
+                    switch_handler) ||
+      ERR_OK != mqtt_client.Subscribe(
+                    number.command_topic(),
+                    lwipxx::MqttClient::kAtLeastOnce,
+                    number_handler) ||
+      ERR_OK != mqtt_client.Subscribe(
+                    light.command_topic(),
+                    lwipxx::MqttClient::kAtLeastOnce,
+                    light_handler)) {
     panic("subscribe error\n");
   }
 
@@ -62,15 +137,38 @@ extern "C" void main_task(void* arg) {
   };
 
   PublishAvailable(mqtt_client);
-  PublishDiscovery(mqtt_client, device_info, discovery_message);
+  const uint64_t discovery_start_us = time_us_64();
+  device.PublishDiscovery(
+      mqtt_client,
+      {.on_progress = [](const Device::DiscoveryProgress& progress) {
+        printf(
+            "discovery %d/%d (%d retries)%s\n",
+            progress.published,
+            progress.total,
+            progress.retries,
+            progress.done ? " done" : "");
+      }});
+  device.WaitForDiscovery();
+  printf(
+      "discovery took %llu ms\n", (time_us_64() - discovery_start_us) / 1000);
+
+  if (ERR_OK != device.ListenForBirth(mqtt_client)) {
+    panic("birth subscribe error\n");
+  }
+  printf(
+      "will re-announce %lu ticks after a birth message\n",
+      Device::BirthJitter(pdMS_TO_TICKS(5000)));
 
   // Cycle through the states.
-  std::string state_chan = AbsoluteChannel(device_info, topic_suffix::kState);
+  bool motion = false;
   while (true) {
     for (auto state : states) {
-      if (ERR_OK !=
-          mqtt_client.Publish(
-              state_chan, state, lwipxx::MqttClient::kBestEffort, true)) {
+      if (ERR_OK != device.PublishState(mqtt_client, cover, state)) {
+        printf("publish error\n");
+      }
+      motion = !motion;
+      if (ERR_OK != device.PublishState(
+                        mqtt_client, binary_sensor, BinarySensorState(motion))) {
         printf("publish error\n");
       }
       sleep_ms(5000);
@@ -0,0 +1,51 @@
+#include "homeassistant/topics.h"
+
+#include <cstring>
+#include <initializer_list>
+
+namespace homeassistant {
+
+static constexpr std::string_view kRootPrefix = "homeassistant/";
+
+EntityTopics::EntityTopics(const CommonDeviceInfo& info) {
+  configASSERT(info.component.has_value());
+  const std::string_view component = *info.component;
+  const std::string_view unique_id = info.unique_id;
+  const size_t root_size =
+      kRootPrefix.size() + component.size() + 1 + unique_id.size();
+  const std::string_view suffixes[] = {
+      topic_suffix::kDiscovery, topic_suffix::kState, topic_suffix::kCommand};
+  const std::string_view availability = AvailabilityTopic();
+
+  // Lay out the arena.
+  size_t offset = 0;
+  offsets_[kRoot] = offset;
+  offset += root_size + 1;
+  for (int i = 0; i < 3; ++i) {
+    offsets_[kDiscovery + i] = offset;
+    offset += root_size + 1 + suffixes[i].size() + 1;
+  }
+  offsets_[kAvailability] = offset;
+  offset += availability.size() + 1;
+  offsets_[kNumChannels] = offset;
+  configASSERT(offset <= UINT16_MAX);
+
+  arena_ = std::make_unique_for_overwrite<char[]>(offset);
+  auto append = [](char* out, std::initializer_list<std::string_view> parts) {
+    for (std::string_view part : parts) {
+      std::memcpy(out, part.data(), part.size());
+      out += part.size();
+    }
+    *out = '\0';
+  };
+  char* const root = &arena_[offsets_[kRoot]];
+  append(root, {kRootPrefix, component, "/", unique_id});
+  for (int i = 0; i < 3; ++i) {
+    append(
+        &arena_[offsets_[kDiscovery + i]],
+        {std::string_view(root, root_size), "/", suffixes[i]});
+  }
+  append(&arena_[offsets_[kAvailability]], {availability});
+}
+
+}  // namespace homeassistant
@@ -12,7 +12,9 @@
 #include <variant>
 
 #include "freertosxx/event.h"
+#include "freertosxx/future.h"
 #include "freertosxx/mutex.h"
+#include "freertosxx/timer_wheel.h"
 #include "lwip/apps/mqtt.h"
 #include "lwip/ip_addr.h"
 #include "projdefs.h"
@@ -50,10 +52,24 @@ class MqttClient {
   // the publish to be acknowledged by the broker. You may provide
   // publish_result which will be called with the result of the Publish request.
   // publish_result will only be called when this call returns ERR_OK.
+  //
+  // topic.data() is passed to lwIP as a C string, so a nul must follow the
+  // view, as it does a view of a whole std::string or a string literal. lwIP
+  // copies topic and message, so neither needs to outlive this call.
   [[nodiscard]] err_t Publish(
       std::string_view topic, std::string_view message, Qos qos, bool retain,
       std::function<void(err_t)> publish_result = nullptr);
 
+  // As above, but returns a future of the publish's result, e.g.
+  //
+  //   client->Publish(topic, "on", kAtLeastOnce, true, freertosxx::use_future)
+  //       .Get({.timeout = pdMS_TO_TICKS(1000)});
+  //
+  // If the publish fails before it is sent, the future holds that error.
+  freertosxx::Future<err_t> Publish(
+      std::string_view topic, std::string_view message, Qos qos, bool retain,
+      freertosxx::UseFuture);
+
   struct Message {
     std::string_view topic;
     std::string_view data;
@@ -125,6 +141,8 @@ class MqttClient {
     Qos qos;
     DataHandler handler;
     int failed_requests = 0;
+    // The pending retry of a failed transition, if any.
+    freertosxx::TimerToken retry;
     bool has_pending_callback = false;
     bool want_subscribed = true;
     bool is_subscribed = false;
@@ -133,6 +151,10 @@ class MqttClient {
   MqttClient(ConnectInfo info) : connect_info_(std::move(info)) {}
 
   void Connect();
+  // Schedules Connect after a backoff, on lwIP's timeouts if the timer
+  // wheel is out of nodes. Needs the tcpip core lock.
+  void RetryConnect();
+  static void ConnectTimeout(void* arg);
 
   // Called when the connection status changes.
   void ConnectionCb(const mqtt_connection_status_t& status);
@@ -145,8 +167,21 @@ class MqttClient {
 
   void FinishTransition(Subscription& sub, bool is_subscribe, err_t err);
 
-  // Executes a function *in the tcpip thread* with a delay..
-  void WithBackoff(int& attempt_count, std::function<void()> f);
+  static constexpr int kMinBackoffMs = 250;
+  static constexpr int kMaxBackoffMs = 5000;
+
+  using Retry = void (*)(MqttClient& client, Subscription* sub);
+
+  // Calls retry(*this, sub) holding the tcpip core lock, after a delay that
+  // grows with attempt_count, unless the client has been destroyed by then.
+  // Returns a token that cancels it, or an empty token if the timer wheel is
+  // out of nodes.
+  freertosxx::TimerToken WithBackoff(
+      int& attempt_count, Retry retry, Subscription* sub = nullptr);
+
+  err_t PublishWithCallback(
+      std::string_view topic, std::string_view message, Qos qos, bool retain,
+      std::move_only_function<void(err_t)> publish_result);
 
   void ChangeTopic(std::string_view topic, int num_messages);
   void ReceiveMessage(std::span<const uint8_t> message, uint8_t flags);
@@ -155,6 +190,7 @@ class MqttClient {
       const Subscription& subscription, std::string_view topic);
 
   int connect_failures_ = 0;
+  freertosxx::TimerToken connect_retry_;
   ConnectInfo connect_info_;
 
   std::unique_ptr<mqtt_client_t, decltype(&mqtt_client_free)> client_{
@@ -167,7 +203,9 @@ class MqttClient {
   Subscription* active_subscription_ = nullptr;
   std::string pending_message_;
 
-  bool shutdown_ = false;
+  // Set by the destructor. Shared with pending retries, which may outlive
+  // the client.
+  std::shared_ptr<bool> shutdown_ = std::make_shared<bool>(false);
 };
 
 }  // namespace lwipxx
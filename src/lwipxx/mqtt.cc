@@ -12,16 +12,39 @@
 
 #include "arch/cc.h"
 #include "freertosxx/include/freertosxx/queue.h"
+#include "freertosxx/pool.h"
+#include "freertosxx/timer_wheel.h"
 #include "lwip/api.h"
 #include "lwip/apps/mqtt.h"
 #include "lwip/err.h"
 #include "lwip/ip_addr.h"
+#include "lwip/timeouts.h"
 #include "pico/time.h"
 #include "portmacro.h"
 #include "util/include/util/cleanup.h"
 
 namespace lwipxx {
+using freertosxx::BlockPool;
 using freertosxx::MutexLock;
+using freertosxx::PoolAllocated;
+using freertosxx::PoolSet;
+using freertosxx::TimerToken;
+
+namespace {
+
+// Arguments for lwIP callbacks. Each lives only until its callback
+// runs, and only a few are in flight at once, but they come and go for as
+// long as the client runs, so keep them out of the heap.
+PoolSet<BlockPool<16, 16>, BlockPool<32, 8>> g_callback_pools("mqtt_cb");
+
+// Runs retries as if in the tcpip thread, as lwIP's callbacks are.
+void LockingTcpipCore(std::move_only_function<void()>& fn) {
+  LOCK_TCPIP_CORE();
+  fn();
+  UNLOCK_TCPIP_CORE();
+}
+
+}  // namespace
 
 #define MQTTDBG(...) printf(__VA_ARGS__)
 
@@ -44,12 +67,19 @@ std::expected<std::unique_ptr<MqttClient>, err_t> MqttClient::Create(
 
 MqttClient::~MqttClient() {
   LOCK_TCPIP_CORE();
+  // A retry that the wheel has already started is waiting for the lock we
+  // hold. It sees the flag once we release it and returns without touching
+  // the client.
+  *shutdown_ = true;
+  connect_retry_.Cancel();
+  for (auto& sub : subscriptions_) sub->retry.Cancel();
+  sys_untimeout(&MqttClient::ConnectTimeout, this);
   mqtt_disconnect(client_.get());
   UNLOCK_TCPIP_CORE();
 }
 
 void MqttClient::ConnectionCb(const mqtt_connection_status_t& status) {
-  if (shutdown_) return;
+  if (*shutdown_) return;
   if (status == MQTT_CONNECT_ACCEPTED) {
     mqtt_set_inpub_callback(
         client_.get(),
@@ -75,10 +105,26 @@ void MqttClient::ConnectionCb(const mqtt_connection_status_t& status) {
     for (auto& sub : subscriptions_) {
       sub->is_subscribed = !sub->want_subscribed;
     }
-    WithBackoff(connect_failures_, [this] { Connect(); });
+    RetryConnect();
   }
 }
 
+void MqttClient::RetryConnect() {
+  connect_retry_ = WithBackoff(
+      connect_failures_, [](MqttClient& client, Subscription*) {
+        client.Connect();
+      });
+  if (connect_retry_) return;
+  // Nothing else would ever reconnect us, so fall back to lwIP's own
+  // timeouts, at the longest backoff. The caller is in the tcpip thread or
+  // holds its lock, as sys_timeout requires.
+  sys_timeout(kMaxBackoffMs, &MqttClient::ConnectTimeout, this);
+}
+
+void MqttClient::ConnectTimeout(void* arg) {
+  static_cast<MqttClient*>(arg)->Connect();
+}
+
 void MqttClient::Connect() {
   LOCK_TCPIP_CORE();
   mqtt_connect_client_info_t connect_info{
@@ -100,22 +146,47 @@ void MqttClient::Connect() {
       },
       this,
       &connect_info);
-  if (err != ERR_OK) {
-    WithBackoff(connect_failures_, [this] { Connect(); });
-  }
+  if (err != ERR_OK) RetryConnect();
   UNLOCK_TCPIP_CORE();
 }
 
 err_t MqttClient::Publish(
     std::string_view topic, std::string_view message, Qos qos, bool retain,
     std::function<void(err_t)> publish_result) {
-  struct PublishCbData {
-    std::function<void(err_t)> fn;
+  // An empty std::function would make a move_only_function that is not
+  // empty, but throws when called.
+  if (publish_result == nullptr) {
+    return PublishWithCallback(topic, message, qos, retain, nullptr);
+  }
+  return PublishWithCallback(
+      topic, message, qos, retain, std::move(publish_result));
+}
+
+freertosxx::Future<err_t> MqttClient::Publish(
+    std::string_view topic, std::string_view message, Qos qos, bool retain,
+    freertosxx::UseFuture) {
+  freertosxx::Promise<err_t> promise;
+  freertosxx::Future<err_t> result = promise.GetFuture();
+  const err_t err = PublishWithCallback(
+      topic,
+      message,
+      qos,
+      retain,
+      [promise = std::move(promise)](err_t err) mutable { promise.Set(err); });
+  if (err != ERR_OK) return freertosxx::MakeReadyFuture(err);
+  return result;
+}
+
+err_t MqttClient::PublishWithCallback(
+    std::string_view topic, std::string_view message, Qos qos, bool retain,
+    std::move_only_function<void(err_t)> publish_result) {
+  struct PublishCbData : PoolAllocated<g_callback_pools> {
+    std::move_only_function<void(err_t)> fn;
   };
 
   PublishCbData* cb_data = nullptr;
   if (publish_result != nullptr) {
-    cb_data = new PublishCbData(PublishCbData{publish_result});
+    cb_data = new PublishCbData{{}, std::move(publish_result)};
   }
 
   LOCK_TCPIP_CORE();
@@ -204,12 +275,12 @@ err_t MqttClient::StartTransition(
     return ERR_OK;
   }
 
-  struct TransitionArg {
+  struct TransitionArg : PoolAllocated<g_callback_pools> {
     MqttClient& client;
     Subscription& sub;
     bool is_subscribe;
   };
-  auto cb_arg = new TransitionArg{*this, sub, sub.want_subscribed};
+  auto cb_arg = new TransitionArg{{}, *this, sub, sub.want_subscribed};
 
   mqtt_request_cb_t cb = +[](void* varg, err_t err) {
     std::unique_ptr<TransitionArg> arg(static_cast<TransitionArg*>(varg));
@@ -247,10 +318,17 @@ void MqttClient::FinishTransition(
   // If an error occurred either in this callback or in starting the next
   // transition, instead retry the next transition with a backoff.
   sub.has_pending_callback = true;
-  WithBackoff(sub.failed_requests, [this, &sub = sub] {
-    sub.has_pending_callback = false;
-    StartTransition(sub, kRetryAllErrors);
-  });
+  sub.retry = WithBackoff(
+      sub.failed_requests,
+      [](MqttClient& client, Subscription* sub) {
+        sub->has_pending_callback = false;
+        client.StartTransition(*sub, kRetryAllErrors);
+      },
+      &sub);
+  // Out of timers. Leave the subscription idle rather than pending forever,
+  // so that the next reconnect, or Subscribe or Unsubscribe on its topic,
+  // retries it.
+  if (!sub.retry) sub.has_pending_callback = false;
 }
 
 template <int min_ms, int max_ms>
@@ -264,22 +342,26 @@ TickType_t Backoff(int& attempts) {
   return ret;
 }
 
-void MqttClient::WithBackoff(int& failed_attempts, std::function<void()> f) {
-  struct Arg {
+TimerToken MqttClient::WithBackoff(
+    int& failed_attempts, Retry retry, Subscription* sub) {
+  // The retry holds the flag as well as the client, so that it can tell
+  // whether the client is gone once it has the lock. Capturing only a
+  // pointer to its arguments lets the timer keep the callback in place.
+  struct RetryArg : PoolAllocated<g_callback_pools> {
+    std::shared_ptr<bool> shutdown;
     MqttClient& client;
-    std::function<void()> f;
-  };
-  auto pend_cb = +[](void* varg, uint32_t unused_arg) {
-    std::unique_ptr<Arg> arg(static_cast<Arg*>(varg));
-    LOCK_TCPIP_CORE();
-    auto cleanup = jagspico::Cleanup([&] { UNLOCK_TCPIP_CORE(); });
-    arg->f();
+    Retry retry;
+    Subscription* sub;
   };
-  xTimerPendFunctionCall(
-      pend_cb,
-      new Arg{*this, std::move(f)},
-      0,
-      Backoff<250, 5000>(failed_attempts));
+  TimerToken token = freertosxx::DefaultTimerWheel().Schedule(
+      Backoff<kMinBackoffMs, kMaxBackoffMs>(failed_attempts),
+      [arg = std::unique_ptr<RetryArg>(
+           new RetryArg{{}, shutdown_, *this, retry, sub})] {
+        if (!*arg->shutdown) arg->retry(arg->client, arg->sub);
+      },
+      &LockingTcpipCore);
+  if (!token) printf("mqtt: no timer free to schedule a retry\n");
+  return token;
 }
 
 bool MqttClient::TopicMatchesSubscription(
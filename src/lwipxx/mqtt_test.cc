@@ -3,14 +3,17 @@
 #include "lwipxx/mqtt.h"
 
 #include <cstdio>
+#include <optional>
 
+#include "freertosxx/future.h"
+#include "freertosxx/notify.h"
 #include "lwip/err.h"
 #include "pico/platform.h"
 #include "pico/time.h"
 #include "projdefs.h"
 #include "util/include/util/ssprintf.h"
 
-using freertosxx::EventGroup;
+using freertosxx::Notifier;
 using jagspico::ssprintf;
 using lwipxx::MqttClient;
 
@@ -31,7 +34,8 @@ extern "C" void main_task(void* args) {
   auto c1 = *lwipxx::MqttClient::Create(CommonConnectInfo(1));
   auto c2 = *lwipxx::MqttClient::Create(CommonConnectInfo(2));
 
-  EventGroup evt;
+  // Bound to this task; the handlers run on the tcpip thread.
+  Notifier evt;
   if (ERR_OK != c2->Subscribe(
                     "/lwipxx_test/chan1",
                     MqttClient::Qos::kAtLeastOnce,
@@ -68,6 +72,18 @@ extern "C" void main_task(void* args) {
     panic("chan1 publish failed!\n");
   };
   evt.Wait(1, {.clear = true});
+
+  // The broker acknowledges a QoS 1 publish, which completes its future.
+  std::optional<err_t> acked =
+      c1->Publish(
+            "/lwipxx_test/future",
+            "acked",
+            MqttClient::Qos::kAtLeastOnce,
+            false,
+            freertosxx::use_future)
+          .Get({.timeout = pdMS_TO_TICKS(2500)});
+  if (acked != ERR_OK) panic("publish with future failed\n");
+
   if (ERR_OK != c2->Unsubscribe("/lwipxx_test/chan1")) {
     panic("unsub failed\n");
   }
@@ -0,0 +1,47 @@
+#ifndef JAGSPICO_PIOSIM_CD74HC595_CHAIN_H
+#define JAGSPICO_PIOSIM_CD74HC595_CHAIN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace piosim {
+
+// Shift and storage registers of a chain of Cd74Hc595s, for tests that
+// drive it from a StateMachine's pins, as one bit per output: 0 is qa of the
+// first chip, the one whose ser is driven.
+struct Cd74Hc595Chain {
+  Cd74Hc595Chain(int bits, int pin_srclk, int pin_ser)
+      : shift(bits), storage(bits), pin_srclk(pin_srclk), pin_ser(pin_ser) {}
+
+  // Updates the registers from the pins' levels after a cycle. rclk is the
+  // pin after srclk.
+  void Clock(uint32_t pins) {
+    const bool srclk = pins >> pin_srclk & 1;
+    const bool rclk = pins >> (pin_srclk + 1) & 1;
+    if (srclk && !previous_srclk) {
+      for (size_t i = shift.size() - 1; i > 0; --i) shift[i] = shift[i - 1];
+      shift[0] = pins >> pin_ser & 1;
+      ++shifts;
+    }
+    if (rclk && !previous_rclk) {
+      storage = shift;
+      ++latches;
+    }
+    previous_srclk = srclk;
+    previous_rclk = rclk;
+  }
+
+  std::vector<bool> shift;
+  std::vector<bool> storage;
+  int pin_srclk;
+  int pin_ser;
+  bool previous_srclk = false;
+  bool previous_rclk = false;
+  int shifts = 0;
+  int latches = 0;
+};
+
+}  // namespace piosim
+
+#endif  // JAGSPICO_PIOSIM_CD74HC595_CHAIN_H
@@ -0,0 +1,176 @@
+#ifndef PIOSIM_STATE_MACHINE_H
+#define PIOSIM_STATE_MACHINE_H
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <span>
+
+#include "piosim/waveform.h"
+
+namespace piosim {
+
+// A model of one RP2040 PIO state machine, for host tests of PIO programs
+// and the drivers that feed them. It runs the program as assembled by
+// pioasm, one instruction per Step, following chapter 3 of the RP2040
+// datasheet: side-set and delay, stalls, autopull and autopush, both shift
+// directions, wrap, FIFO joining, and the fractional clock divider, which
+// Tick runs Step through. Not modelled: the other state machines, except as
+// sources of IRQ flags the test sets, pindirs (every pin reads back what
+// was last written to it), and STATUS.
+//
+//   piosim::StateMachine sm({
+//       .program = my_program_instructions,
+//       .wrap_target = my_program_wrap_target,
+//       .wrap = my_program_wrap,
+//       .sideset_count = 1,
+//       ...
+//   });
+//   piosim::Waveform waveform(0b11);
+//   sm.Record(&waveform);
+//   sm.Put(0x1234);
+//   for (int i = 0; i < 1000; ++i) sm.Tick();
+class StateMachine {
+ public:
+  // The parts of a pio_sm_config that the model uses, with the SDK's
+  // defaults. The program is loaded at offset 0, which is how pioasm
+  // assembles it.
+  struct Config {
+    std::span<const uint16_t> program;
+    int wrap_target = 0;
+    int wrap = 31;
+
+    // Includes the enable bit if sideset_optional.
+    int sideset_count = 0;
+    bool sideset_optional = false;
+    int sideset_base = 0;
+
+    int out_base = 0;
+    int out_count = 32;
+    int set_base = 0;
+    int set_count = 5;
+    int in_base = 0;
+    int jmp_pin = 0;
+
+    bool out_shift_right = true;
+    bool autopull = false;
+    int pull_threshold = 32;
+    bool in_shift_right = true;
+    bool autopush = false;
+    int push_threshold = 32;
+
+    // Gives the TX FIFO all 8 entries, or the RX FIFO, like
+    // PIO_FIFO_JOIN_TX and PIO_FIFO_JOIN_RX.
+    bool join_tx = false;
+    bool join_rx = false;
+
+    // System clocks per state machine cycle, as for sm_config_set_clkdiv:
+    // 1 to 65536, in steps of 1/256.
+    float clkdiv = 1.0f;
+  };
+
+  explicit StateMachine(const Config& config);
+
+  // Writes a word to the TX FIFO. Returns false if it is full.
+  bool Put(uint32_t word);
+  // Reads a word from the RX FIFO, if there is one.
+  std::optional<uint32_t> Get();
+
+  // Executes instr right away, like pio_sm_exec. If it stalls, Step retries
+  // it before fetching anything else.
+  void Exec(uint16_t instr);
+
+  // Runs one clock cycle: one instruction, or one cycle of a delay or stall.
+  void Step();
+
+  // Runs one system clock cycle, which runs Step if the clock divider lets
+  // it, and records the pins. Returns whether it ran Step.
+  bool Tick();
+
+  // Records the pins after every Tick into waveform, or stops recording if
+  // it is null.
+  void Record(Waveform* waveform);
+
+  // The level of every pin, as last driven by the program or SetInput.
+  uint32_t pins() const { return pins_; }
+  bool pin(int pin) const { return (pins_ >> pin) & 1; }
+  // Drives a pin from outside, for WAIT, IN and JMP PIN.
+  void SetInput(int pin, bool value);
+
+  // The IRQ flags shared by the PIO block's state machines.
+  uint8_t irq() const { return irq_; }
+  void SetIrq(int index, bool value);
+
+  int pc() const { return pc_; }
+  uint32_t x() const { return x_; }
+  uint32_t y() const { return y_; }
+  size_t tx_level() const { return tx_.size(); }
+  size_t rx_level() const { return rx_.size(); }
+  // Whether the last Step stalled, e.g. on an empty TX FIFO.
+  bool stalled() const { return stalled_; }
+  // State machine cycles, i.e. Steps, and system clock cycles, i.e. Ticks.
+  uint64_t cycles() const { return cycles_; }
+  uint64_t sys_cycles() const { return sys_cycles_; }
+
+ private:
+  enum class Result { kDone, kJumped, kStalled };
+
+  // Runs instr, which is at pc_ unless it was exec'd.
+  Result Execute(uint16_t instr);
+  // Runs instr and then advances the program counter and starts the delay.
+  void Run(uint16_t instr, bool exec);
+  void ApplySideSet(uint16_t instr);
+  int Delay(uint16_t instr) const;
+
+  void WritePins(int base, int count, uint32_t value);
+  uint32_t ReadPins() const;
+
+  // Takes n bits from the OSR, as OUT does.
+  uint32_t ShiftOut(int n);
+  // Puts n bits into the ISR, as IN does.
+  void ShiftIn(uint32_t data, int n);
+  // Refills the OSR from the TX FIFO if autopull is due and possible.
+  void MaybeAutopull();
+  bool AutopullStall() const;
+
+  size_t tx_depth() const;
+  size_t rx_depth() const;
+
+  Config config_;
+  uint16_t program_[32] = {};
+
+  int pc_;
+  uint32_t x_ = 0;
+  uint32_t y_ = 0;
+  uint32_t osr_ = 0;
+  // Bits shifted out of the OSR since it was last filled; 32 is empty.
+  int osr_count_ = 32;
+  uint32_t isr_ = 0;
+  // Bits shifted into the ISR since it was last emptied.
+  int isr_count_ = 0;
+  std::deque<uint32_t> tx_;
+  std::deque<uint32_t> rx_;
+
+  uint32_t pins_ = 0;
+  uint8_t irq_ = 0;
+  // Whether a stalled IRQ WAIT has set its flag.
+  bool irq_wait_raised_ = false;
+
+  // An exec'd instruction waiting to run, e.g. because it stalled, and any
+  // instruction OUT EXEC or MOV EXEC produced.
+  std::optional<uint16_t> pending_exec_;
+  int delay_ = 0;
+  bool stalled_ = false;
+  uint64_t cycles_ = 0;
+
+  // The divider in 1/256ths of a system clock, and how far the current
+  // state machine cycle has got in the same units.
+  uint32_t divider_;
+  uint32_t divider_phase_ = 0;
+  uint64_t sys_cycles_ = 0;
+  Waveform* waveform_ = nullptr;
+};
+
+}  // namespace piosim
+
+#endif  // PIOSIM_STATE_MACHINE_H
@@ -0,0 +1,52 @@
+#ifndef PIOSIM_WAVEFORM_H
+#define PIOSIM_WAVEFORM_H
+
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <vector>
+
+namespace piosim {
+
+// The levels of a set of pins over time, as a list of changes, for tests to
+// check timing against and for viewing in a VCD viewer such as GTKWave.
+// Times are in system clock cycles.
+class Waveform {
+ public:
+  struct Change {
+    uint64_t time;
+    // Every pin's level from time on; only the pins in the mask matter.
+    uint32_t pins;
+  };
+
+  // Records the pins in mask.
+  explicit Waveform(uint32_t mask) : mask_(mask) {}
+
+  // Records the pins' levels at time, if any of them changed.
+  void Record(uint64_t time, uint32_t pins);
+
+  std::span<const Change> changes() const { return changes_; }
+
+  // The level of pin at time, or false before the first record.
+  bool Level(int pin, uint64_t time) const;
+
+  // The times at which pin rose, or fell.
+  std::vector<uint64_t> Edges(int pin, bool rising) const;
+
+  struct Signal {
+    int pin;
+    const char* name;
+  };
+  // Writes the signals as a VCD file, where a system clock cycle lasts
+  // ns_per_cycle, e.g. 8 at 125 MHz.
+  void WriteVcd(FILE* file, std::span<const Signal> signals,
+                uint32_t ns_per_cycle) const;
+
+ private:
+  uint32_t mask_;
+  std::vector<Change> changes_;
+};
+
+}  // namespace piosim
+
+#endif  // PIOSIM_WAVEFORM_H
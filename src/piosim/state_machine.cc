@@ -0,0 +1,420 @@
+#include "piosim/state_machine.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <cstdlib>
+
+namespace piosim {
+
+namespace {
+
+enum Opcode : uint16_t {
+  kJmp = 0,
+  kWait = 1,
+  kIn = 2,
+  kOut = 3,
+  kPushPull = 4,
+  kMov = 5,
+  kIrq = 6,
+  kSet = 7,
+};
+
+// Sources and destinations, as encoded in the instructions that use them.
+enum Operand : uint16_t {
+  kPins = 0,
+  kX = 1,
+  kY = 2,
+  kNull = 3,
+  kPindirs = 4,
+  kMovExec = 4,
+  kPc = 5,
+  kStatus = 5,
+  kIsr = 6,
+  kOsr = 7,
+  kOutExec = 7,
+};
+
+uint32_t Mask(int bits) { return bits >= 32 ? ~0u : (1u << bits) - 1; }
+
+uint32_t BitReverse(uint32_t x) {
+  uint32_t reversed = 0;
+  for (int i = 0; i < 32; ++i) reversed |= (x >> i & 1) << (31 - i);
+  return reversed;
+}
+
+// A bit count of 0 means 32.
+int BitCount(uint16_t instr) {
+  const int n = instr & 0x1f;
+  return n == 0 ? 32 : n;
+}
+
+[[noreturn]] void Unsupported(const char* what, uint16_t instr) {
+  fprintf(stderr, "piosim: unsupported %s in %04x\n", what, instr);
+  abort();
+}
+
+}  // namespace
+
+StateMachine::StateMachine(const Config& config)
+    : config_(config), pc_(config.wrap_target) {
+  if (config.program.size() > std::size(program_)) {
+    Unsupported("program size", config.program.size());
+  }
+  std::ranges::copy(config.program, program_);
+
+  // Truncated to the hardware's 16.8 fixed point the way the SDK does it,
+  // where an integer part of 0 means 65536.
+  const uint32_t integer = static_cast<uint16_t>(config.clkdiv);
+  const uint32_t fraction =
+      static_cast<uint8_t>((config.clkdiv - integer) * 256);
+  divider_ = ((integer == 0 ? 65536 : integer) << 8) | fraction;
+}
+
+bool StateMachine::Put(uint32_t word) {
+  if (tx_.size() >= tx_depth()) return false;
+  tx_.push_back(word);
+  return true;
+}
+
+std::optional<uint32_t> StateMachine::Get() {
+  if (rx_.empty()) return std::nullopt;
+  const uint32_t word = rx_.front();
+  rx_.pop_front();
+  return word;
+}
+
+void StateMachine::Exec(uint16_t instr) { Run(instr, true); }
+
+void StateMachine::Step() {
+  ++cycles_;
+  if (delay_ > 0) {
+    --delay_;
+    stalled_ = false;
+    return;
+  }
+  if (pending_exec_) {
+    Run(*pending_exec_, true);
+  } else {
+    Run(program_[pc_], false);
+  }
+}
+
+bool StateMachine::Tick() {
+  ++sys_cycles_;
+  // The state machine runs once every divider_ / 256 system clocks on
+  // average: on the clocks where the phase wraps around.
+  divider_phase_ += 256;
+  const bool step = divider_phase_ >= divider_;
+  if (step) {
+    divider_phase_ -= divider_;
+    Step();
+  }
+  if (waveform_ != nullptr) waveform_->Record(sys_cycles_, pins_);
+  return step;
+}
+
+void StateMachine::Record(Waveform* waveform) {
+  waveform_ = waveform;
+  if (waveform_ != nullptr) waveform_->Record(sys_cycles_, pins_);
+}
+
+void StateMachine::SetInput(int pin, bool value) {
+  pins_ = (pins_ & ~(1u << pin)) | (uint32_t{value} << pin);
+}
+
+void StateMachine::SetIrq(int index, bool value) {
+  irq_ = (irq_ & ~(1u << index)) | (value << index);
+}
+
+void StateMachine::Run(uint16_t instr, bool exec) {
+  // Side-set happens as the instruction is issued, even if it then stalls.
+  ApplySideSet(instr);
+  if (exec) pending_exec_.reset();
+  const Result result = Execute(instr);
+  if (result == Result::kStalled) {
+    stalled_ = true;
+    if (exec) pending_exec_ = instr;
+    return;
+  }
+  stalled_ = false;
+  if (result == Result::kDone && !exec) {
+    pc_ = pc_ == config_.wrap ? config_.wrap_target : (pc_ + 1) % 32;
+  }
+  // The delay only starts once the instruction completes.
+  delay_ = Delay(instr);
+}
+
+void StateMachine::ApplySideSet(uint16_t instr) {
+  const int count = config_.sideset_count;
+  if (count == 0) return;
+  const uint32_t bits = (instr >> 8 & 0x1f) >> (5 - count);
+  if (config_.sideset_optional) {
+    if ((bits >> (count - 1) & 1) == 0) return;
+    WritePins(config_.sideset_base, count - 1, bits);
+  } else {
+    WritePins(config_.sideset_base, count, bits);
+  }
+}
+
+int StateMachine::Delay(uint16_t instr) const {
+  return (instr >> 8) & Mask(5 - config_.sideset_count);
+}
+
+StateMachine::Result StateMachine::Execute(uint16_t instr) {
+  const uint16_t opcode = instr >> 13;
+  const uint16_t operand = (instr >> 5) & 0x7;
+  switch (opcode) {
+    case kJmp: {
+      bool jump;
+      switch (operand) {
+        case 0: jump = true; break;
+        case 1: jump = x_ == 0; break;
+        case 2: jump = x_-- != 0; break;
+        case 3: jump = y_ == 0; break;
+        case 4: jump = y_-- != 0; break;
+        case 5: jump = x_ != y_; break;
+        case 6: jump = pin(config_.jmp_pin); break;
+        default: jump = osr_count_ < config_.pull_threshold; break;
+      }
+      if (!jump) return Result::kDone;
+      pc_ = instr & 0x1f;
+      return Result::kJumped;
+    }
+
+    case kWait: {
+      const bool polarity = instr >> 7 & 1;
+      const int index = instr & 0x1f;
+      bool level;
+      switch (instr >> 5 & 0x3) {
+        case 0: level = pin(index); break;
+        case 1: level = pin((config_.in_base + index) % 32); break;
+        case 2: level = irq_ >> (index & 0x7) & 1; break;
+        default: Unsupported("wait source", instr);
+      }
+      if (level != polarity) return Result::kStalled;
+      // Waiting for an IRQ flag to be set clears it.
+      if ((instr >> 5 & 0x3) == 2 && polarity) SetIrq(index & 0x7, false);
+      return Result::kDone;
+    }
+
+    case kIn: {
+      const int n = BitCount(instr);
+      if (config_.autopush && isr_count_ >= config_.push_threshold &&
+          rx_.size() >= rx_depth()) {
+        return Result::kStalled;
+      }
+      uint32_t data;
+      switch (operand) {
+        case kPins: data = ReadPins(); break;
+        case kX: data = x_; break;
+        case kY: data = y_; break;
+        case kNull: data = 0; break;
+        case kIsr: data = isr_; break;
+        case kOsr: data = osr_; break;
+        default: Unsupported("in source", instr);
+      }
+      ShiftIn(data & Mask(n), n);
+      if (config_.autopush && isr_count_ >= config_.push_threshold &&
+          rx_.size() < rx_depth()) {
+        rx_.push_back(isr_);
+        isr_ = 0;
+        isr_count_ = 0;
+      }
+      return Result::kDone;
+    }
+
+    case kOut: {
+      if (AutopullStall()) return Result::kStalled;
+      MaybeAutopull();
+      const int n = BitCount(instr);
+      const uint32_t data = ShiftOut(n);
+      Result result = Result::kDone;
+      switch (operand) {
+        case kPins: WritePins(config_.out_base, config_.out_count, data); break;
+        case kX: x_ = data; break;
+        case kY: y_ = data; break;
+        case kNull: break;
+        case kPindirs: break;
+        case kPc:
+          pc_ = data & 0x1f;
+          result = Result::kJumped;
+          break;
+        case kIsr:
+          isr_ = data;
+          isr_count_ = n;
+          break;
+        case kOutExec:
+          // Runs on the next cycle, in place of the next instruction.
+          pending_exec_ = data;
+          break;
+      }
+      // The OSR refills in the background once it reaches the threshold.
+      MaybeAutopull();
+      return result;
+    }
+
+    case kPushPull: {
+      const bool if_flag = instr >> 6 & 1;
+      const bool block = instr >> 5 & 1;
+      if (instr >> 7 & 1) {
+        if (if_flag && osr_count_ < config_.pull_threshold) {
+          return Result::kDone;
+        }
+        if (tx_.empty()) {
+          if (block) return Result::kStalled;
+          osr_ = x_;
+        } else {
+          osr_ = tx_.front();
+          tx_.pop_front();
+        }
+        osr_count_ = 0;
+      } else {
+        if (if_flag && isr_count_ < config_.push_threshold) {
+          return Result::kDone;
+        }
+        if (rx_.size() >= rx_depth()) {
+          if (block) return Result::kStalled;
+        } else {
+          rx_.push_back(isr_);
+        }
+        isr_ = 0;
+        isr_count_ = 0;
+      }
+      return Result::kDone;
+    }
+
+    case kMov: {
+      uint32_t data;
+      switch (instr & 0x7) {
+        case kPins: data = ReadPins(); break;
+        case kX: data = x_; break;
+        case kY: data = y_; break;
+        case kNull: data = 0; break;
+        case kIsr: data = isr_; break;
+        case kOsr: data = osr_; break;
+        default: Unsupported("mov source", instr);
+      }
+      switch (instr >> 3 & 0x3) {
+        case 0: break;
+        case 1: data = ~data; break;
+        case 2: data = BitReverse(data); break;
+        default: Unsupported("mov operation", instr);
+      }
+      switch (operand) {
+        case kPins: WritePins(config_.out_base, config_.out_count, data); break;
+        case kX: x_ = data; break;
+        case kY: y_ = data; break;
+        case kMovExec:
+          pending_exec_ = data;
+          break;
+        case kPc:
+          pc_ = data & 0x1f;
+          return Result::kJumped;
+        case kIsr:
+          isr_ = data;
+          isr_count_ = 0;
+          break;
+        case kOsr:
+          osr_ = data;
+          osr_count_ = 0;
+          break;
+        default: Unsupported("mov destination", instr);
+      }
+      return Result::kDone;
+    }
+
+    case kIrq: {
+      const int index = instr & 0x7;
+      if (instr >> 6 & 1) {
+        SetIrq(index, false);
+        return Result::kDone;
+      }
+      if (!(instr >> 5 & 1)) {
+        SetIrq(index, true);
+        return Result::kDone;
+      }
+      // IRQ WAIT sets the flag once, then stalls until it is cleared.
+      if (!irq_wait_raised_) {
+        SetIrq(index, true);
+        irq_wait_raised_ = true;
+      }
+      if (irq_ >> index & 1) return Result::kStalled;
+      irq_wait_raised_ = false;
+      return Result::kDone;
+    }
+
+    case kSet: {
+      const uint32_t data = instr & 0x1f;
+      switch (operand) {
+        case kPins: WritePins(config_.set_base, config_.set_count, data); break;
+        case kX: x_ = data; break;
+        case kY: y_ = data; break;
+        case kPindirs: break;
+        default: Unsupported("set destination", instr);
+      }
+      return Result::kDone;
+    }
+  }
+  Unsupported("opcode", instr);
+}
+
+void StateMachine::WritePins(int base, int count, uint32_t value) {
+  for (int i = 0; i < count; ++i) {
+    const int pin = (base + i) % 32;
+    pins_ = (pins_ & ~(1u << pin)) | ((value >> i & 1) << pin);
+  }
+}
+
+uint32_t StateMachine::ReadPins() const {
+  return std::rotr(pins_, config_.in_base);
+}
+
+uint32_t StateMachine::ShiftOut(int n) {
+  uint32_t data;
+  if (config_.out_shift_right) {
+    data = osr_ & Mask(n);
+    osr_ = n >= 32 ? 0 : osr_ >> n;
+  } else {
+    data = n >= 32 ? osr_ : osr_ >> (32 - n);
+    osr_ = n >= 32 ? 0 : osr_ << n;
+  }
+  osr_count_ = std::min(32, osr_count_ + n);
+  return data;
+}
+
+void StateMachine::ShiftIn(uint32_t data, int n) {
+  if (n >= 32) {
+    isr_ = data;
+  } else if (config_.in_shift_right) {
+    isr_ = (isr_ >> n) | (data << (32 - n));
+  } else {
+    isr_ = (isr_ << n) | data;
+  }
+  isr_count_ = std::min(32, isr_count_ + n);
+}
+
+bool StateMachine::AutopullStall() const {
+  return config_.autopull && osr_count_ >= config_.pull_threshold &&
+         tx_.empty();
+}
+
+void StateMachine::MaybeAutopull() {
+  if (!config_.autopull || osr_count_ < config_.pull_threshold ||
+      tx_.empty()) {
+    return;
+  }
+  osr_ = tx_.front();
+  tx_.pop_front();
+  osr_count_ = 0;
+}
+
+size_t StateMachine::tx_depth() const {
+  return config_.join_tx ? 8 : config_.join_rx ? 0 : 4;
+}
+
+size_t StateMachine::rx_depth() const {
+  return config_.join_rx ? 8 : config_.join_tx ? 0 : 4;
+}
+
+}  // namespace piosim
@@ -0,0 +1,57 @@
+#include "piosim/waveform.h"
+
+#include <algorithm>
+#include <cinttypes>
+
+namespace piosim {
+
+void Waveform::Record(uint64_t time, uint32_t pins) {
+  if (!changes_.empty() &&
+      ((changes_.back().pins ^ pins) & mask_) == 0) {
+    return;
+  }
+  changes_.push_back({time, pins});
+}
+
+bool Waveform::Level(int pin, uint64_t time) const {
+  // The last change at or before time.
+  const auto it = std::ranges::upper_bound(changes_, time, {}, &Change::time);
+  if (it == changes_.begin()) return false;
+  return std::prev(it)->pins >> pin & 1;
+}
+
+std::vector<uint64_t> Waveform::Edges(int pin, bool rising) const {
+  std::vector<uint64_t> edges;
+  bool level = false;
+  for (const Change& change : changes_) {
+    const bool now = change.pins >> pin & 1;
+    if (now != level && now == rising) edges.push_back(change.time);
+    level = now;
+  }
+  return edges;
+}
+
+void Waveform::WriteVcd(FILE* file, std::span<const Signal> signals,
+                        uint32_t ns_per_cycle) const {
+  fprintf(file, "$timescale 1ns $end\n$scope module pio $end\n");
+  for (size_t i = 0; i < signals.size(); ++i) {
+    fprintf(file, "$var wire 1 %c %s $end\n", static_cast<char>('!' + i),
+            signals[i].name);
+  }
+  fprintf(file, "$upscope $end\n$enddefinitions $end\n");
+  uint32_t previous = 0;
+  for (size_t c = 0; c < changes_.size(); ++c) {
+    const Change& change = changes_[c];
+    fprintf(file, "#%" PRIu64 "\n", change.time * ns_per_cycle);
+    for (size_t i = 0; i < signals.size(); ++i) {
+      const uint32_t bit = 1u << signals[i].pin;
+      if (c == 0 || ((change.pins ^ previous) & bit)) {
+        fprintf(file, "%d%c\n", (change.pins & bit) ? 1 : 0,
+                static_cast<char>('!' + i));
+      }
+    }
+    previous = change.pins;
+  }
+}
+
+}  // namespace piosim
@@ -0,0 +1,42 @@
+#ifndef JAGSPICO_FREERTOS_CONFIG_H
+#define JAGSPICO_FREERTOS_CONFIG_H
+
+// Wraps picobase's FreeRTOS config with the settings that freertosxx needs.
+// shared_init puts this directory ahead of picobase's on freertos_config's
+// include path, so the kernel is built with these too.
+#include_next <FreeRTOSConfig.h>
+
+// Stream and message buffers use index 0, freertosxx's signals the last one
+// and its futures the one before, which leaves one for a task to bind more
+// signals to. See notify.h.
+#undef configTASK_NOTIFICATION_ARRAY_ENTRIES
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES 4
+
+// Per-task CPU use and context switch counts for freertosxx's CpuMonitor,
+// timed by the RP2040's 64-bit microsecond timer. See runtime_stats.h.
+#undef configUSE_TRACE_FACILITY
+#define configUSE_TRACE_FACILITY 1
+#undef configGENERATE_RUN_TIME_STATS
+#define configGENERATE_RUN_TIME_STATS 1
+#undef configRUN_TIME_COUNTER_TYPE
+#define configRUN_TIME_COUNTER_TYPE uint64_t
+#undef portCONFIGURE_TIMER_FOR_RUN_TIME_STATS
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#undef portGET_RUN_TIME_COUNTER_VALUE
+#define portGET_RUN_TIME_COUNTER_VALUE() FreertosxxRunTimeCounter()
+#undef traceTASK_SWITCHED_IN
+#define traceTASK_SWITCHED_IN() FreertosxxTaskSwitchedIn()
+
+#ifndef __ASSEMBLER__
+#include <stdint.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+uint64_t FreertosxxRunTimeCounter(void);
+void FreertosxxTaskSwitchedIn(void);
+#ifdef __cplusplus
+}
+#endif
+#endif
+
+#endif  // JAGSPICO_FREERTOS_CONFIG_H
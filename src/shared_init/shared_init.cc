@@ -3,6 +3,7 @@
 #include <FreeRTOS.h>
 
 #include "FreeRTOSConfig.h"
+#include "freertosxx/tasks.h"
 #include "hardware/watchdog.h"
 #include "pico/multicore.h"
 #include "pico/platform.h"
@@ -17,6 +18,9 @@
 #include "cyw43_ll.h"
 #include "pico/cyw43_arch.h"
 #endif
+#if CYW43_LWIP
+#include "lwip/tcpip.h"
+#endif
 
 #if LWIP_MDNS_RESPONDER
 #include "lwip/apps/mdns.h"
@@ -83,8 +87,6 @@ void MaybeSetupWatchdogOnTick() {
 }
 #endif
 
-static TaskHandle_t g_init_task;
-
 #if LWIP_MDNS_RESPONDER
 static void srv_txt(struct mdns_service *service, void *txt_userdata) {
   err_t res;
@@ -113,6 +115,9 @@ static void init_task(void *arg) {
   printf("wifi init done\n");
 #if CYW43_LWIP
   cyw43_arch_enable_sta_mode();
+  // Core 0 handles the network. Latency-sensitive tasks, like display
+  // refresh, run on core 1.
+  freertosxx::SetCoreAffinity(TCPIP_THREAD_NAME, freertosxx::kCore0);
   printf("will connect wifi\n");
   {
     int error;
@@ -150,9 +155,8 @@ static void init_task(void *arg) {
 int main(void) {
   stdio_init_all();
 
-  BaseType_t err =
-      xTaskCreate(init_task, "__init_task", 1024, NULL, 1, &g_init_task);
-  configASSERT(err == pdPASS);
+  static freertosxx::StaticTask<1024> init(
+      {.name = "__init_task"}, [] { init_task(nullptr); });
   vTaskStartScheduler();
 }
 }
\ No newline at end of file
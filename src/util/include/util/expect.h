@@ -0,0 +1,16 @@
+#ifndef JAGSPICO_EXPECT_H
+#define JAGSPICO_EXPECT_H
+
+#include "pico/platform.h"
+
+namespace jagspico {
+
+// For the on-target tests: fails the test, naming what, unless condition
+// holds.
+inline void Expect(bool condition, const char* what) {
+  if (!condition) panic("FAIL: %s", what);
+}
+
+}  // namespace jagspico
+
+#endif